@@ -8,6 +8,11 @@ fi
 
 ./bin/qjs ./octane/run.js
 
+# 扩展接口的性能基准，由 build.sh 构建，不在 ctest 中运行
+if [ -x ./build/extension_benchmark ]; then
+  ./build/extension_benchmark
+fi
+
 # echo "开始验证可执行文件..."
 # ./bin/qjsc -v -o ./octane.bin ./octane/run.js
 # ./octane.bin
@@ -0,0 +1,133 @@
+#include "QuickJS/extension/taro_js_type.h"
+
+#include <malloc.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "./settup.h"
+
+// 当前进程的常驻内存（KB）
+static long ResidentKB() {
+  long size = 0, resident = 0;
+  FILE* f = fopen("/proc/self/statm", "r");
+  if (!f)
+    return 0;
+  if (fscanf(f, "%ld %ld", &size, &resident) != 2)
+    resident = 0;
+  fclose(f);
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+struct LoadResult {
+  double ms;
+  int64_t malloc_kb;
+  long rss_kb;
+};
+
+// 在新的运行时中加载字节码并只初始化少量模块，模拟冷启动
+static LoadResult Load(const uint8_t* buf, size_t buf_len, int mode) {
+  const int flags = JS_READ_OBJ_BYTECODE | (mode ? JS_READ_OBJ_LAZY : 0);
+  long rss_before = ResidentKB();
+  auto start = std::chrono::steady_clock::now();
+  JSRuntime* r = JS_NewRuntime();
+  JSContext* c = JS_NewContext(r);
+  JSValue func = mode == 2
+      ? JS_ReadObject2(c, buf, buf_len, flags, NULL, NULL)
+      : JS_ReadObject(c, buf, buf_len, flags);
+  EXPECT_FALSE(taro_is_exception(func));
+  JSValue v = JS_EvalFunction(c, func);
+  EXPECT_FALSE(taro_is_exception(v));
+  JS_FreeValue(c, v);
+  v = EvalJS(c, "modules.m0().render() + modules.m1().render()");
+  EXPECT_FALSE(taro_is_exception(v));
+  JS_FreeValue(c, v);
+  auto end = std::chrono::steady_clock::now();
+
+  JSMemoryUsage usage;
+  JS_ComputeMemoryUsage(r, &usage);
+  LoadResult result = {
+      std::chrono::duration<double, std::milli>(end - start).count(),
+      usage.malloc_size / 1024,
+      ResidentKB() - rss_before};
+  JS_FreeContext(c);
+  JS_FreeRuntime(r);
+  return result;
+}
+
+// 在子进程中首次加载，常驻内存的增量不受之前加载的影响
+static long FirstLoadResidentKB(const uint8_t* buf, size_t buf_len, int mode) {
+  int fds[2];
+  long rss_kb = 0;
+  if (pipe(fds))
+    return 0;
+  pid_t pid = fork();
+  if (pid == 0) {
+    close(fds[0]);
+    malloc_trim(0);
+    rss_kb = Load(buf, buf_len, mode).rss_kb;
+    if (write(fds[1], &rss_kb, sizeof(rss_kb)) != sizeof(rss_kb))
+      _exit(1);
+    _exit(0);
+  }
+  close(fds[1]);
+  if (pid < 0 || read(fds[0], &rss_kb, sizeof(rss_kb)) != sizeof(rss_kb))
+    rss_kb = 0;
+  close(fds[0]);
+  if (pid > 0)
+    waitpid(pid, NULL, 0);
+  return rss_kb;
+}
+
+// 冷启动：立即解码 / 延迟解码（复制缓冲区）/ 延迟解码（借用缓冲区）
+TEST(TaroJSBytecodeBenchTest, ColdStart) {
+  const int iterations = 20;
+  std::string source = "var modules = {};";
+  for (int m = 0; m < 500; m++) {
+    std::string id = std::to_string(m);
+    source +=
+        "modules.m" + id + " = function () {"
+        "  function format(x) { return '[' + x + ']'; }"
+        "  function parse(s) { return s.split(',').map(function (x) { return +x; }); }"
+        "  function validate(o) {"
+        "    for (var k in o) if (o[k] === undefined) throw new Error(k);"
+        "    return true;"
+        "  }"
+        "  return {"
+        "    render: function () { return format(" + id + "); },"
+        "    parse: parse, validate: validate"
+        "  };"
+        "};";
+  }
+
+  JSValue func = JS_Eval(
+      ctx, source.c_str(), source.size(), "<cold>",
+      JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+  ASSERT_FALSE(taro_is_exception(func));
+  size_t bc_size = 0;
+  uint8_t* bc = JS_WriteObject(ctx, &bc_size, func, JS_WRITE_OBJ_BYTECODE);
+  JS_FreeValue(ctx, func);
+  ASSERT_TRUE(bc != nullptr);
+
+  static const char* names[] = {"eager", "lazy", "lazy borrowed"};
+  for (int mode = 0; mode < 3; mode++) {
+    LoadResult total = {0, 0, FirstLoadResidentKB(bc, bc_size, mode)};
+    for (int i = 0; i < iterations; i++) {
+      LoadResult r = Load(bc, bc_size, mode);
+      total.ms += r.ms;
+      total.malloc_kb = r.malloc_kb;
+    }
+    printf(
+        "[Bytecode] %.1f KB image, %s: %.3f ms, malloc %lld KB, "
+        "RSS +%ld KB\n",
+        bc_size / 1024.0,
+        names[mode],
+        total.ms / iterations,
+        (long long)total.malloc_kb,
+        total.rss_kb);
+  }
+  js_free(ctx, bc);
+}
@@ -0,0 +1,196 @@
+#include "QuickJS/extension/taro_js_type.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "./settup.h"
+
+// 顶层函数立即解码，内部函数在第一次调用时才解码
+static const char* kLazyScript =
+    "function add(a, b) { return a + b; }"
+    "function greet(name) {"
+    "  function wrap(s) { return '<' + s + '>'; }"
+    "  return wrap('hello ' + name);"
+    "}"
+    "function unused() { return 'unused'; }"
+    "var loaded = true;";
+
+static std::vector<uint8_t> CompileToBytecode(JSContext* c, const char* script) {
+  std::vector<uint8_t> out;
+  JSValue func = JS_Eval(
+      c, script, strlen(script), "<lazy>", JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+  EXPECT_FALSE(taro_is_exception(func));
+  size_t size = 0;
+  uint8_t* buf = JS_WriteObject(c, &size, func, JS_WRITE_OBJ_BYTECODE);
+  if (buf) {
+    out.assign(buf, buf + size);
+    js_free(c, buf);
+  }
+  JS_FreeValue(c, func);
+  return out;
+}
+
+static int free_func_count;
+
+static void CountingFree(JSRuntime* rt, void* opaque, void* ptr) {
+  EXPECT_EQ(ptr, opaque);
+  free_func_count++;
+}
+
+static std::string CallToString(JSContext* c, const char* expr) {
+  JSValue v = EvalJS(c, expr);
+  std::string result;
+  if (taro_is_exception(v)) {
+    JS_FreeValue(c, JS_GetException(c));
+    result = "<exception>";
+  } else {
+    result = JSToString(c, v);
+  }
+  JS_FreeValue(c, v);
+  return result;
+}
+
+// 借用的缓冲区：调用过的函数已解码，清零缓冲区后仍可调用
+TEST(TaroJSBytecodeTest, MaterializedOnFirstCall) {
+  JSContext* c = JS_NewContext(rt);
+  std::vector<uint8_t> buf = CompileToBytecode(c, kLazyScript);
+  ASSERT_FALSE(buf.empty());
+
+  free_func_count = 0;
+  JSValue func = JS_ReadObject2(
+      c, buf.data(), buf.size(), JS_READ_OBJ_BYTECODE | JS_READ_OBJ_LAZY,
+      CountingFree, buf.data());
+  ASSERT_FALSE(taro_is_exception(func));
+  JSValue ret = JS_EvalFunction(c, func);
+  ASSERT_FALSE(taro_is_exception(ret));
+  JS_FreeValue(c, ret);
+
+  EXPECT_EQ(CallToString(c, "String(add(1, 2))"), "3");
+  EXPECT_EQ(CallToString(c, "greet('js')"), "<hello js>");
+  EXPECT_EQ(free_func_count, 0);
+
+  memset(buf.data(), 0, buf.size());
+  EXPECT_EQ(CallToString(c, "String(add(3, 4))"), "7");
+  EXPECT_EQ(CallToString(c, "greet('again')"), "<hello again>");
+  EXPECT_EQ(free_func_count, 0);
+
+  // 最后一个引用缓冲区的函数释放后才调用 free_func，且只调用一次
+  JS_FreeContext(c);
+  JS_RunGC(rt);
+  EXPECT_EQ(free_func_count, 1);
+}
+
+// 读取后缓冲区被清零：未解码的函数调用时抛出异常而不崩溃
+TEST(TaroJSBytecodeTest, ZeroedBody) {
+  JSContext* c = JS_NewContext(rt);
+  std::vector<uint8_t> buf = CompileToBytecode(c, kLazyScript);
+  ASSERT_FALSE(buf.empty());
+
+  free_func_count = 0;
+  JSValue func = JS_ReadObject2(
+      c, buf.data(), buf.size(), JS_READ_OBJ_BYTECODE | JS_READ_OBJ_LAZY,
+      CountingFree, buf.data());
+  ASSERT_FALSE(taro_is_exception(func));
+  JSValue ret = JS_EvalFunction(c, func);
+  ASSERT_FALSE(taro_is_exception(ret));
+  JS_FreeValue(c, ret);
+
+  memset(buf.data(), 0, buf.size());
+  EXPECT_EQ(CallToString(c, "unused()"), "<exception>");
+  EXPECT_EQ(CallToString(c, "greet('x')"), "<exception>");
+  EXPECT_EQ(CallToString(c, "String(loaded)"), "true");
+
+  JS_FreeContext(c);
+  JS_RunGC(rt);
+  EXPECT_EQ(free_func_count, 1);
+}
+
+// 所有函数解码后缓冲区即被释放
+TEST(TaroJSBytecodeTest, ReleasedAfterAllMaterialized) {
+  JSContext* c = JS_NewContext(rt);
+  std::vector<uint8_t> buf = CompileToBytecode(c, kLazyScript);
+  ASSERT_FALSE(buf.empty());
+
+  free_func_count = 0;
+  JSValue func = JS_ReadObject2(
+      c, buf.data(), buf.size(), JS_READ_OBJ_BYTECODE | JS_READ_OBJ_LAZY,
+      CountingFree, buf.data());
+  ASSERT_FALSE(taro_is_exception(func));
+  JSValue ret = JS_EvalFunction(c, func);
+  ASSERT_FALSE(taro_is_exception(ret));
+  JS_FreeValue(c, ret);
+
+  EXPECT_EQ(CallToString(c, "add(1, 2) + greet('x') + unused()"), "3<hello x>unused");
+  EXPECT_EQ(free_func_count, 1);
+  memset(buf.data(), 0, buf.size());
+  EXPECT_EQ(CallToString(c, "add(1, 2) + greet('y') + unused()"), "3<hello y>unused");
+
+  JS_FreeContext(c);
+  JS_RunGC(rt);
+  EXPECT_EQ(free_func_count, 1);
+}
+
+// JS_ReadObject 复制缓冲区，调用方读取后即可释放自己的缓冲区
+TEST(TaroJSBytecodeTest, ReadObjectCopiesBuffer) {
+  JSContext* c = JS_NewContext(rt);
+  std::vector<uint8_t> bytecode = CompileToBytecode(c, kLazyScript);
+  ASSERT_FALSE(bytecode.empty());
+
+  uint8_t* buf = new uint8_t[bytecode.size()];
+  memcpy(buf, bytecode.data(), bytecode.size());
+  JSValue func = JS_ReadObject(
+      c, buf, bytecode.size(), JS_READ_OBJ_BYTECODE | JS_READ_OBJ_LAZY);
+  memset(buf, 0, bytecode.size());
+  delete[] buf;
+  ASSERT_FALSE(taro_is_exception(func));
+  JSValue ret = JS_EvalFunction(c, func);
+  ASSERT_FALSE(taro_is_exception(ret));
+  JS_FreeValue(c, ret);
+
+  EXPECT_EQ(CallToString(c, "add(1, 2) + greet('x') + unused()"), "3<hello x>unused");
+  JS_FreeContext(c);
+}
+
+// 截断的输入在任意长度都返回异常，借用时 free_func 也只调用一次
+TEST(TaroJSBytecodeTest, Truncated) {
+  JSContext* c = JS_NewContext(rt);
+  std::vector<uint8_t> bytecode = CompileToBytecode(c, kLazyScript);
+  ASSERT_FALSE(bytecode.empty());
+
+  for (size_t len = 0; len < bytecode.size(); len++) {
+    std::vector<uint8_t> buf(bytecode.begin(), bytecode.begin() + len);
+    JSValue func = JS_ReadObject(
+        c, buf.data(), len, JS_READ_OBJ_BYTECODE | JS_READ_OBJ_LAZY);
+    EXPECT_TRUE(taro_is_exception(func)) << "length " << len;
+    JS_FreeValue(c, func);
+    JS_FreeValue(c, JS_GetException(c));
+
+    free_func_count = 0;
+    func = JS_ReadObject2(
+        c, buf.data(), len, JS_READ_OBJ_BYTECODE | JS_READ_OBJ_LAZY,
+        CountingFree, buf.data());
+    EXPECT_TRUE(taro_is_exception(func)) << "length " << len;
+    JS_FreeValue(c, func);
+    JS_FreeValue(c, JS_GetException(c));
+    EXPECT_EQ(free_func_count, 1) << "length " << len;
+  }
+  JS_FreeContext(c);
+}
+
+// 版本不匹配的输入返回异常，借用时 free_func 也只调用一次
+TEST(TaroJSBytecodeTest, InvalidVersion) {
+  JSContext* c = JS_NewContext(rt);
+  std::vector<uint8_t> buf = CompileToBytecode(c, kLazyScript);
+  ASSERT_FALSE(buf.empty());
+  buf[0] ^= 0xff;
+
+  free_func_count = 0;
+  JSValue func = JS_ReadObject2(
+      c, buf.data(), buf.size(), JS_READ_OBJ_BYTECODE | JS_READ_OBJ_LAZY,
+      CountingFree, buf.data());
+  EXPECT_TRUE(taro_is_exception(func));
+  JS_FreeValue(c, JS_GetException(c));
+  EXPECT_EQ(free_func_count, 1);
+  JS_FreeContext(c);
+}
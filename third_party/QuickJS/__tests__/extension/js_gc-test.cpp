@@ -0,0 +1,183 @@
+#include "QuickJS/extension/taro_js_class.h"
+#include "QuickJS/extension/taro_js_type.h"
+
+#include "./settup.h"
+
+static int finalized_count;
+
+static void tracked_finalizer(JSRuntime* rt, JSValue val) {
+  finalized_count++;
+}
+
+static JSClassID tracked_class_id;
+
+static JSValue js_track(
+    JSContext* c,
+    JSValueConst this_val,
+    int argc,
+    JSValueConst* argv) {
+  return JS_NewObjectClass(c, tracked_class_id);
+}
+
+// 分代模式的运行时，track() 创建的对象被释放时计数
+static JSContext* NewGenerationalContext() {
+  static const JSClassDef tracked_class = {
+      .class_name = "Tracked",
+      .finalizer = tracked_finalizer,
+  };
+  JSRuntime* rt2 = JS_NewRuntime();
+  JSContext* c;
+  JSValue global;
+
+  if (tracked_class_id == 0)
+    taro_js_new_class_id(&tracked_class_id);
+  taro_js_new_class(rt2, tracked_class_id, &tracked_class);
+  JS_SetGCGenerational(rt2, true);
+  c = JS_NewContext(rt2);
+  global = JS_GetGlobalObject(c);
+  JS_SetPropertyStr(c, global, "track", JS_NewCFunction(c, js_track, "track", 0));
+  JS_FreeValue(c, global);
+  finalized_count = 0;
+  return c;
+}
+
+static void FreeGenerationalContext(JSContext* c) {
+  JSRuntime* rt2 = JS_GetRuntime(c);
+  JS_FreeContext(c);
+  JS_FreeRuntime(rt2);
+}
+
+static void RunScript(JSContext* c, const char* script) {
+  JSValue v = EvalJS(c, script);
+  EXPECT_FALSE(taro_is_exception(v)) << script;
+  JS_FreeValue(c, v);
+}
+
+// 只被新生代环引用的老对象随新生代回收一起释放
+TEST(TaroJSGCTest, OldObjectFreedByYoungCycle) {
+  JSContext* c = NewGenerationalContext();
+  JSRuntime* rt2 = JS_GetRuntime(c);
+
+  RunScript(c, "globalThis.oldObj = track();");
+  JS_RunGC(rt2);
+  RunScript(c,
+      "(function () {"
+      "  var a = {}, b = { a: a };"
+      "  a.b = b;"
+      "  a.old = oldObj;"
+      "})();"
+      "delete globalThis.oldObj;");
+  EXPECT_EQ(finalized_count, 0);
+
+  while (JS_RunGCStep(rt2, 1000000))
+    continue;
+  EXPECT_EQ(finalized_count, 1);
+
+  FreeGenerationalContext(c);
+}
+
+// 跨越多个分片的环：存活的环保持完整，垃圾环由完整回收释放
+TEST(TaroJSGCTest, CycleSpanningSlices) {
+  static const char* kMakeRing =
+      "function makeRing(n, tracked) {"
+      "  var head = { next: null, t: tracked ? track() : null }, node = head;"
+      "  for (var i = 0; i < n; i++) {"
+      "    node.next = { next: null, prev: node };"
+      "    node = node.next;"
+      "  }"
+      "  node.t = tracked ? track() : null;"
+      "  node.next = head;"
+      "  return head;"
+      "}"
+      "function ringLength(head) {"
+      "  var n = 1;"
+      "  for (var node = head.next; node !== head; node = node.next) n++;"
+      "  return n;"
+      "}";
+  JSContext* c = NewGenerationalContext();
+  JSRuntime* rt2 = JS_GetRuntime(c);
+  JSValue v;
+
+  RunScript(c, kMakeRing);
+  JS_RunGC(rt2);
+  // 每个环约 3 个 JS_GC_STEP_SLICE_SIZE 分片
+  RunScript(c, "globalThis.live = makeRing(3000, true); makeRing(3000, true);");
+
+  while (JS_RunGCStep(rt2, 1000))
+    continue;
+  v = EvalJS(c, "ringLength(live)");
+  EXPECT_EQ(JSToInt32(c, v), 3001);
+  JS_FreeValue(c, v);
+
+  JS_RunGC(rt2);
+  EXPECT_EQ(finalized_count, 2);
+  RunScript(c, "delete globalThis.live;");
+  JS_RunGC(rt2);
+  EXPECT_EQ(finalized_count, 4);
+
+  FreeGenerationalContext(c);
+}
+
+// 新生代回收释放的 WeakRef 目标立即失效，FinalizationRegistry 回调在完整回收后执行
+TEST(TaroJSGCTest, WeakTargetsOfYoungCycles) {
+  JSContext* c = NewGenerationalContext();
+  JSRuntime* rt2 = JS_GetRuntime(c);
+  JSContext* job_ctx;
+  JSValue v;
+
+  RunScript(c,
+      "globalThis.held = [];"
+      "globalThis.registry = new FinalizationRegistry(function (h) {"
+      "  held.push(h);"
+      "});");
+  JS_RunGC(rt2);
+  RunScript(c,
+      "(function () {"
+      "  var a = { t: track() };"
+      "  a.self = a;"
+      "  globalThis.ref = new WeakRef(a);"
+      "  registry.register(a, 'a');"
+      "})();");
+
+  while (JS_RunGCStep(rt2, 1000000))
+    continue;
+  EXPECT_EQ(finalized_count, 1);
+  v = EvalJS(c, "ref.deref() === undefined");
+  EXPECT_TRUE(JSToBool(c, v));
+  JS_FreeValue(c, v);
+
+  JS_RunGC(rt2);
+  while (JS_ExecutePendingJob(rt2, &job_ctx) > 0)
+    continue;
+  v = EvalJS(c, "held.join()");
+  EXPECT_EQ(JSToString(c, v), "a");
+  JS_FreeValue(c, v);
+
+  FreeGenerationalContext(c);
+}
+
+// 新生代回收清空超态内联缓存，缓存的 shape 不再保留其原型
+TEST(TaroJSGCTest, YoungCollectionFlushesStubCache) {
+  JSContext* c = NewGenerationalContext();
+  JSRuntime* rt2 = JS_GetRuntime(c);
+
+  JS_RunGC(rt2);
+  RunScript(c,
+      "(function () {"
+      "  function get(o) { return o.x; }"
+      "  var proto = track();"
+      "  for (var i = 0; i < 16; i++) {"
+      "    var o = Object.create(proto);"
+      "    o['p' + i] = i;"
+      "    o.x = i;"
+      "    get(o);"
+      "  }"
+      "})();");
+  EXPECT_EQ(finalized_count, 0);
+
+  while (JS_RunGCStep(rt2, 1000000))
+    continue;
+  EXPECT_EQ(finalized_count, 1);
+
+  FreeGenerationalContext(c);
+}
@@ -0,0 +1,156 @@
+#include "QuickJS/extension/taro_js_json.h"
+#include "QuickJS/extension/taro_js_type.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "./settup.h"
+
+// 生成接近真实接口返回的数据：嵌套对象、中文、转义字符、浮点数
+static JSValue MakePayload(int count) {
+  std::string code =
+      "(function(n) {"
+      "  var items = [];"
+      "  for (var i = 0; i < n; i++) {"
+      "    items.push({"
+      "      id: 100000 + i,"
+      "      sku: 'SKU-' + i.toString(36).toUpperCase(),"
+      "      title: '商品 ' + i + ' – Édition spéciale',"
+      "      price: Math.round(i * 137.31) / 100,"
+      "      discount: (i % 7) / 10,"
+      "      stock: i % 3 ? i * 11 : 0,"
+      "      onSale: (i & 1) == 0,"
+      "      description: 'Line 1\\nLine \"2\" with a \\\\ path\\tand tab. '"
+      "          + 'Lorem ipsum dolor sit amet, consectetur adipiscing elit, '"
+      "          + 'sed do eiusmod tempor incididunt ut labore.',"
+      "      tags: ['tag' + (i % 10), 'promo', '热门'],"
+      "      seller: { id: i % 97, name: 'shop_' + (i % 97), rating: 4.5 + (i % 5) / 10,"
+      "                location: { lat: 31.2304 + i / 1e5, lng: 121.4737 - i / 1e5 } },"
+      "      images: [{ url: 'https://cdn.example.com/img/' + i + '.jpg', w: 800, h: 600 }],"
+      "      extra: null"
+      "    });"
+      "  }"
+      "  return { code: 0, message: 'ok', total: n, data: items };"
+      "})(" +
+      std::to_string(count) + ")";
+  return EvalJS(code.c_str());
+}
+
+static double MBPerSecond(size_t bytes, int iterations, double seconds) {
+  return (double)bytes * iterations / (1024.0 * 1024.0) / seconds;
+}
+
+template <typename F>
+static double TimeIt(int iterations, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+    f();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+// 大文档 JSON.parse / JSON.stringify 吞吐量
+TEST(TaroJSJsonBenchTest, Throughput) {
+  const int iterations = 5;
+  JSValue payload = MakePayload(10000);
+  ASSERT_FALSE(taro_is_exception(payload));
+
+  JSValue space = JS_NewInt32(ctx, 2);
+  JSValue text = taro_js_json_stringify(ctx, payload);
+  JSValue pretty = taro_js_json_stringify(ctx, payload, JS_UNDEFINED, space);
+  ASSERT_TRUE(taro_is_string(text));
+  ASSERT_TRUE(taro_is_string(pretty));
+  std::string json = JSToString(text);
+  std::string pretty_json = JSToString(pretty);
+
+  double parse_time = TimeIt(iterations, [&] {
+    JSValue v = taro_js_json_parse(ctx, json);
+    EXPECT_FALSE(taro_is_exception(v));
+    JS_FreeValue(ctx, v);
+  });
+  double parse_pretty_time = TimeIt(iterations, [&] {
+    JSValue v = taro_js_json_parse(ctx, pretty_json);
+    EXPECT_FALSE(taro_is_exception(v));
+    JS_FreeValue(ctx, v);
+  });
+
+  JSValue parsed = taro_js_json_parse(ctx, json);
+  ASSERT_FALSE(taro_is_exception(parsed));
+  double stringify_time = TimeIt(iterations, [&] {
+    JSValue v = taro_js_json_stringify(ctx, parsed);
+    EXPECT_TRUE(taro_is_string(v));
+    JS_FreeValue(ctx, v);
+  });
+  double stringify_pretty_time = TimeIt(iterations, [&] {
+    JSValue v = taro_js_json_stringify(ctx, parsed, JS_UNDEFINED, space);
+    EXPECT_TRUE(taro_is_string(v));
+    JS_FreeValue(ctx, v);
+  });
+
+  printf(
+      "[JSON] %.1f MB document: parse %.1f MB/s, parse (indented) %.1f MB/s, "
+      "stringify %.1f MB/s, stringify (indented) %.1f MB/s\n",
+      json.size() / (1024.0 * 1024.0),
+      MBPerSecond(json.size(), iterations, parse_time),
+      MBPerSecond(pretty_json.size(), iterations, parse_pretty_time),
+      MBPerSecond(json.size(), iterations, stringify_time),
+      MBPerSecond(pretty_json.size(), iterations, stringify_pretty_time));
+
+  // 往返结果一致
+  JSValue round_trip = taro_js_json_stringify(ctx, parsed);
+  EXPECT_EQ(JSToString(round_trip), json);
+  JSValue round_trip_pretty =
+      taro_js_json_stringify(ctx, parsed, JS_UNDEFINED, space);
+  EXPECT_EQ(JSToString(round_trip_pretty), pretty_json);
+
+  JS_FreeValue(ctx, round_trip_pretty);
+  JS_FreeValue(ctx, round_trip);
+  JS_FreeValue(ctx, parsed);
+  JS_FreeValue(ctx, pretty);
+  JS_FreeValue(ctx, text);
+  JS_FreeValue(ctx, space);
+  JS_FreeValue(ctx, payload);
+}
+
+// 长字符串为主的文档（SIMD 扫描收益最明显的场景）
+TEST(TaroJSJsonBenchTest, LongStrings) {
+  const int iterations = 5;
+  JSValue payload = EvalJS(
+      "(function() {"
+      "  var a = [];"
+      "  for (var i = 0; i < 2000; i++)"
+      "    a.push({ id: i, body: 'The quick brown fox jumps over the lazy dog. '"
+      "        .repeat(40) + '\\n' + '中文内容'.repeat(20) });"
+      "  return a;"
+      "})()");
+  ASSERT_FALSE(taro_is_exception(payload));
+  JSValue text = taro_js_json_stringify(ctx, payload);
+  std::string json = JSToString(text);
+
+  double parse_time = TimeIt(iterations, [&] {
+    JSValue v = taro_js_json_parse(ctx, json);
+    EXPECT_FALSE(taro_is_exception(v));
+    JS_FreeValue(ctx, v);
+  });
+  double stringify_time = TimeIt(iterations, [&] {
+    JSValue v = taro_js_json_stringify(ctx, payload);
+    EXPECT_TRUE(taro_is_string(v));
+    JS_FreeValue(ctx, v);
+  });
+
+  printf(
+      "[JSON] %.1f MB long strings: parse %.1f MB/s, stringify %.1f MB/s\n",
+      json.size() / (1024.0 * 1024.0),
+      MBPerSecond(json.size(), iterations, parse_time),
+      MBPerSecond(json.size(), iterations, stringify_time));
+
+  JSValue parsed = taro_js_json_parse(ctx, json);
+  JSValue round_trip = taro_js_json_stringify(ctx, parsed);
+  EXPECT_EQ(JSToString(round_trip), json);
+
+  JS_FreeValue(ctx, round_trip);
+  JS_FreeValue(ctx, parsed);
+  JS_FreeValue(ctx, text);
+  JS_FreeValue(ctx, payload);
+}
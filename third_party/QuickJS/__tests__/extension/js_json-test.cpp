@@ -1,5 +1,7 @@
 #include "QuickJS/extension/taro_js_json.h"
 
+#include <cmath>
+
 #include "./settup.h"
 
 // JSON.parse 基本测试
@@ -231,3 +233,104 @@ TEST(TaroJSJsonTest, StringifySpecialValues) {
   JS_FreeValue(ctx, json);
   JS_FreeValue(ctx, obj);
 }
+
+// JSON.parse 快速路径语义与通用解析器一致
+TEST(TaroJSJsonTest, ParseFastPathSemantics) {
+  // 重复的键取最后一个值，-0 保持为 -0
+  JSValue obj = taro_js_json_parse(ctx, "{\"a\":1,\"b\":-0,\"a\":[1.5,1e21,\"x\"]}");
+  ASSERT_FALSE(taro_is_exception(obj));
+  JSValue keys = EvalJS("(function(o) { return Object.keys(o).join(); })");
+  JSValue res = JS_Call(ctx, keys, JS_UNDEFINED, 1, &obj);
+  EXPECT_EQ(JSToString(res), "a,b");
+  JS_FreeValue(ctx, res);
+  JS_FreeValue(ctx, keys);
+  JSValue b = JS_GetPropertyStr(ctx, obj, "b");
+  EXPECT_TRUE(JS_VALUE_GET_TAG(b) == JS_TAG_FLOAT64);
+  EXPECT_TRUE(std::signbit(JS_VALUE_GET_FLOAT64(b)));
+  JS_FreeValue(ctx, b);
+  JS_FreeValue(ctx, obj);
+
+  // 转义和 UTF-8 字符
+  JSValue str = taro_js_json_parse(ctx, "\"\\u4e2d\\ud83d\\ude00\\n\\\"é文\"");
+  EXPECT_EQ(JSToString(str), "中😀\n\"é文");
+  JS_FreeValue(ctx, str);
+
+  // 错误信息与通用解析器一致
+  JSValue msg = EvalJS(
+      "(function() { try { JSON.parse('[1,]'); } catch (e) { return e.message; } })()");
+  EXPECT_EQ(JSToString(msg), "unexpected token: ']'");
+  JS_FreeValue(ctx, msg);
+  msg = EvalJS(
+      "(function() { try { JSON.parse('[01]'); } catch (e) { return e.message; } })()");
+  EXPECT_EQ(JSToString(msg), "Unexpected number");
+  JS_FreeValue(ctx, msg);
+}
+
+// JSON.stringify 快速路径无法处理时回退到通用实现
+TEST(TaroJSJsonTest, StringifyFastPathFallback) {
+  JSValue res = EvalJS(
+      "JSON.stringify({ a: { toJSON() { return 'x'; } }, b: [1, , 3],"
+      " get c() { return 2; }, 1: 'one', d: new Date(0) })");
+  EXPECT_EQ(
+      JSToString(res),
+      "{\"1\":\"one\",\"a\":\"x\",\"b\":[1,null,3],\"c\":2,"
+      "\"d\":\"1970-01-01T00:00:00.000Z\"}");
+  JS_FreeValue(ctx, res);
+
+  // 循环引用仍然抛出 TypeError
+  res = EvalJS(
+      "(function() { var o = { a: [] }; o.a.push(o);"
+      " try { JSON.stringify(o); } catch (e) { return e.message; } })()");
+  EXPECT_EQ(JSToString(res), "circular reference");
+  JS_FreeValue(ctx, res);
+
+  // 字符串转义
+  res = EvalJS("JSON.stringify(['\\t\"\\\\\\u0001', '\\ud800', 'ÿ'], null, 1)");
+  EXPECT_EQ(
+      JSToString(res), "[\n \"\\t\\\"\\\\\\u0001\",\n \"\\ud800\",\n \"ÿ\"\n]");
+  JS_FreeValue(ctx, res);
+}
+
+// 嵌套对象、中文、转义字符、浮点数和长字符串的往返结果一致
+TEST(TaroJSJsonTest, RoundTrip) {
+  JSValue payload = EvalJS(
+      "(function() {"
+      "  var items = [];"
+      "  for (var i = 0; i < 20; i++) {"
+      "    items.push({"
+      "      id: 100000 + i,"
+      "      title: '商品 ' + i + ' – Édition spéciale',"
+      "      price: Math.round(i * 137.31) / 100,"
+      "      onSale: (i & 1) == 0,"
+      "      description: 'Line 1\\nLine \"2\" with a \\\\ path\\tand tab. '"
+      "          + 'The quick brown fox jumps over the lazy dog. '.repeat(i),"
+      "      tags: ['tag' + (i % 10), '热门'],"
+      "      seller: { id: i % 7, location: { lat: 31.2304 + i / 1e5 } },"
+      "      extra: null"
+      "    });"
+      "  }"
+      "  return { code: 0, total: items.length, data: items };"
+      "})()");
+  ASSERT_FALSE(taro_is_exception(payload));
+  JSValue space = JS_NewInt32(ctx, 2);
+
+  for (bool indented : {false, true}) {
+    JSValue text = indented
+        ? taro_js_json_stringify(ctx, payload, JS_UNDEFINED, space)
+        : taro_js_json_stringify(ctx, payload);
+    ASSERT_TRUE(taro_is_string(text));
+    std::string json = JSToString(text);
+    JSValue parsed = taro_js_json_parse(ctx, json);
+    ASSERT_FALSE(taro_is_exception(parsed));
+    JSValue round_trip = indented
+        ? taro_js_json_stringify(ctx, parsed, JS_UNDEFINED, space)
+        : taro_js_json_stringify(ctx, parsed);
+    EXPECT_EQ(JSToString(round_trip), json);
+    JS_FreeValue(ctx, round_trip);
+    JS_FreeValue(ctx, parsed);
+    JS_FreeValue(ctx, text);
+  }
+
+  JS_FreeValue(ctx, space);
+  JS_FreeValue(ctx, payload);
+}
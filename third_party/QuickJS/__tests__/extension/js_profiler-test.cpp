@@ -0,0 +1,126 @@
+#include "QuickJS/extension/taro_js_profiler.h"
+#include "QuickJS/extension/taro_js_type.h"
+
+#include <cstring>
+
+#include "./settup.h"
+
+static void RunHotLoop() {
+  JSValue result = EvalJS(
+      "(function() {"
+      "  function profHot() {"
+      "    let s = 0;"
+      "    for (let i = 0; i < 2000000; i++) s = (s + i) | 0;"
+      "    return s;"
+      "  }"
+      "  return profHot() & 0;"
+      "})()");
+  EXPECT_EQ(JSToInt32(result), 0);
+  JS_FreeValue(ctx, result);
+}
+
+// 测试采样数与 Trace Event 导出
+TEST(TaroJSProfilerTest, TraceEvent) {
+  EXPECT_EQ(taro_js_profiler_start(rt, 100), 0);
+  RunHotLoop();
+  taro_js_profiler_stop(rt);
+  EXPECT_GT(taro_js_profiler_sample_count(rt), 0u);
+
+  JSValue json = taro_js_profiler_to_trace_event(ctx);
+  ASSERT_TRUE(taro_is_string(json));
+  const char* str = JS_ToCString(ctx, json);
+  EXPECT_NE(strstr(str, "\"ProfileChunk\""), nullptr);
+  EXPECT_NE(strstr(str, "\"profHot\""), nullptr);
+  JS_FreeCString(ctx, str);
+  JS_FreeValue(ctx, json);
+  taro_js_profiler_clear(rt);
+}
+
+// 测试 pprof 导出
+TEST(TaroJSProfilerTest, Pprof) {
+  EXPECT_EQ(taro_js_profiler_start(rt, 100), 0);
+  RunHotLoop();
+  taro_js_profiler_stop(rt);
+
+  JSValue buf = taro_js_profiler_to_pprof(ctx);
+  size_t len = 0;
+  uint8_t* data = JS_GetArrayBuffer(ctx, &len, buf);
+  ASSERT_NE(data, nullptr);
+  EXPECT_GT(len, 0u);
+  JS_FreeValue(ctx, buf);
+  taro_js_profiler_clear(rt);
+  EXPECT_EQ(taro_js_profiler_sample_count(rt), 0u);
+}
+
+static int interrupt_count;
+
+static int CountInterrupts(JSRuntime* rt, void* opaque) {
+  interrupt_count++;
+  return 0;
+}
+
+// 只在采样期间缩短中断轮询周期，停止后保留的结果不影响轮询
+TEST(TaroJSProfilerTest, PollPeriod) {
+  JS_SetInterruptHandler(rt, CountInterrupts, nullptr);
+  interrupt_count = 0;
+  RunHotLoop();
+  int idle_count = interrupt_count;
+
+  EXPECT_EQ(taro_js_profiler_start(rt, 100), 0);
+  interrupt_count = 0;
+  RunHotLoop();
+  EXPECT_GT(interrupt_count, idle_count * 5);
+
+  taro_js_profiler_stop(rt);
+  interrupt_count = 0;
+  RunHotLoop();
+  EXPECT_LT(interrupt_count, idle_count * 2);
+
+  taro_js_profiler_clear(rt);
+  JS_SetInterruptHandler(rt, nullptr, nullptr);
+}
+
+static void HeapSiteCallback(JSRuntime* rt,
+                             const TaroJSHeapSite* site,
+                             void* opaque) {
+  (void)rt;
+  if (site->func_name && strcmp(site->func_name, "makeNode") == 0)
+    *(TaroJSHeapSite*)opaque = *site;
+}
+
+// 测试分配点统计与保留大小
+TEST(TaroJSProfilerTest, HeapSites) {
+  taro_js_heap_profiler_start(rt);
+  JSValue result = EvalJS(
+      "(function() {"
+      "  function makeNode(i) { return { id: i, next: null }; }"
+      "  globalThis.heapNodes = [];"
+      "  for (let i = 0; i < 100; i++) heapNodes.push(makeNode(i));"
+      "  return heapNodes.length;"
+      "})()");
+  EXPECT_EQ(JSToInt32(result), 100);
+  JS_FreeValue(ctx, result);
+
+  TaroJSHeapSite found;
+  memset(&found, 0, sizeof(found));
+  EXPECT_EQ(taro_js_heap_profiler_for_each_site(rt, HeapSiteCallback, &found),
+            0);
+  EXPECT_GE(found.alloc_count, 100u);
+  EXPECT_GE(found.live_count, 100u);
+  EXPECT_GE(found.retained_size, found.self_size);
+
+  taro_js_heap_profiler_stop(rt);
+  taro_js_heap_profiler_clear(rt);
+  JS_FreeValue(ctx, EvalJS("delete globalThis.heapNodes"));
+}
+
+// 测试堆快照导出
+TEST(TaroJSProfilerTest, HeapSnapshot) {
+  JSValue json = taro_js_take_heap_snapshot(ctx);
+  ASSERT_TRUE(taro_is_string(json));
+  const char* str = JS_ToCString(ctx, json);
+  EXPECT_NE(strstr(str, "\"snapshot\""), nullptr);
+  EXPECT_NE(strstr(str, "\"trace_function_infos\""), nullptr);
+  JS_FreeCString(ctx, str);
+  JS_FreeValue(ctx, json);
+}
@@ -0,0 +1,55 @@
+#include "QuickJS/extension/taro_js_type.h"
+
+#include <chrono>
+#include <cstdio>
+
+#include "./settup.h"
+
+template <typename F>
+static double TimeIt(int iterations, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+    f();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+// 编译缓存与起始位置预扫描的耗时
+TEST(TaroJSRegExpBenchTest, CompileAndSearch) {
+  const int iterations = 5;
+  const char* compile_script =
+      "for (var i = 0, n = 0; i < 20000; i++)"
+      "  if (new RegExp('^([\\\\w.+-]+)@([\\\\w-]+\\\\.)+[a-z]{2,}$', 'i')"
+      "      .test('user' + (i & 7) + '@example.com')) n++;";
+  const char* search_script =
+      "var text = 'lorem ipsum dolor sit amet '.repeat(20000) + 'id=42;';"
+      "for (var i = 0; i < 20; i++) {"
+      "  /id=(\\d+);/.exec(text);"
+      "  /[0-9]+;/.exec(text);"
+      "  text.replace(/ipsum/g, 'IPSUM');"
+      "}";
+
+  JSRuntime* rt2 = JS_NewRuntime();
+  JSContext* c = JS_NewContext(rt2);
+  auto run = [&](const char* script) {
+    JSValue v = EvalJS(c, script);
+    EXPECT_FALSE(taro_is_exception(v));
+    JS_FreeValue(c, v);
+  };
+
+  JS_SetRegExpCacheSize(rt2, 0);
+  double uncached_time = TimeIt(iterations, [&] { run(compile_script); });
+  JS_SetRegExpCacheSize(rt2, 64);
+  double cached_time = TimeIt(iterations, [&] { run(compile_script); });
+  double search_time = TimeIt(iterations, [&] { run(search_script); });
+
+  printf(
+      "[RegExp] new RegExp() loop: uncached %.1f ms, cached %.1f ms; "
+      "search in 540 KB text %.1f ms\n",
+      uncached_time * 1000 / iterations,
+      cached_time * 1000 / iterations,
+      search_time * 1000 / iterations);
+
+  JS_FreeContext(c);
+  JS_FreeRuntime(rt2);
+}
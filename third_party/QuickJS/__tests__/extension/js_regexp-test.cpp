@@ -0,0 +1,53 @@
+#include "QuickJS/extension/taro_js_type.h"
+
+#include <string>
+
+#include "./settup.h"
+
+// 同一 pattern 不同 flags、compile() 替换字节码、缓存淘汰后结果保持一致
+static const char* kCheckScript =
+    "(function () {"
+    "  var out = [];"
+    "  var patterns = ['o+', 'O+', '(\\\\d+)-(\\\\w+)', '^ab', 'b$', '[a-z]+x'];"
+    "  for (var n = 0; n < 3; n++) {"
+    "    for (var i = 0; i < patterns.length; i++) {"
+    "      var g = new RegExp(patterns[i], 'g');"
+    "      var gi = new RegExp(patterns[i], 'gi');"
+    "      out.push('foo 12-ab boo ab zzx'.replace(g, '#'),"
+    "               'FOO 12-AB boo ab zzx'.replace(gi, '#'), gi.flags);"
+    "    }"
+    "  }"
+    "  var re = new RegExp('o+', 'g');"
+    "  re.compile('x', 'i');"
+    "  out.push(re.test('X'), new RegExp('o+', 'g').test('X'));"
+    "  return JSON.stringify(out);"
+    "})()";
+
+static std::string Check(JSContext* c) {
+  JSValue v = EvalJS(c, kCheckScript);
+  std::string result = taro_is_exception(v) ? "<exception>" : JSToString(c, v);
+  JS_FreeValue(c, v);
+  return result;
+}
+
+// 缓存大小为 0（关闭）、1（频繁淘汰）和默认值时结果相同
+TEST(TaroJSRegExpTest, CacheSize) {
+  JSRuntime* rt2 = JS_NewRuntime();
+  JSContext* c = JS_NewContext(rt2);
+  std::string expected = Check(c);
+  EXPECT_NE(expected, "<exception>");
+  EXPECT_EQ(Check(c), expected);
+
+  for (int size : {0, 1, 2, 64}) {
+    JS_SetRegExpCacheSize(rt2, size);
+    EXPECT_EQ(Check(c), expected);
+  }
+
+  // 缓存在运行时内的上下文之间共享
+  JSContext* c2 = JS_NewContext(rt2);
+  EXPECT_EQ(Check(c2), expected);
+  JS_FreeContext(c2);
+
+  JS_FreeContext(c);
+  JS_FreeRuntime(rt2);
+}
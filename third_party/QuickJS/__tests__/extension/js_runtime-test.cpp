@@ -0,0 +1,136 @@
+#include "QuickJS/extension/taro_js_runtime.h"
+#include "QuickJS/extension/taro_js_type.h"
+
+#include <cstring>
+
+#include "./settup.h"
+
+struct ICSiteQuery {
+  JSAtom atom;
+  int state;
+  uint64_t hits;
+};
+
+static void FindICSite(
+    JSRuntime* rt,
+    const TaroJSInlineCacheSite* site,
+    void* opaque) {
+  ICSiteQuery* q = (ICSiteQuery*)opaque;
+  if (site->atom == q->atom) {
+    q->state = site->state;
+    q->hits = site->hits;
+  }
+}
+
+// 站点随函数字节码释放，测试脚本需将函数挂到 globalThis 上
+static ICSiteQuery QueryICSite(const char* name) {
+  ICSiteQuery q = {JS_NewAtom(ctx, name), -1, 0};
+  taro_js_for_each_inline_cache_site(rt, FindICSite, &q);
+  JS_FreeAtom(ctx, q.atom);
+  return q;
+}
+
+// 测试单态站点的命中统计
+TEST(TaroJSRuntimeTest, InlineCacheMonomorphic) {
+  JSValue result = EvalJS(
+      "(function() {"
+      "  function get(o) { return o.icMonoField; }"
+      "  globalThis.icMonoGet = get;"
+      "  let s = 0;"
+      "  for (let i = 0; i < 100; i++) s += get({ icMonoField: i });"
+      "  return s;"
+      "})()");
+  EXPECT_EQ(JSToInt32(result), 4950);
+  JS_FreeValue(ctx, result);
+
+  ICSiteQuery q = QueryICSite("icMonoField");
+  EXPECT_EQ(q.state, TARO_JS_IC_MONOMORPHIC);
+  EXPECT_GT(q.hits, 0u);
+}
+
+// 测试超过环容量的站点转为超态
+TEST(TaroJSRuntimeTest, InlineCacheMegamorphic) {
+  JSValue result = EvalJS(
+      "(function() {"
+      "  function get(o) { return o.icMegaField; }"
+      "  globalThis.icMegaGet = get;"
+      "  const objs = [];"
+      "  for (let i = 0; i < 8; i++) {"
+      "    const o = {};"
+      "    o['k' + i] = i;"
+      "    o.icMegaField = i;"
+      "    objs.push(o);"
+      "  }"
+      "  let s = 0;"
+      "  for (let j = 0; j < 10; j++)"
+      "    for (const o of objs) s += get(o);"
+      "  return s;"
+      "})()");
+  EXPECT_EQ(JSToInt32(result), 280);
+  JS_FreeValue(ctx, result);
+
+  ICSiteQuery q = QueryICSite("icMegaField");
+  EXPECT_EQ(q.state, TARO_JS_IC_MEGAMORPHIC);
+  EXPECT_GT(q.hits, 0u);
+
+  TaroJSInlineCacheStats stats;
+  taro_js_get_inline_cache_stats(rt, &stats);
+  EXPECT_GT(stats.state_count[TARO_JS_IC_MEGAMORPHIC], 0u);
+
+  taro_js_reset_inline_cache_stats(rt);
+  taro_js_get_inline_cache_stats(rt, &stats);
+  EXPECT_EQ(stats.hits, 0u);
+  EXPECT_EQ(stats.misses, 0u);
+}
+
+// 测试 slab 分配器的内存统计
+TEST(TaroJSRuntimeTest, SlabMemoryUsage) {
+  JSMemoryUsage usage;
+  int64_t used_count;
+
+  JSValue result = EvalJS(
+      "(function() {"
+      "  globalThis.slabObjs = [];"
+      "  for (let i = 0; i < 1000; i++) slabObjs.push({ i: i });"
+      "  return slabObjs.length;"
+      "})()");
+  EXPECT_EQ(JSToInt32(result), 1000);
+  JS_FreeValue(ctx, result);
+
+  JS_ComputeMemoryUsage(rt, &usage);
+  EXPECT_GT(usage.slab_count, 0);
+  EXPECT_GE(usage.slab_used_count, 1000);
+  EXPECT_GE(usage.slab_size, usage.slab_used_size);
+  used_count = usage.slab_used_count;
+
+  JS_FreeValue(ctx, EvalJS("delete globalThis.slabObjs"));
+  JS_RunGC(rt);
+  JS_ComputeMemoryUsage(rt, &usage);
+  EXPECT_LE(usage.slab_used_count, used_count - 1000);
+}
+
+// 挂起的生成器与 async 函数的局部变量被闭包捕获时，上下文释放后可被回收
+TEST(TaroJSRuntimeTest, SlabSuspendedFrameCycle) {
+  static const char* kScript =
+      "function* gen() { let o = {}; let f = () => o; yield 1; }"
+      "var it = gen(); it.next();"
+      "async function af() {"
+      "  let o = {}; let f = () => o; await new Promise(() => {});"
+      "}"
+      "af();";
+  JSMemoryUsage usage;
+  JSRuntime* rt2 = JS_NewRuntime();
+  JSContext* c = JS_NewContext(rt2);
+
+  JSValue result =
+      JS_Eval(c, kScript, strlen(kScript), "<input>", JS_EVAL_TYPE_GLOBAL);
+  EXPECT_FALSE(taro_is_exception(result));
+  JS_FreeValue(c, result);
+  JS_FreeContext(c);
+  JS_RunGC(rt2);
+
+  JS_ComputeMemoryUsage(rt2, &usage);
+  EXPECT_EQ(usage.obj_count, 0);
+  EXPECT_EQ(usage.slab_used_count, 0);
+  JS_FreeRuntime(rt2);
+}
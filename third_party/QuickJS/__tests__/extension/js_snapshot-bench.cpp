@@ -0,0 +1,99 @@
+#include "QuickJS/extension/taro_js_bytecode.h"
+#include "QuickJS/extension/taro_js_type.h"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "./settup.h"
+
+template <typename F>
+static double TimeIt(int iterations, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++)
+    f();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - start).count();
+}
+
+// 启动耗时：执行源码 / 加载字节码 / 恢复快照
+TEST(TaroJSSnapshotBenchTest, Startup) {
+  const int iterations = 20;
+  std::string source =
+      "var modules = {};"
+      "for (var m = 0; m < 200; m++) {"
+      "  modules['m' + m] = (function (id) {"
+      "    var cache = {};"
+      "    class Component {"
+      "      constructor(props) { this.props = props; }"
+      "      render() { return id + ':' + JSON.stringify(this.props); }"
+      "    }"
+      "    for (var i = 0; i < 50; i++) cache['k' + i] = { i: i, label: 'item ' + i };"
+      "    return { Component: Component, cache: cache,"
+      "             lookup: function (k) { return cache[k]; } };"
+      "  })(m);"
+      "}"
+      "var table = [];"
+      "for (var i = 0; i < 20000; i++) table.push((i * 2654435761) % 1000);";
+
+  JSContext* src = JS_NewContext(rt);
+  JSValue func = JS_Eval(
+      src,
+      source.c_str(),
+      source.size(),
+      "<startup>",
+      JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+  ASSERT_FALSE(taro_is_exception(func));
+  size_t bc_size = 0;
+  uint8_t* bc = JS_WriteObject(src, &bc_size, func, JS_WRITE_OBJ_BYTECODE);
+  ASSERT_TRUE(bc != nullptr);
+  JSValue ret = JS_EvalFunction(src, func);
+  ASSERT_FALSE(taro_is_exception(ret));
+  JS_FreeValue(src, ret);
+  std::string image = taro_js_write_context_snapshot(src);
+  ASSERT_FALSE(image.empty());
+
+  double empty_time = TimeIt(iterations, [&] {
+    JS_FreeContext(JS_NewContext(rt));
+  });
+  double source_time = TimeIt(iterations, [&] {
+    JSContext* c = JS_NewContext(rt);
+    JSValue v = JS_Eval(
+        c, source.c_str(), source.size(), "<startup>", JS_EVAL_TYPE_GLOBAL);
+    EXPECT_FALSE(taro_is_exception(v));
+    JS_FreeValue(c, v);
+    JS_FreeContext(c);
+  });
+  double bytecode_time = TimeIt(iterations, [&] {
+    JSContext* c = JS_NewContext(rt);
+    JSValue f = JS_ReadObject(c, bc, bc_size, JS_READ_OBJ_BYTECODE);
+    JSValue v = JS_EvalFunction(c, f);
+    EXPECT_FALSE(taro_is_exception(v));
+    JS_FreeValue(c, v);
+    JS_FreeContext(c);
+  });
+  double snapshot_time = TimeIt(iterations, [&] {
+    JSContext* c = JS_NewContext(rt);
+    EXPECT_EQ(taro_js_restore_context_snapshot(c, image), 0);
+    JS_FreeContext(c);
+  });
+
+  printf(
+      "[Snapshot] %.1f KB image: empty context %.3f ms, source %.3f ms, "
+      "bytecode %.3f ms, snapshot %.3f ms\n",
+      image.size() / 1024.0,
+      empty_time * 1000 / iterations,
+      source_time * 1000 / iterations,
+      bytecode_time * 1000 / iterations,
+      snapshot_time * 1000 / iterations);
+
+  JSContext* c = JS_NewContext(rt);
+  ASSERT_EQ(taro_js_restore_context_snapshot(c, image), 0);
+  JSValue v = EvalJS(c, "modules.m199.lookup('k49').label + ':' + table.length");
+  EXPECT_EQ(JSToString(c, v), "item 49:20000");
+  JS_FreeValue(c, v);
+  JS_FreeContext(c);
+
+  js_free(src, bc);
+  JS_FreeContext(src);
+}
@@ -0,0 +1,183 @@
+#include "QuickJS/extension/taro_js_bytecode.h"
+#include "QuickJS/extension/taro_js_type.h"
+
+#include <cstring>
+#include <string>
+
+#include "./settup.h"
+
+// 初始化脚本：闭包、类继承、访问器、Map/Set、正则、日期、冻结对象、循环引用、
+// 内置原型上的 polyfill（包括全局变量引用不到的原型和命名空间对象）、
+// 删除的内置属性以及全局 let/const
+static const char* kSetupScript =
+    "var counter = (function () {"
+    "  var n = 0;"
+    "  return { inc: function () { return ++n; }, get: function () { return n; } };"
+    "})();"
+    "class Shape {"
+    "  constructor(name) { this.name = name; }"
+    "  area() { return 0; }"
+    "  describe() { return this.name + ':' + this.area(); }"
+    "  static create(k, v) { return k === 'sq' ? new Square(v) : new Circle(v); }"
+    "}"
+    "class Square extends Shape {"
+    "  constructor(s) { super('square'); this.s = s; }"
+    "  area() { return this.s * this.s; }"
+    "  describe() { return '[' + super.describe() + ']'; }"
+    "}"
+    "class Circle extends Shape {"
+    "  constructor(r) { super('circle'); this.r = r; }"
+    "  get diameter() { return this.r * 2; }"
+    "  area() { return 3 * this.r * this.r; }"
+    "}"
+    "const config = Object.freeze({ env: 'prod', retries: 3, tags: ['a', 'b'] });"
+    "let registry = new Map([['sq', Square], ['c', Circle]]);"
+    "var seen = new Set([1, 'two', config]);"
+    "var pattern = /(\\d+)-(\\w+)/g;"
+    "var when = new Date(1700000000000);"
+    "var store = { items: [] };"
+    "store.self = store;"
+    "store.items.push({ owner: store });"
+    "Array.prototype.sum = function () {"
+    "  return this.reduce(function (a, b) { return a + b; }, 0);"
+    "};"
+    "String.prototype.shout = function () { return this.toUpperCase() + '!'; };"
+    "JSON.myStringify = JSON.stringify;"
+    "Math.myPi = 3;"
+    "delete Array.prototype.flat;"
+    "function* range(n) { for (let i = 0; i < n; i++) yield i; }"
+    "async function later(x) { return x * 2; }"
+    "var sparse = [1, , 3];"
+    "sparse.length = 5;"
+    "var boxed = new Number(42);"
+    "globalThis.appName = 'demo';"
+    "var Singleton = (function () {"
+    "  var instance;"
+    "  function S() { this.id = 7; }"
+    "  S.prototype.get = function () { return instance; };"
+    "  instance = new S();"
+    "  return S;"
+    "})();"
+    "counter.inc();"
+    "counter.inc();";
+
+// 检查恢复后的状态，返回 JSON 字符串便于对比
+static const char* kCheckScript =
+    "(function () {"
+    "  var out = [];"
+    "  out.push(counter.inc(), counter.get());"
+    "  out.push(Shape.create('sq', 3).describe(), Shape.create('c', 2).describe(),"
+    "           new Circle(5).diameter);"
+    "  out.push(new Square(2) instanceof Shape, Object.getPrototypeOf(Square) === Shape);"
+    "  out.push(Object.isFrozen(config), config.tags.join('|'),"
+    "           registry.get('c') === Circle, registry.size);"
+    "  out.push(seen.has(config), seen.has('two'), seen.size);"
+    "  out.push('12-ab 34-cd'.replace(pattern, '$2$1'), pattern.lastIndex);"
+    "  out.push(when.getTime(), when instanceof Date);"
+    "  out.push(store.self === store, store.items[0].owner === store);"
+    "  out.push([1, 2, 3].sum(), Array.from(range(4)).join(','));"
+    "  out.push(sparse.length, 1 in sparse, sparse[2]);"
+    "  out.push(boxed + 1, typeof boxed, typeof later);"
+    "  out.push(appName, new Singleton().get().id,"
+    "           new Singleton().get() instanceof Singleton);"
+    "  out.push('a'.shout(), JSON.myStringify({ a: 1 }), Math.myPi, typeof [].flat);"
+    "  return JSON.stringify(out);"
+    "})()";
+
+static const char* kExpected =
+    "[3,3,\"[square:9]\",\"circle:12\",10,true,true,true,\"a|b\",true,2,"
+    "true,true,3,\"ab12 cd34\",0,1700000000000,true,true,true,6,\"0,1,2,3\","
+    "5,false,3,43,\"object\",\"function\",\"demo\",7,true,\"A!\","
+    "\"{\\\"a\\\":1}\",3,\"undefined\"]";
+
+static std::string Check(JSContext* c) {
+  JSValue v = EvalJS(c, kCheckScript);
+  std::string result = taro_is_exception(v) ? "<exception>" : JSToString(c, v);
+  JS_FreeValue(c, v);
+  return result;
+}
+
+static JSContext* NewInitializedContext(JSRuntime* r) {
+  JSContext* c = JS_NewContext(r);
+  JSValue v = EvalJS(c, kSetupScript);
+  EXPECT_FALSE(taro_is_exception(v));
+  JS_FreeValue(c, v);
+  return c;
+}
+
+// 同一运行时内恢复
+TEST(TaroJSSnapshotTest, RestoreSameRuntime) {
+  JSContext* src = NewInitializedContext(rt);
+  std::string image = taro_js_write_context_snapshot(src);
+  ASSERT_FALSE(image.empty());
+  EXPECT_EQ(Check(src), kExpected);
+
+  JSContext* dst = JS_NewContext(rt);
+  ASSERT_EQ(taro_js_restore_context_snapshot(dst, image), 0);
+  EXPECT_EQ(Check(dst), kExpected);
+
+  // 两个上下文的状态互不影响
+  JSValue v = EvalJS(dst, "counter.inc()");
+  EXPECT_EQ(JSToInt32(dst, v), 4);
+  JS_FreeValue(dst, v);
+  v = EvalJS(src, "counter.get()");
+  EXPECT_EQ(JSToInt32(src, v), 3);
+  JS_FreeValue(src, v);
+
+  JS_FreeContext(dst);
+  JS_FreeContext(src);
+}
+
+// 恢复到新的运行时，并从恢复后的上下文再次生成快照
+TEST(TaroJSSnapshotTest, RestoreNewRuntime) {
+  JSContext* src = NewInitializedContext(rt);
+  std::string image = taro_js_write_context_snapshot(src);
+  ASSERT_FALSE(image.empty());
+
+  JSRuntime* rt2 = JS_NewRuntime();
+  JSContext* dst = JS_NewContext(rt2);
+  ASSERT_EQ(taro_js_restore_context_snapshot(dst, image), 0);
+  std::string image2 = taro_js_write_context_snapshot(dst);
+  ASSERT_FALSE(image2.empty());
+  EXPECT_EQ(Check(dst), kExpected);
+
+  JSContext* dst2 = JS_NewContext(rt2);
+  ASSERT_EQ(taro_js_restore_context_snapshot(dst2, image2), 0);
+  EXPECT_EQ(Check(dst2), kExpected);
+
+  JS_FreeContext(dst2);
+  JS_FreeContext(dst);
+  JS_FreeRuntime(rt2);
+  JS_FreeContext(src);
+}
+
+// 不支持的状态返回异常，错误的镜像不会崩溃
+TEST(TaroJSSnapshotTest, Errors) {
+  JSContext* src = JS_NewContext(rt);
+  JSValue v = EvalJS(src, "var tagged = { [Symbol('x')]: 1 };");
+  JS_FreeValue(src, v);
+  EXPECT_TRUE(taro_js_write_context_snapshot(src).empty());
+  JSValue exception = JS_GetException(src);
+  EXPECT_TRUE(taro_is_error(src, exception));
+  JS_FreeValue(src, exception);
+  JS_FreeContext(src);
+
+  src = NewInitializedContext(rt);
+  std::string image = taro_js_write_context_snapshot(src);
+  ASSERT_FALSE(image.empty());
+  JS_FreeContext(src);
+
+  // 截断位置覆盖镜像的各个部分（函数头、变量定义、闭包变量、字节码……）
+  auto restore_truncated = [&](size_t len) {
+    JSContext* dst = JS_NewContext(rt);
+    EXPECT_EQ(taro_js_restore_context_snapshot(dst, image.substr(0, len)), -1)
+        << "length " << len;
+    JS_FreeValue(dst, JS_GetException(dst));
+    JS_FreeContext(dst);
+  };
+  size_t step = image.size() / 500 + 1;
+  for (size_t len = 0; len < image.size(); len += step)
+    restore_truncated(len);
+  for (size_t len = image.size() - 64; len < image.size(); len++)
+    restore_truncated(len);
+}
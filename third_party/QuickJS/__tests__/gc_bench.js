@@ -0,0 +1,78 @@
+/*
+ * GC pause benchmark
+ *
+ * Usage: qjs --std gc_bench.js [full|generational] [retained_objects]
+ *
+ * A large retained heap is built, then each frame allocates short lived
+ * cyclic garbage. The frame durations include the collections triggered
+ * by the allocations, so their distribution shows the GC pauses.
+ */
+
+var mode = scriptArgs[1] || "full";
+var retained_count = +(scriptArgs[2] || 1000000);
+var frame_count = 300;
+var frame_objects = 5000;
+var step_budget_us = 1000;
+var buckets = [0.5, 1, 2, 4, 8, 16, 32, 64];
+
+function make_cycle(i) {
+    var a = { i: i, next: null };
+    var b = { prev: a, data: [i, i + 1] };
+    a.next = b;
+    return a;
+}
+
+function build_heap(n) {
+    var heap = [];
+    var i;
+    for (i = 0; i < n; i++)
+        heap.push(make_cycle(i));
+    return heap;
+}
+
+function percentile(sorted, p) {
+    return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))];
+}
+
+function main() {
+    var heap, times, i, j, t0, sum, counts, label, sorted;
+
+    std.setGCGenerational(mode == "generational");
+    heap = build_heap(retained_count);
+    std.gc();
+
+    times = [];
+    sum = 0;
+    for (i = 0; i < frame_count; i++) {
+        t0 = performance.now();
+        for (j = 0; j < frame_objects; j++)
+            sum += make_cycle(j).next.data[1];
+        if (mode == "generational")
+            std.gcStep(step_budget_us);
+        times.push(performance.now() - t0);
+    }
+
+    counts = [];
+    for (i = 0; i <= buckets.length; i++)
+        counts.push(0);
+    for (i = 0; i < times.length; i++) {
+        for (j = 0; j < buckets.length && times[i] >= buckets[j]; j++)
+            continue;
+        counts[j]++;
+    }
+
+    sorted = times.slice().sort(function (a, b) { return a - b; });
+    print("mode: " + mode + ", retained objects: " + heap.length +
+          ", frames: " + frame_count);
+    for (i = 0; i <= buckets.length; i++) {
+        label = (i == 0 ? "0" : buckets[i - 1]) + ".." +
+            (i == buckets.length ? "" : buckets[i]) + " ms";
+        print(label.padStart(14) + " " + String(counts[i]).padStart(5));
+    }
+    print("p50 " + percentile(sorted, 0.5).toFixed(3) + " ms, p99 " +
+          percentile(sorted, 0.99).toFixed(3) + " ms, max " +
+          sorted[sorted.length - 1].toFixed(3) + " ms");
+    return sum;
+}
+
+main();
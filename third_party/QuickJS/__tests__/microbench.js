@@ -329,6 +329,45 @@ function prop_delete(n)
     return n * 20;
 }
 
+function object_alloc(n)
+{
+    var obj, j;
+    for(j = 0; j < n; j++) {
+        obj = { x: j, y: 1 };
+        obj = { x: j, y: 2, z: obj };
+    }
+    global_res = obj;
+    return n * 2;
+}
+
+function object_alloc_retained(n)
+{
+    var ring, j;
+    ring = [];
+    for(j = 0; j < 1024; j++) {
+        ring.push(null);
+    }
+    /* the objects survive 1024 iterations before being freed */
+    for(j = 0; j < n; j++) {
+        ring[j & 1023] = { id: j, pair: [j, j + 1] };
+    }
+    global_res = ring;
+    return n * 2;
+}
+
+function closure_alloc(n)
+{
+    var f, j, sum;
+    sum = 0;
+    for(j = 0; j < n; j++) {
+        let k = j;
+        f = function() { return k; };
+        sum += f();
+    }
+    global_res = sum;
+    return n;
+}
+
 function array_read(n)
 {
     var tab, len, sum, i, j;
@@ -1357,6 +1396,9 @@ function main(argc, argv, g)
         prop_create,
         prop_clone,
         prop_delete,
+        object_alloc,
+        object_alloc_retained,
+        closure_alloc,
         array_read,
         array_write,
         array_prop_create,
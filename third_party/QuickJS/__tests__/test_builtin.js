@@ -779,6 +779,54 @@ function test_regexp()
     /* Note: SpiderMonkey and v8 may not be correct */
     assert("abcAbC".replace(/[\q{BC|A}]/gvi,"X"), "XXXX");
     assert("abcAbC".replace(/[\q{BC|A}--a]/gvi,"X"), "aXAX");
+
+    /* test the prescan of the start positions */
+    assert("xxabcabd".replace(/ab(d)/, "[$1]"), "xxabc[d]");
+    assert("ab ab ab".replace(/ab/g, "X"), "X X X");
+    assert(/b{2}c/.exec("abbbbc").index, 3);
+    assert(/^abc/.exec("xabc"), null);
+    assert(/^abc/m.exec("x\nabc").index, 2);
+    a = /^a/g;
+    a.lastIndex = 1;
+    assert(a.exec("aa"), null);
+    a = /a/y;
+    a.lastIndex = 1;
+    assert(a.exec("aba"), null);
+    assert(/\d+px/.exec("width: 120px")[0], "120px");
+    assert(/[0-9]+x/.exec("12 34x")[0], "34x");
+    assert(/x\s*=\s*\d+;/.exec("a = 1; x = 2;")[0], "x = 2;");
+    assert(/\d*x/.exec("abx")[0], "x");
+    assert(/(a)?b/.exec("cab"), ["ab", "a"]);
+    assert(/(a)b|c/.exec("zzcab")[0], "c");
+    assert(/(?:ab)+c/.exec("ababababd"), null);
+    assert(/\u0101b/.exec("aab"), null);
+    assert(/\u0101b/.exec("a\u0101b").index, 1);
+    assert(/[\u0100-\u0200]/.exec("abc\u0150").index, 3);
+    assert(/k/i.exec("x\u212a"), null);
+    assert(/k/iu.exec("x\u212a").index, 1);
+    assert(/\u039c/i.exec("a\u00b5").index, 1);
+    assert(/[\u039c-\u039d]/i.exec("a\u00b5").index, 1);
+    assert(/[a-z]k/iu.exec("\u00e9A\u212a").index, 1);
+    assert(/\u{1f600}x/u.exec("a\u{1f600}\u{1f600}x").index, 3);
+    assert(/.x/u.exec("\u{1f600}x")[0], "\u{1f600}x");
+    assert(/\udc00/.exec("\ud800\udc00").index, 1);
+    assert(/\udc00/u.exec("\ud800\udc00"), null);
+    assert("\u4e2d\u6587abc".replace(/b/, "X"), "\u4e2d\u6587aXc");
+    assert(/(?<=a)b/.exec("abab").index, 1);
+    assert(/(?<x>f)oo/.exec("afoo").groups.x, "f");
+    assert("1a2b3".split(/[a-z]/).join(), "1,2,3");
+
+    /* the compiled regexps are shared but not the RegExp objects */
+    for(var i = 0; i < 3; i++) {
+        a = new RegExp("o+", "g");
+        a.lastIndex = 0;
+        assert("foo boo".replace(a, "0"), "f0 b0");
+        assert(new RegExp("o+", "gi").flags, "gi");
+        assert(new RegExp("o+").global, false);
+    }
+    a = new RegExp("o+", "g");
+    a.compile("x", "i");
+    assert(a.test("X") && !new RegExp("o+", "g").test("X"));
 }
 
 function test_symbol()
@@ -47,6 +47,17 @@ function test_worker()
                 let buf = ev.buf;
                 /* check that the SharedArrayBuffer was modified */
                 assert(buf[2], 10);
+                test_transfer();
+            }
+            break;
+        case "transfer_done":
+            {
+                let buf = ev.buf;
+                /* the buffer was transferred back */
+                assert(ev.sum, 1024 * 3);
+                assert(buf.length, 1024);
+                assert(buf[0], 4);
+                assert(buf.buffer.byteLength, 1024);
                 worker.postMessage({ type: "abort" });
             }
             break;
@@ -58,5 +69,39 @@ function test_worker()
     };
 }
 
+function assert_throws(expected_error, func)
+{
+    var err = false;
+    try {
+        func();
+    } catch(e) {
+        err = true;
+        if (!(e instanceof expected_error))
+            throw Error("unexpected exception type");
+    }
+    if (!err)
+        throw Error("expected exception");
+}
+
+function test_transfer()
+{
+    var ab = new ArrayBuffer(1024);
+    var buf = new Uint8Array(ab);
+    var copy = new Uint8Array(16);
+
+    buf.fill(3);
+    /* invalid transfer lists */
+    assert_throws(TypeError, () => worker.postMessage({}, [new SharedArrayBuffer(8)]));
+    assert_throws(TypeError, () => worker.postMessage({}, [ab, ab]));
+    assert_throws(TypeError, () => worker.postMessage({}, [copy]));
+    assert(ab.byteLength, 1024);
+
+    worker.postMessage({ type: "transfer", buf: buf, copy: copy }, [ab]);
+    /* the sender loses the contents */
+    assert(ab.byteLength, 0);
+    assert(buf.length, 0);
+    assert(copy.length, 16);
+    assert_throws(TypeError, () => worker.postMessage({}, [ab]));
+}
 
 test_worker();
@@ -17,6 +17,17 @@ function handle_msg(e) {
         ev.buf[2] = 10;
         parent.postMessage({ type: "sab_done", buf: ev.buf });
         break;
+    case "transfer":
+        {
+            /* read and modify the transferred buffer, then send it back */
+            let buf = ev.buf, sum = 0, i;
+            for(i = 0; i < buf.length; i++)
+                sum += buf[i];
+            buf[0] = 4;
+            parent.postMessage({ type: "transfer_done", buf: buf, sum: sum },
+                               [buf.buffer]);
+        }
+        break;
     }
 }
 
@@ -0,0 +1,90 @@
+/*
+ * Worker message passing benchmark
+ *
+ * Usage: qjs worker_bench.js [workers] [messages] [payload_bytes]
+ *
+ * Each worker of the pool echoes the messages it receives. The main
+ * thread keeps a few messages in flight per worker and reports the
+ * message rate and the payload throughput, the ArrayBuffer payload
+ * being either copied or transferred.
+ */
+import * as os from "os";
+
+var worker_count = +(scriptArgs[1] || 4);
+var message_count = +(scriptArgs[2] || 20000);
+var payload_sizes = scriptArgs[3] ? [+scriptArgs[3]] : [0, 4096, 65536, 1 << 20];
+var window_size = 16;
+/* limit the amount of data sent to each worker for the large payloads */
+var byte_budget = 256 << 20;
+var workers = [];
+
+function format_bytes(n) {
+    if (n >= (1 << 20))
+        return (n / (1 << 20)).toFixed(1) + " MB";
+    if (n >= 1024)
+        return (n / 1024).toFixed(1) + " KB";
+    return n + " B";
+}
+
+function run(size, transfer) {
+    return new Promise(function (resolve) {
+        var count, total, received, t0;
+
+        count = message_count;
+        if (size > 0)
+            count = Math.max(100, Math.min(count, Math.floor(byte_budget / size)));
+        total = count * worker_count;
+        received = 0;
+        t0 = os.now();
+
+        workers.forEach(function (w) {
+            var sent = 0, i;
+
+            function send(buf) {
+                var msg = { seq: sent++, transfer: transfer, buf: buf };
+                if (transfer)
+                    w.postMessage(msg, [buf]);
+                else
+                    w.postMessage(msg);
+            }
+
+            w.onmessage = function (e) {
+                var dt;
+                received++;
+                if (sent < count)
+                    send(e.data.buf);
+                if (received == total) {
+                    dt = (os.now() - t0) / 1000;
+                    print(format_bytes(size).padStart(9) + "  " +
+                          (size == 0 ? "-" : transfer ? "transfer" : "copy").padEnd(8) +
+                          String(total).padStart(8) + " msgs  " +
+                          Math.round(total / dt).toString().padStart(9) + " msgs/s  " +
+                          (total * size * 2 / dt / (1 << 20)).toFixed(1).padStart(9) +
+                          " MB/s");
+                    resolve();
+                }
+            };
+            for (i = 0; i < window_size && sent < count; i++)
+                send(size > 0 ? new ArrayBuffer(size) : null);
+        });
+    });
+}
+
+async function main() {
+    var i, size;
+
+    for (i = 0; i < worker_count; i++)
+        workers.push(new os.Worker("./worker_bench_module.js"));
+    print("workers: " + worker_count + ", in flight per worker: " + window_size);
+    for (size of payload_sizes) {
+        await run(size, false);
+        if (size > 0)
+            await run(size, true);
+    }
+    workers.forEach(function (w) {
+        w.postMessage({ exit: true });
+        w.onmessage = null;
+    });
+}
+
+main();
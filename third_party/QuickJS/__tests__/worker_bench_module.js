@@ -0,0 +1,15 @@
+/* Worker code for worker_bench.js */
+import * as os from "os";
+
+var parent = os.Worker.parent;
+
+parent.onmessage = function (e) {
+    var ev = e.data;
+    if (ev.exit) {
+        parent.onmessage = null; /* terminate the worker */
+    } else if (ev.transfer) {
+        parent.postMessage(ev, [ev.buf]);
+    } else {
+        parent.postMessage(ev);
+    }
+};
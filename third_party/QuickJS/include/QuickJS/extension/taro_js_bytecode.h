@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <string>
 
+#include "QuickJS/common.h"
+
 #ifdef CONFIG_BIGNUM
 #define BC_VERSION 0x45
 #else
@@ -29,6 +31,12 @@ typedef enum BCTagEnum {
   BC_TAG_DATE,
   BC_TAG_OBJECT_VALUE,
   BC_TAG_OBJECT_REFERENCE,
+  /* only in context snapshots (JS_WriteContextSnapshot) */
+  BC_TAG_INTRINSIC,
+  BC_TAG_SNAPSHOT_OBJECT,
+  BC_TAG_FUNCTION_REFERENCE,
+  /* ArrayBuffer contents moved with JS_WriteObjectTransfer() */
+  BC_TAG_ARRAY_BUFFER_TRANSFER,
 } BCTagEnum;
 
 int taro_bc_get_version();
@@ -40,6 +48,19 @@ int taro_bc_get_binary_version(const uint8_t* buf, size_t buf_len);
 int taro_bc_get_binary_compatible(std::string input);
 int taro_bc_get_binary_compatible(const uint8_t* buf, size_t buf_len);
 
+// Serialize what the scripts evaluated in 'ctx' added to it (globals,
+// objects, closures and their compiled functions). Builtins are matched by
+// path against 'base_ctx', which must be initialized like the contexts the
+// image is restored into; a default context is used if it is NULL.
+// Return an empty string and leave an exception in 'ctx' on error.
+std::string taro_js_write_context_snapshot(
+    JSContext* ctx,
+    JSContext* base_ctx = nullptr);
+
+// Restore an image of taro_js_write_context_snapshot() into a freshly
+// initialized context. Return -1 and leave an exception in 'ctx' on error.
+int taro_js_restore_context_snapshot(JSContext* ctx, const std::string& image);
+
 #ifdef DUMP_BYTECODE
 // Return a human-readable disassembly text for the given QuickJS bytecode buffer.
 std::string taro_js_dump_function_bytecode_bin(const uint8_t* buf, size_t buf_len);
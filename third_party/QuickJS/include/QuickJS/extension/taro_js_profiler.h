@@ -0,0 +1,69 @@
+#pragma once
+
+#include "QuickJS/common.h"
+
+#ifdef __cplusplus
+
+/* Sampling CPU profiler. The JS stack is sampled every 'interval_us'
+   microseconds while JS code runs. Starting the profiler discards the
+   previous profile. Return 0 if OK, -1 if memory error. */
+int taro_js_profiler_start(JSRuntime* rt, uint32_t interval_us = 1000);
+
+/* stop sampling, the profile stays available for the export */
+void taro_js_profiler_stop(JSRuntime* rt);
+
+/* release the profile and the functions it references */
+void taro_js_profiler_clear(JSRuntime* rt);
+
+uint32_t taro_js_profiler_sample_count(JSRuntime* rt);
+
+/* Chrome trace-event JSON string (Profile/ProfileChunk events) which can
+   be loaded in the DevTools performance panel or Perfetto. Return
+   JS_NULL if the profiler was not started. */
+JSValue taro_js_profiler_to_trace_event(JSContext* ctx);
+
+/* ArrayBuffer with the uncompressed pprof profile.proto message. Return
+   JS_NULL if the profiler was not started. */
+JSValue taro_js_profiler_to_pprof(JSContext* ctx);
+
+/* Allocation site heap profiler. While it is started, the new objects
+   and strings are tagged with the function and pc which allocated
+   them. Starting it discards the previous sites. Return 0 if OK, -1 if
+   memory error. */
+int taro_js_heap_profiler_start(JSRuntime* rt);
+
+/* stop tagging the allocations, the sites stay available */
+void taro_js_heap_profiler_stop(JSRuntime* rt);
+
+/* release the sites and the functions they reference */
+void taro_js_heap_profiler_clear(JSRuntime* rt);
+
+typedef struct TaroJSHeapSite {
+  const char* func_name;
+  const char* filename; /* NULL if unknown */
+  int line_num; /* 0 if unknown */
+  int col_num;
+  uint64_t alloc_count; /* allocations since the profiler was started */
+  uint64_t alloc_size;
+  uint32_t live_count; /* reachable objects and strings */
+  uint64_t self_size;
+  uint64_t retained_size; /* memory freed if the site objects were freed */
+} TaroJSHeapSite;
+
+typedef void
+TaroJSHeapSiteFunc(JSRuntime* rt, const TaroJSHeapSite* site, void* opaque);
+
+/* walk the heap to update the live and retained sizes, then call 'func'
+   for each site. The strings of 'site' are only valid during the
+   callback. Return -1 if memory error. */
+int taro_js_heap_profiler_for_each_site(
+    JSRuntime* rt,
+    TaroJSHeapSiteFunc* func,
+    void* opaque);
+
+/* V8 .heapsnapshot JSON string which can be loaded in the DevTools
+   memory panel. The nodes carry their allocation site when the heap
+   profiler is started. A GC is run first. */
+JSValue taro_js_take_heap_snapshot(JSContext* ctx);
+
+#endif
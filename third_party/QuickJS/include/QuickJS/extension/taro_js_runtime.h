@@ -18,4 +18,51 @@ JSValue taro_js_get_this(JSContext* ctx, JSValueConst thisVal);
 
 int taro_js_ref_count(JSValueConst val);
 
+/* inline cache states, see TaroJSInlineCacheSite */
+enum {
+  TARO_JS_IC_UNINITIALIZED,
+  TARO_JS_IC_MONOMORPHIC,
+  TARO_JS_IC_POLYMORPHIC,
+  TARO_JS_IC_MEGAMORPHIC,
+};
+
+/* A "site" is a (function, property name) pair, not a bytecode
+   position: the get/put instructions of a function which use the same
+   property name share one cache entry and its counters. */
+typedef struct TaroJSInlineCacheSite {
+  JSAtom func_name;
+  JSAtom filename;
+  JSAtom atom;
+  int state;
+  uint32_t transitions;
+  uint64_t hits;
+  uint64_t misses;
+} TaroJSInlineCacheSite;
+
+typedef struct TaroJSInlineCacheStats {
+  uint32_t site_count;
+  uint32_t state_count[TARO_JS_IC_MEGAMORPHIC + 1];
+  uint64_t transitions;
+  uint64_t hits;
+  uint64_t misses;
+} TaroJSInlineCacheStats;
+
+typedef void TaroJSInlineCacheSiteFunc(
+    JSRuntime* rt,
+    const TaroJSInlineCacheSite* site,
+    void* opaque);
+
+/* the atoms of 'site' are only valid during the callback */
+void taro_js_for_each_inline_cache_site(
+    JSRuntime* rt,
+    TaroJSInlineCacheSiteFunc* func,
+    void* opaque);
+
+void taro_js_get_inline_cache_stats(
+    JSRuntime* rt,
+    TaroJSInlineCacheStats* stats);
+
+/* clear the hit/miss/transition counters, the states are kept */
+void taro_js_reset_inline_cache_stats(JSRuntime* rt);
+
 #endif
@@ -37,6 +37,8 @@
 #define LRE_FLAG_NAMED_GROUPS \
   (1 << 7) /* named groups are present in the regexp */
 #define LRE_FLAG_UNICODE_SETS (1 << 8)
+#define LRE_FLAG_PRESCAN \
+  (1 << 9) /* prescan data follows the bytecode (internal) */
 
 #define LRE_RET_MEMORY_ERROR (-1)
 #define LRE_RET_TIMEOUT (-2)
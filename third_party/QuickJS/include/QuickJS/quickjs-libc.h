@@ -56,6 +56,8 @@ JSModuleDef* js_module_loader(
     const char* module_name,
     void* opaque,
     JSValueConst attributes);
+/* 'buf' is not copied and must stay valid while the functions read
+   from it are alive (e.g. the static array output by qjsc) */
 void js_std_eval_binary(
     JSContext* ctx,
     const uint8_t* buf,
@@ -155,6 +155,9 @@ void JS_TurnOffGC(JSRuntime* rt);
 void JS_TurnOnGC(JSRuntime* rt);
 /* use 0 to disable maximum stack size check */
 void JS_SetMaxStackSize(JSRuntime* rt, size_t stack_size);
+/* maximum number of compiled regexps kept for reuse by the RegExp
+   constructor and the parser. Use 0 to disable the cache. */
+void JS_SetRegExpCacheSize(JSRuntime* rt, int size);
 /* should be called when changing thread to update the stack top value
   used to check stack overflow. */
 void JS_UpdateStackTop(JSRuntime* rt);
@@ -165,6 +168,19 @@ void JS_SetRuntimeOpaque(JSRuntime* rt, void* opaque);
 typedef void JS_MarkFunc(JSRuntime* rt, JSGCObjectHeader* gp);
 void JS_MarkValue(JSRuntime* rt, JSValueConst val, JS_MarkFunc* mark_func);
 void JS_RunGC(JSRuntime* rt);
+/* Generational mode: the collections triggered by allocations only
+   scan the objects allocated since the previous collection (young
+   generation). The whole heap is scanned when the memory usage doubled
+   since the last full collection or when JS_RunGC() is called. The
+   full collections are not incremental: they scan the whole heap in a
+   single pause. */
+void JS_SetGCGenerational(JSRuntime* rt, JS_BOOL enable);
+/* Collect the cycles of the young generation in bounded slices until
+   'budget_us' microseconds elapsed. Only the young generation is
+   sliced. The cycles spanning several slices or reaching old objects
+   are left to the next full collection. Return TRUE if young objects
+   remain to be scanned. */
+JS_BOOL JS_RunGCStep(JSRuntime* rt, int64_t budget_us);
 
 JSContext* JS_NewContext(JSRuntime* rt);
 void JS_FreeContext(JSContext* s);
@@ -227,6 +243,8 @@ typedef struct JSMemoryUsage {
   int64_t c_func_count, array_count;
   int64_t fast_array_count, fast_array_elements;
   int64_t binary_object_count, binary_object_size;
+  int64_t slab_count, slab_size; /* pages of the slab allocator */
+  int64_t slab_used_count, slab_used_size; /* slots in use */
 } JSMemoryUsage;
 
 void JS_ComputeMemoryUsage(JSRuntime* rt, JSMemoryUsage* s);
@@ -843,17 +861,69 @@ uint8_t* JS_WriteObject2(
     int flags,
     uint8_t*** psab_tab,
     size_t* psab_tab_len);
+/* same as JS_WriteObject2() but the contents of the ArrayBuffers of
+   'transfer_list' are moved instead of copied: on success these
+   buffers are detached and '*ptransfer_tab' receives their contents
+   (one entry per 'transfer_list' item, array freed with js_free()). */
+uint8_t* JS_WriteObjectTransfer(
+    JSContext* ctx,
+    size_t* psize,
+    JSValueConst obj,
+    int flags,
+    uint8_t*** psab_tab,
+    size_t* psab_tab_len,
+    JSValueConst* transfer_list,
+    int transfer_len,
+    uint8_t*** ptransfer_tab);
 
 #define JS_READ_OBJ_BYTECODE (1 << 0) /* allow function/module */
 #define JS_READ_OBJ_ROM_DATA (1 << 1) /* avoid duplicating 'buf' data */
 #define JS_READ_OBJ_SAB (1 << 2) /* allow SharedArrayBuffer */
 #define JS_READ_OBJ_REFERENCE (1 << 3) /* allow object references */
+#define JS_READ_OBJ_LAZY (1 << 4) /* decode function bodies on first call */
 JSValue
 JS_ReadObject(JSContext* ctx, const uint8_t* buf, size_t buf_len, int flags);
+/* same as JS_ReadObject() but 'buf' is borrowed instead of copied: it
+   must stay valid (e.g. memory mapped) until 'free_func' is called,
+   which happens once no function read from it needs it any more. */
+JSValue JS_ReadObject2(
+    JSContext* ctx,
+    const uint8_t* buf,
+    size_t buf_len,
+    int flags,
+    JSFreeArrayBufferDataFunc* free_func,
+    void* opaque);
+/* read an object written by JS_WriteObjectTransfer(), possibly in
+   another runtime. The entries of 'transfer_tab' are always consumed
+   and set to NULL. */
+JSValue JS_ReadObjectTransfer(
+    JSContext* ctx,
+    const uint8_t* buf,
+    size_t buf_len,
+    int flags,
+    uint8_t** transfer_tab,
+    int transfer_len);
+/* free a transfer table which is not given to JS_ReadObjectTransfer() */
+void JS_FreeTransferTab(uint8_t** transfer_tab, int transfer_len);
 /* instantiate and evaluate a bytecode function. Only used when
   reading a script or module with JS_ReadObject() */
 JSValue JS_EvalFunction(JSContext* ctx, JSValue fun_obj);
 
+/* Context snapshot: serialize the global variables, objects, closures
+   and compiled functions which the scripts added to 'ctx'. The builtin
+   objects are not copied but referenced by their path from the global
+   object: they are matched against 'base_ctx', a context of the same
+   runtime initialized like the contexts the image is restored into
+   (NULL = default context). Return NULL in case of exception. */
+uint8_t*
+JS_WriteContextSnapshot(JSContext* ctx, size_t* psize, JSContext* base_ctx);
+/* restore an image of JS_WriteContextSnapshot() into a freshly
+   initialized context of any runtime. Return -1 in case of exception. */
+int JS_RestoreContextSnapshot(
+    JSContext* ctx,
+    const uint8_t* buf,
+    size_t buf_len);
+
 /* only exported for os.Worker() */
 JSAtom JS_GetScriptOrModuleName(JSContext* ctx, int n_stack_levels);
 /* only exported for os.Worker() */
@@ -24,6 +24,7 @@
  */
 
 #include "js-async-function.h"
+#include "../bytecode.h"
 #include "../common.h"
 #include "../exception.h"
 #include "../function.h"
@@ -48,6 +49,11 @@ JSAsyncFunctionState* async_func_init(
   JSStackFrame* sf;
   int local_count, i, arg_buf_len, n;
 
+  p = JS_VALUE_GET_OBJ(func_obj);
+  b = p->u.func.function_bytecode;
+  if (unlikely(b->is_lazy) && js_materialize_function_bytecode(ctx, b))
+    return NULL;
+
   s = js_mallocz(ctx, sizeof(*s));
   if (!s)
     return NULL;
@@ -56,8 +62,6 @@ JSAsyncFunctionState* async_func_init(
 
   sf = &s->frame;
   init_list_head(&sf->var_ref_list);
-  p = JS_VALUE_GET_OBJ(func_obj);
-  b = p->u.func.function_bytecode;
   sf->js_mode = b->js_mode | JS_MODE_ASYNC;
   sf->cur_pc = b->byte_code_buf;
   arg_buf_len = max_int(b->arg_count, argc);
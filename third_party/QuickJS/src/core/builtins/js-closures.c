@@ -27,6 +27,7 @@
 
 #include "../common.h"
 #include "../gc.h"
+#include "../malloc.h"
 #include "../object.h"
 #include "QuickJS/list.h"
 #include "js-async-function.h"
@@ -51,7 +52,7 @@ get_var_ref(JSContext* ctx, JSStackFrame* sf, int var_idx, BOOL is_arg) {
     }
   }
   /* create a new one */
-  var_ref = js_malloc(ctx, sizeof(JSVarRef));
+  var_ref = js_slab_alloc(ctx, sizeof(JSVarRef));
   if (!var_ref)
     return NULL;
   var_ref->header.ref_count = 1;
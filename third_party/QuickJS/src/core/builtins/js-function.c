@@ -24,6 +24,7 @@
  */
 
 #include "js-function.h"
+#include "../bytecode.h"
 #include "../convertion.h"
 #include "../exception.h"
 #include "../function.h"
@@ -90,7 +91,10 @@ void js_bytecode_function_mark(
     if (var_refs) {
       for (i = 0; i < b->closure_var_count; i++) {
         JSVarRef* var_ref = var_refs[i];
-        if (var_ref && var_ref->is_detached) {
+        /* the var_refs still on an async stack frame reference the
+           frame, so they must also be marked to free the cycles
+           going through a suspended generator or async function */
+        if (var_ref) {
           mark_func(rt, &var_ref->header);
         }
       }
@@ -454,6 +458,8 @@ JSValue js_function_toString(
   p = JS_VALUE_GET_OBJ(this_val);
   if (js_class_has_bytecode(p->class_id)) {
     JSFunctionBytecode* b = p->u.func.function_bytecode;
+    if (unlikely(b->is_lazy) && js_materialize_function_bytecode(ctx, b))
+      return JS_EXCEPTION;
     if (b->has_debug && b->debug.source) {
       return JS_NewStringLen(ctx, b->debug.source, b->debug.source_len);
     }
@@ -502,6 +508,8 @@ JSValue js_function_hasInstance(
 JSValue js_function_proto_fileName(JSContext* ctx, JSValueConst this_val) {
   JSFunctionBytecode* b = JS_GetFunctionBytecode(this_val);
   if (b && b->has_debug) {
+    if (unlikely(b->is_lazy) && js_materialize_function_bytecode(ctx, b))
+      return JS_EXCEPTION;
     return JS_AtomToString(ctx, b->debug.filename);
   }
   return JS_UNDEFINED;
@@ -511,6 +519,8 @@ JSValue js_function_proto_lineNumber(JSContext* ctx, JSValueConst this_val, int
   JSFunctionBytecode* b = JS_GetFunctionBytecode(this_val);
   if (b && b->has_debug) {
     int line_num, col_num;
+    if (unlikely(b->is_lazy) && js_materialize_function_bytecode(ctx, b))
+      return JS_EXCEPTION;
     line_num = find_line_num(ctx, b, -1, &col_num);
     if (is_col)
       return JS_NewInt32(ctx, col_num);
@@ -24,6 +24,7 @@
  */
 
 #include "js-json.h"
+#include <float.h>
 #include "../convertion.h"
 #include "../exception.h"
 #include "../function.h"
@@ -36,6 +37,18 @@
 #include "js-function.h"
 #include "js-object.h"
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define JSON_USE_SSE2
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define JSON_USE_AVX2
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define JSON_USE_NEON
+#endif
+
 /* JSON */
 
 int json_parse_expect(JSParseState* s, int tok) {
@@ -177,6 +190,583 @@ fail:
   return JS_EXCEPTION;
 }
 
+/* Return a pointer to the first byte of [p, end) which is a quote, a
+   backslash, a control character or, if 'stop_high' is set, a non ASCII
+   byte. Return 'end' if there is none. */
+static force_inline const uint8_t*
+json_scan_string(const uint8_t* p, const uint8_t* end, BOOL stop_high) {
+  int c;
+
+#if defined(JSON_USE_AVX2)
+  {
+    const __m256i quote = _mm256_set1_epi8('\"');
+    const __m256i bslash = _mm256_set1_epi8('\\');
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i ctrl = _mm256_set1_epi8(0x1f);
+    __m256i v, m;
+    uint32_t mask;
+
+    while (end - p >= 32) {
+      v = _mm256_loadu_si256((const __m256i*)p);
+      m = _mm256_or_si256(
+          _mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, bslash));
+      /* the signed comparison also matches the bytes >= 0x80 */
+      if (stop_high)
+        m = _mm256_or_si256(m, _mm256_cmpgt_epi8(space, v));
+      else
+        m = _mm256_or_si256(
+            m, _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl), v));
+      mask = _mm256_movemask_epi8(m);
+      if (mask)
+        return p + ctz32(mask);
+      p += 32;
+    }
+  }
+#elif defined(JSON_USE_SSE2)
+  {
+    const __m128i quote = _mm_set1_epi8('\"');
+    const __m128i bslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i ctrl = _mm_set1_epi8(0x1f);
+    __m128i v, m;
+    uint32_t mask;
+
+    while (end - p >= 16) {
+      v = _mm_loadu_si128((const __m128i*)p);
+      m = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, bslash));
+      /* the signed comparison also matches the bytes >= 0x80 */
+      if (stop_high)
+        m = _mm_or_si128(m, _mm_cmplt_epi8(v, space));
+      else
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v));
+      mask = _mm_movemask_epi8(m);
+      if (mask)
+        return p + ctz32(mask);
+      p += 16;
+    }
+  }
+#elif defined(JSON_USE_NEON)
+  {
+    uint8x16_t v, m;
+    uint64_t mask;
+
+    while (end - p >= 16) {
+      v = vld1q_u8(p);
+      m = vorrq_u8(
+          vceqq_u8(v, vdupq_n_u8('\"')), vceqq_u8(v, vdupq_n_u8('\\')));
+      if (stop_high)
+        m = vorrq_u8(m, vcltq_s8(vreinterpretq_s8_u8(v), vdupq_n_s8(' ')));
+      else
+        m = vorrq_u8(m, vcltq_u8(v, vdupq_n_u8(' ')));
+      /* 4 bits per byte */
+      mask = vget_lane_u64(
+          vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+      if (mask)
+        return p + (ctz64(mask) >> 2);
+      p += 16;
+    }
+  }
+#endif
+  while (p < end) {
+    c = *p;
+    if (c == '\"' || c == '\\' || c < 0x20 || (stop_high && c >= 0x80))
+      break;
+    p++;
+  }
+  return p;
+}
+
+static inline BOOL json_is_space(int c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static no_inline const uint8_t*
+json_skip_space_slow(const uint8_t* p, const uint8_t* end) {
+#if defined(JSON_USE_SSE2)
+  const __m128i sp = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const __m128i cr = _mm_set1_epi8('\r');
+  __m128i v, m;
+  uint32_t mask;
+
+  while (end - p >= 16) {
+    v = _mm_loadu_si128((const __m128i*)p);
+    m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab)),
+        _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+    mask = ~_mm_movemask_epi8(m) & 0xffff;
+    if (mask)
+      return p + ctz32(mask);
+    p += 16;
+  }
+#elif defined(JSON_USE_NEON)
+  uint8x16_t v, m;
+  uint64_t mask;
+
+  while (end - p >= 16) {
+    v = vld1q_u8(p);
+    m = vorrq_u8(
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\t'))),
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\r'))));
+    mask = ~vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+    if (mask)
+      return p + (ctz64(mask) >> 2);
+    p += 16;
+  }
+#endif
+  while (p < end && json_is_space(*p))
+    p++;
+  return p;
+}
+
+/* minified JSON has no whitespace at all: keep that test inline */
+static force_inline const uint8_t*
+json_skip_space(const uint8_t* p, const uint8_t* end) {
+  if (p < end && json_is_space(*p))
+    return json_skip_space_slow(p, end);
+  return p;
+}
+
+/* Dedicated parser for strict JSON. It works directly on the UTF-8 input
+   instead of going through the JS tokenizer. It never reports syntax
+   errors itself: on unexpected input it sets 'fallback' and the input is
+   parsed again with json_parse_value() so that the error messages stay
+   the same. */
+typedef struct JSONFastParseState {
+  JSContext* ctx;
+  const uint8_t* buf_ptr;
+  const uint8_t* buf_end;
+  /* elements of the arrays being parsed */
+  JSValue* values;
+  int values_len;
+  int values_size;
+  BOOL fallback;
+} JSONFastParseState;
+
+static const double json_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static JSValue json_fast_parse_value(JSONFastParseState* s);
+
+static JSValue json_fast_parse_string(JSONFastParseState* s) {
+  const uint8_t *p, *q, *p_next, *end;
+  StringBuffer b_s, *b = &b_s;
+  uint32_t c;
+  int i, h;
+
+  end = s->buf_end;
+  p = s->buf_ptr + 1;
+  q = json_scan_string(p, end, TRUE);
+  if (likely(q < end && *q == '\"')) {
+    s->buf_ptr = q + 1;
+    return js_new_string8_len(s->ctx, (const char*)p, q - p);
+  }
+  if (string_buffer_init(s->ctx, b, q - p + 16))
+    return JS_EXCEPTION;
+  for (;;) {
+    string_buffer_write8(b, p, q - p);
+    p = q;
+    if (p >= end)
+      goto fallback;
+    c = *p;
+    if (c == '\"') {
+      p++;
+      break;
+    } else if (c == '\\') {
+      if (end - p < 2)
+        goto fallback;
+      c = p[1];
+      p += 2;
+      switch (c) {
+        case 'b':
+          c = '\b';
+          break;
+        case 'f':
+          c = '\f';
+          break;
+        case 'n':
+          c = '\n';
+          break;
+        case 'r':
+          c = '\r';
+          break;
+        case 't':
+          c = '\t';
+          break;
+        case '\"':
+        case '\\':
+        case '/':
+          break;
+        case 'u':
+          if (end - p < 4)
+            goto fallback;
+          c = 0;
+          for (i = 0; i < 4; i++) {
+            h = from_hex(p[i]);
+            if (h < 0)
+              goto fallback;
+            c = (c << 4) | h;
+          }
+          p += 4;
+          break;
+        default:
+          goto fallback;
+      }
+    } else if (c >= 0x80) {
+      c = unicode_from_utf8(p, UTF8_CHAR_LEN_MAX, &p_next);
+      if (c > 0x10FFFF || p_next > end)
+        goto fallback;
+      p = p_next;
+    } else {
+      /* control character */
+      goto fallback;
+    }
+    string_buffer_putc(b, c);
+    q = json_scan_string(p, end, TRUE);
+  }
+  s->buf_ptr = p;
+  return string_buffer_end(b);
+fallback:
+  string_buffer_free(b);
+  s->fallback = TRUE;
+  return JS_EXCEPTION;
+}
+
+static JSAtom json_fast_parse_key(JSONFastParseState* s) {
+  const uint8_t *p, *q;
+  JSValue str;
+  JSAtom atom;
+
+  p = s->buf_ptr + 1;
+  q = json_scan_string(p, s->buf_end, TRUE);
+  if (likely(q < s->buf_end && *q == '\"')) {
+    /* JS_NewAtomLen() does not allocate for known ASCII names */
+    s->buf_ptr = q + 1;
+    return JS_NewAtomLen(s->ctx, (const char*)p, q - p);
+  }
+  str = json_fast_parse_string(s);
+  if (JS_IsException(str))
+    return JS_ATOM_NULL;
+  atom = JS_ValueToAtom(s->ctx, str);
+  JS_FreeValue(s->ctx, str);
+  return atom;
+}
+
+static JSValue json_fast_parse_number(JSONFastParseState* s) {
+  const uint8_t *p, *p_start, *end;
+  uint64_t mant;
+  int n_digits, exp10, e, e_sign;
+  BOOL neg, is_int;
+  double d;
+  JSATODTempMem atod_mem;
+
+  p = p_start = s->buf_ptr;
+  end = s->buf_end;
+  mant = 0;
+  n_digits = 0;
+  exp10 = 0;
+  neg = FALSE;
+  is_int = TRUE;
+  if (*p == '-') {
+    neg = TRUE;
+    p++;
+  }
+  if (p >= end || !is_digit(*p))
+    goto fallback;
+  if (*p == '0') {
+    p++;
+    if (p < end && is_digit(*p))
+      goto fallback;
+  } else {
+    do {
+      if (n_digits < 19)
+        mant = mant * 10 + (*p - '0');
+      n_digits++;
+      p++;
+    } while (p < end && is_digit(*p));
+  }
+  if (p < end && *p == '.') {
+    p++;
+    if (p >= end || !is_digit(*p))
+      goto fallback;
+    is_int = FALSE;
+    do {
+      if (n_digits < 19) {
+        mant = mant * 10 + (*p - '0');
+        exp10--;
+      }
+      n_digits++;
+      p++;
+    } while (p < end && is_digit(*p));
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    is_int = FALSE;
+    e_sign = 1;
+    if (p < end && (*p == '+' || *p == '-')) {
+      if (*p == '-')
+        e_sign = -1;
+      p++;
+    }
+    if (p >= end || !is_digit(*p))
+      goto fallback;
+    e = 0;
+    do {
+      if (e < 100000)
+        e = e * 10 + (*p - '0');
+      p++;
+    } while (p < end && is_digit(*p));
+    exp10 += e_sign * e;
+  }
+  s->buf_ptr = p;
+
+  if (is_int && n_digits <= 9) {
+    if (!neg)
+      return JS_NewInt32(s->ctx, (int32_t)mant);
+    else if (mant != 0)
+      return JS_NewInt32(s->ctx, -(int32_t)mant);
+    else
+      return JS_NewFloat64(s->ctx, -0.0);
+  }
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+  /* both operands are exact so the result is correctly rounded */
+  if (n_digits <= 19 && mant <= ((uint64_t)1 << 53) && exp10 >= -22 &&
+      exp10 <= 22) {
+    d = (double)mant;
+    if (exp10 < 0)
+      d /= json_pow10[-exp10];
+    else
+      d *= json_pow10[exp10];
+    return JS_NewFloat64(s->ctx, neg ? -d : d);
+  }
+#endif
+  d = js_atod((const char*)p_start, NULL, 10, 0, &atod_mem);
+  return JS_NewFloat64(s->ctx, d);
+fallback:
+  s->fallback = TRUE;
+  return JS_EXCEPTION;
+}
+
+static JSValue json_fast_parse_object(JSONFastParseState* s) {
+  JSContext* ctx = s->ctx;
+  const uint8_t* end = s->buf_end;
+  JSValue obj, val;
+  JSObject* p;
+  JSProperty* pr;
+  JSAtom atom;
+
+  if (js_check_stack_overflow(ctx->rt, 0)) {
+    s->fallback = TRUE;
+    return JS_EXCEPTION;
+  }
+  obj = JS_NewObject(ctx);
+  if (JS_IsException(obj))
+    return obj;
+  p = JS_VALUE_GET_OBJ(obj);
+  s->buf_ptr = json_skip_space(s->buf_ptr + 1, end);
+  if (s->buf_ptr < end && *s->buf_ptr == '}') {
+    s->buf_ptr++;
+    return obj;
+  }
+  for (;;) {
+    if (s->buf_ptr >= end || *s->buf_ptr != '\"')
+      goto fallback;
+    atom = json_fast_parse_key(s);
+    if (atom == JS_ATOM_NULL)
+      goto fail;
+    s->buf_ptr = json_skip_space(s->buf_ptr, end);
+    if (s->buf_ptr >= end || *s->buf_ptr != ':') {
+      JS_FreeAtom(ctx, atom);
+      goto fallback;
+    }
+    s->buf_ptr = json_skip_space(s->buf_ptr + 1, end);
+    val = json_fast_parse_value(s);
+    if (JS_IsException(val)) {
+      JS_FreeAtom(ctx, atom);
+      goto fail;
+    }
+    if (unlikely(find_own_property(&pr, p, atom))) {
+      /* duplicate name: the last value wins */
+      set_value(ctx, &pr->u.value, val);
+    } else {
+      pr = add_property(ctx, p, atom, JS_PROP_C_W_E);
+      if (!pr) {
+        JS_FreeValue(ctx, val);
+        JS_FreeAtom(ctx, atom);
+        goto fail;
+      }
+      pr->u.value = val;
+    }
+    JS_FreeAtom(ctx, atom);
+    s->buf_ptr = json_skip_space(s->buf_ptr, end);
+    if (s->buf_ptr >= end)
+      goto fallback;
+    if (*s->buf_ptr == '}') {
+      s->buf_ptr++;
+      return obj;
+    }
+    if (*s->buf_ptr != ',')
+      goto fallback;
+    s->buf_ptr = json_skip_space(s->buf_ptr + 1, end);
+  }
+fallback:
+  s->fallback = TRUE;
+fail:
+  JS_FreeValue(ctx, obj);
+  return JS_EXCEPTION;
+}
+
+static JSValue json_fast_parse_array(JSONFastParseState* s) {
+  JSContext* ctx = s->ctx;
+  const uint8_t* end = s->buf_end;
+  JSValue arr, val;
+  JSObject* p;
+  int base, len;
+
+  if (js_check_stack_overflow(ctx->rt, 0)) {
+    s->fallback = TRUE;
+    return JS_EXCEPTION;
+  }
+  /* the elements are accumulated in 's->values' so that the array is
+     allocated once with its final size */
+  base = s->values_len;
+  s->buf_ptr = json_skip_space(s->buf_ptr + 1, end);
+  if (s->buf_ptr < end && *s->buf_ptr == ']') {
+    s->buf_ptr++;
+  } else {
+    for (;;) {
+      val = json_fast_parse_value(s);
+      if (JS_IsException(val))
+        goto fail;
+      if (js_resize_array(
+              ctx,
+              (void**)&s->values,
+              sizeof(s->values[0]),
+              &s->values_size,
+              s->values_len + 1)) {
+        JS_FreeValue(ctx, val);
+        goto fail;
+      }
+      s->values[s->values_len++] = val;
+      s->buf_ptr = json_skip_space(s->buf_ptr, end);
+      if (s->buf_ptr >= end)
+        goto fallback;
+      if (*s->buf_ptr == ']') {
+        s->buf_ptr++;
+        break;
+      }
+      if (*s->buf_ptr != ',')
+        goto fallback;
+      s->buf_ptr = json_skip_space(s->buf_ptr + 1, end);
+    }
+  }
+  len = s->values_len - base;
+  arr = js_allocate_fast_array(ctx, len);
+  if (JS_IsException(arr))
+    goto fail;
+  if (len > 0) {
+    p = JS_VALUE_GET_OBJ(arr);
+    memcpy(p->u.array.u.values, s->values + base, sizeof(JSValue) * len);
+    p->prop[0].u.value = JS_NewInt32(ctx, len);
+    s->values_len = base;
+  }
+  return arr;
+fallback:
+  s->fallback = TRUE;
+fail:
+  while (s->values_len > base)
+    JS_FreeValue(ctx, s->values[--s->values_len]);
+  return JS_EXCEPTION;
+}
+
+static JSValue json_fast_parse_value(JSONFastParseState* s) {
+  const uint8_t* p = s->buf_ptr;
+  size_t len = s->buf_end - p;
+
+  if (unlikely(len == 0))
+    goto fallback;
+  switch (*p) {
+    case '{':
+      return json_fast_parse_object(s);
+    case '[':
+      return json_fast_parse_array(s);
+    case '\"':
+      return json_fast_parse_string(s);
+    case '-':
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+      return json_fast_parse_number(s);
+    case 't':
+      if (len >= 4 && !memcmp(p, "true", 4)) {
+        s->buf_ptr = p + 4;
+        return JS_NewBool(s->ctx, TRUE);
+      }
+      break;
+    case 'f':
+      if (len >= 5 && !memcmp(p, "false", 5)) {
+        s->buf_ptr = p + 5;
+        return JS_NewBool(s->ctx, FALSE);
+      }
+      break;
+    case 'n':
+      if (len >= 4 && !memcmp(p, "null", 4)) {
+        s->buf_ptr = p + 4;
+        return JS_NULL;
+      }
+      break;
+    default:
+      break;
+  }
+fallback:
+  s->fallback = TRUE;
+  return JS_EXCEPTION;
+}
+
+/* Return JS_EXCEPTION with '*pfallback' set if the input must be parsed
+   again by the generic parser. */
+static JSValue json_fast_parse(
+    JSContext* ctx,
+    const char* buf,
+    size_t buf_len,
+    BOOL* pfallback) {
+  JSONFastParseState s1, *s = &s1;
+  JSValue val;
+
+  s->ctx = ctx;
+  s->buf_ptr = (const uint8_t*)buf;
+  s->buf_end = s->buf_ptr + buf_len;
+  s->values = NULL;
+  s->values_len = 0;
+  s->values_size = 0;
+  s->fallback = FALSE;
+
+  s->buf_ptr = json_skip_space(s->buf_ptr, s->buf_end);
+  val = json_fast_parse_value(s);
+  if (!JS_IsException(val)) {
+    s->buf_ptr = json_skip_space(s->buf_ptr, s->buf_end);
+    if (s->buf_ptr != s->buf_end) {
+      JS_FreeValue(ctx, val);
+      val = JS_EXCEPTION;
+      s->fallback = TRUE;
+    }
+  }
+  js_free(ctx, s->values);
+  *pfallback = s->fallback;
+  return val;
+}
+
 JSValue JS_ParseJSON2(
     JSContext* ctx,
     const char* buf,
@@ -185,7 +775,14 @@ JSValue JS_ParseJSON2(
     int flags) {
   JSParseState s1, *s = &s1;
   JSValue val = JS_UNDEFINED;
+  BOOL fallback;
 
+  if (!(flags & JS_PARSE_JSON_EXT) && buf_len <= JS_STRING_LEN_MAX) {
+    val = json_fast_parse(ctx, buf, buf_len, &fallback);
+    if (!fallback)
+      return val;
+    val = JS_UNDEFINED;
+  }
   js_parse_init(ctx, s, buf, buf_len, filename);
   s->ext_json = ((flags & JS_PARSE_JSON_EXT) != 0);
   if (json_next_token(s))
@@ -592,6 +1189,295 @@ exception:
   return -1;
 }
 
+/* Fast path of JSON.stringify() when there is no replacer: plain objects
+   with data properties, dense arrays and primitive values are written
+   directly to the string buffer. Anything else (toJSON methods,
+   accessors, exotic objects, cycles...) makes it give up, in which case
+   js_json_to_str() restarts from scratch. Since the fast path has no
+   side effects, restarting is always safe. */
+
+#define JSON_FAST_MAX_DEPTH 64
+
+typedef struct JSONFastStringifyState {
+  JSContext* ctx;
+  StringBuffer* b;
+  JSString* gap; /* NULL if no indentation */
+  /* prototypes whose chain is known to have no 'toJSON' property */
+  JSObject* proto_ok[2];
+  JSObject* stack[JSON_FAST_MAX_DEPTH];
+  int depth;
+} JSONFastStringifyState;
+
+static int json_fast_to_str(JSONFastStringifyState* s, JSValueConst val);
+
+static void json_fast_escape(StringBuffer* b, int c) {
+  char buf[8];
+
+  switch (c) {
+    case '\t':
+      c = 't';
+      goto quote;
+    case '\r':
+      c = 'r';
+      goto quote;
+    case '\n':
+      c = 'n';
+      goto quote;
+    case '\b':
+      c = 'b';
+      goto quote;
+    case '\f':
+      c = 'f';
+      goto quote;
+    case '\"':
+    case '\\':
+    quote:
+      string_buffer_putc8(b, '\\');
+      string_buffer_putc8(b, c);
+      break;
+    default:
+      snprintf(buf, sizeof(buf), "\\u%04x", c);
+      string_buffer_puts8(b, buf);
+      break;
+  }
+}
+
+static void json_fast_quote8(StringBuffer* b, const JSString* str) {
+  const uint8_t *p, *q, *end;
+
+  p = str->u.str8;
+  end = p + str->len;
+  string_buffer_putc8(b, '\"');
+  for (;;) {
+    q = json_scan_string(p, end, FALSE);
+    string_buffer_write8(b, p, q - p);
+    if (q >= end)
+      break;
+    json_fast_escape(b, *q);
+    p = q + 1;
+  }
+  string_buffer_putc8(b, '\"');
+}
+
+/* same output as JS_ToQuotedString() but the unescaped runs are copied
+   at once */
+static void json_fast_quote16(StringBuffer* b, const JSString* str) {
+  const uint16_t *p, *q, *end;
+  int c;
+
+  p = q = str->u.str16;
+  end = p + str->len;
+  string_buffer_putc8(b, '\"');
+  while (q < end) {
+    c = *q;
+    if (c >= 0x20 && c != '\"' && c != '\\' && !is_surrogate(c)) {
+      q++;
+    } else if (
+        is_hi_surrogate(c) && end - q >= 2 && is_lo_surrogate(q[1])) {
+      q += 2;
+    } else {
+      string_buffer_write16(b, p, q - p);
+      json_fast_escape(b, c);
+      p = ++q;
+    }
+  }
+  string_buffer_write16(b, p, q - p);
+  string_buffer_putc8(b, '\"');
+}
+
+static int json_fast_quote(JSONFastStringifyState* s, JSValueConst str) {
+  JSString* p;
+
+  if (JS_VALUE_GET_TAG(str) != JS_TAG_STRING)
+    return string_buffer_concat_value_free(
+        s->b, JS_ToQuotedString(s->ctx, str));
+  p = JS_VALUE_GET_STRING(str);
+  if (p->is_wide_char)
+    json_fast_quote16(s->b, p);
+  else
+    json_fast_quote8(s->b, p);
+  return 0;
+}
+
+static void json_fast_indent(JSONFastStringifyState* s, int depth) {
+  int i;
+
+  string_buffer_putc8(s->b, '\n');
+  for (i = 0; i < depth; i++)
+    string_buffer_concat(s->b, s->gap, 0, s->gap->len);
+}
+
+/* Return TRUE if reading 'toJSON' from an object whose prototype is
+   'proto' can be skipped. */
+static BOOL json_fast_check_proto(JSONFastStringifyState* s, JSObject* proto) {
+  JSObject* p;
+
+  if (proto == s->proto_ok[0] || proto == s->proto_ok[1])
+    return TRUE;
+  for (p = proto; p != NULL; p = p->shape->proto) {
+    if (p->class_id != JS_CLASS_OBJECT && p->class_id != JS_CLASS_ARRAY)
+      return FALSE;
+    if (find_own_property1(p, JS_ATOM_toJSON))
+      return FALSE;
+  }
+  s->proto_ok[1] = s->proto_ok[0];
+  s->proto_ok[0] = proto;
+  return TRUE;
+}
+
+static BOOL json_fast_enter(JSONFastStringifyState* s, JSObject* p) {
+  int i;
+
+  if (s->depth >= JSON_FAST_MAX_DEPTH ||
+      js_check_stack_overflow(s->ctx->rt, 0))
+    return FALSE;
+  /* a cycle is reported by js_json_to_str() */
+  for (i = 0; i < s->depth; i++) {
+    if (s->stack[i] == p)
+      return FALSE;
+  }
+  if (find_own_property1(p, JS_ATOM_toJSON) ||
+      !json_fast_check_proto(s, p->shape->proto))
+    return FALSE;
+  s->stack[s->depth++] = p;
+  return TRUE;
+}
+
+static int json_fast_object_to_str(JSONFastStringifyState* s, JSObject* p) {
+  JSRuntime* rt = s->ctx->rt;
+  JSShape* sh;
+  JSShapeProperty* prs;
+  JSAtomStruct* name;
+  JSValueConst v;
+  uint32_t i, idx;
+  BOOL has_content;
+  int tag, ret;
+
+  if (!json_fast_enter(s, p))
+    return 1;
+  sh = p->shape;
+  has_content = FALSE;
+  string_buffer_putc8(s->b, '{');
+  for (i = 0, prs = get_shape_prop(sh); i < sh->prop_count; i++, prs++) {
+    if (prs->atom == JS_ATOM_NULL || !(prs->flags & JS_PROP_ENUMERABLE))
+      continue;
+    if ((prs->flags & JS_PROP_TMASK) != JS_PROP_NORMAL)
+      return 1;
+    /* array indexes are enumerated first */
+    if (__JS_AtomIsTaggedInt(prs->atom))
+      return 1;
+    name = rt->atom_array[prs->atom];
+    if (name->atom_type != JS_ATOM_TYPE_STRING)
+      continue;
+    if (is_num_string(&idx, name) && idx != -1)
+      return 1;
+    v = p->prop[i].u.value;
+    tag = JS_VALUE_GET_TAG(v);
+    if (tag == JS_TAG_UNDEFINED || tag == JS_TAG_SYMBOL)
+      continue;
+    if (has_content)
+      string_buffer_putc8(s->b, ',');
+    if (s->gap)
+      json_fast_indent(s, s->depth);
+    if (name->is_wide_char)
+      json_fast_quote16(s->b, name);
+    else
+      json_fast_quote8(s->b, name);
+    string_buffer_putc8(s->b, ':');
+    if (s->gap)
+      string_buffer_putc8(s->b, ' ');
+    ret = json_fast_to_str(s, v);
+    if (ret)
+      return ret;
+    has_content = TRUE;
+  }
+  if (has_content && s->gap)
+    json_fast_indent(s, s->depth - 1);
+  string_buffer_putc8(s->b, '}');
+  s->depth--;
+  return 0;
+}
+
+static int json_fast_array_to_str(JSONFastStringifyState* s, JSObject* p) {
+  JSValueConst v;
+  uint32_t i, len;
+  int tag, ret;
+
+  len = p->u.array.count;
+  /* elements past 'count' would be read from the prototype */
+  if (JS_VALUE_GET_TAG(p->prop[0].u.value) != JS_TAG_INT ||
+      JS_VALUE_GET_INT(p->prop[0].u.value) != len)
+    return 1;
+  if (!json_fast_enter(s, p))
+    return 1;
+  string_buffer_putc8(s->b, '[');
+  for (i = 0; i < len; i++) {
+    if (i > 0)
+      string_buffer_putc8(s->b, ',');
+    if (s->gap)
+      json_fast_indent(s, s->depth);
+    v = p->u.array.u.values[i];
+    tag = JS_VALUE_GET_TAG(v);
+    if (tag == JS_TAG_UNDEFINED || tag == JS_TAG_SYMBOL) {
+      string_buffer_puts8(s->b, "null");
+    } else {
+      ret = json_fast_to_str(s, v);
+      if (ret)
+        return ret;
+    }
+  }
+  if (len > 0 && s->gap)
+    json_fast_indent(s, s->depth - 1);
+  string_buffer_putc8(s->b, ']');
+  s->depth--;
+  return 0;
+}
+
+/* Return 0 if OK, -1 if exception, 1 if js_json_to_str() must be used */
+static int json_fast_to_str(JSONFastStringifyState* s, JSValueConst val) {
+  JSObject* p;
+  JSDTOATempMem dtoa_mem;
+  /* enough for the radix 10 free format */
+  char buf[32];
+  double d;
+  int len;
+
+  switch (JS_VALUE_GET_NORM_TAG(val)) {
+    case JS_TAG_STRING:
+    case JS_TAG_STRING_ROPE:
+      return json_fast_quote(s, val);
+    case JS_TAG_INT:
+      len = i32toa(buf, JS_VALUE_GET_INT(val));
+      string_buffer_write8(s->b, (const uint8_t*)buf, len);
+      return 0;
+    case JS_TAG_FLOAT64:
+      d = JS_VALUE_GET_FLOAT64(val);
+      if (!isfinite(d)) {
+        string_buffer_puts8(s->b, "null");
+      } else {
+        len = js_dtoa(buf, d, 10, 0, JS_DTOA_FORMAT_FREE, &dtoa_mem);
+        string_buffer_write8(s->b, (const uint8_t*)buf, len);
+      }
+      return 0;
+    case JS_TAG_BOOL:
+      string_buffer_puts8(s->b, JS_VALUE_GET_BOOL(val) ? "true" : "false");
+      return 0;
+    case JS_TAG_NULL:
+      string_buffer_puts8(s->b, "null");
+      return 0;
+    case JS_TAG_OBJECT:
+      p = JS_VALUE_GET_OBJ(val);
+      if (p->class_id == JS_CLASS_OBJECT)
+        return json_fast_object_to_str(s, p);
+      if (p->class_id == JS_CLASS_ARRAY && p->fast_array)
+        return json_fast_array_to_str(s, p);
+      /* functions, wrappers, proxies, ... */
+      return 1;
+    default:
+      return 1;
+  }
+}
+
 JSValue JS_JSONStringify(
     JSContext* ctx,
     JSValueConst obj,
@@ -713,6 +1599,29 @@ JSValue JS_JSONStringify(
     ret = JS_UNDEFINED;
     goto done1;
   }
+  if (JS_IsUndefined(jsc->replacer_func) &&
+      JS_IsUndefined(jsc->property_list)) {
+    JSONFastStringifyState fs_s, *fs = &fs_s;
+
+    fs->ctx = ctx;
+    fs->b = jsc->b;
+    fs->gap = JS_IsEmptyString(jsc->gap) ? NULL : JS_VALUE_GET_STRING(jsc->gap);
+    fs->proto_ok[0] = fs->proto_ok[1] = NULL;
+    fs->depth = 0;
+    res = json_fast_to_str(fs, val);
+    if (res == 0) {
+      JS_FreeValue(ctx, val);
+      ret = string_buffer_end(jsc->b);
+      goto done;
+    }
+    if (res < 0 || jsc->b->error_status) {
+      JS_FreeValue(ctx, val);
+      goto exception;
+    }
+    /* restart with the generic version */
+    string_buffer_free(jsc->b);
+    string_buffer_init(ctx, jsc->b, 0);
+  }
   if (js_json_to_str(ctx, jsc, wrapper, val, jsc->empty))
     goto exception;
 
@@ -26,8 +26,25 @@
 #ifndef QUICKJS_JS_MAP_H
 #define QUICKJS_JS_MAP_H
 
+#include "../types.h"
 #include "QuickJS/quickjs.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+JSValue js_map_constructor(
+    JSContext* ctx,
+    JSValueConst new_target,
+    int argc,
+    JSValueConst* argv,
+    int magic);
+JSValue js_map_set(
+    JSContext* ctx,
+    JSValueConst this_val,
+    int argc,
+    JSValueConst* argv,
+    int magic);
 void map_delete_weakrefs(JSRuntime* rt, JSWeakRefHeader* wh);
 JSValue js_object_groupBy(
     JSContext* ctx,
@@ -36,4 +53,8 @@ JSValue js_object_groupBy(
     JSValueConst* argv,
     int is_map);
 
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
 #endif
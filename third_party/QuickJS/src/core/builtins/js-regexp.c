@@ -50,9 +50,119 @@ void js_regexp_finalizer(JSRuntime* rt, JSValue val) {
   JS_FreeValueRT(rt, JS_MKPTR(JS_TAG_STRING, re->pattern));
 }
 
+/* Compiled RegExp cache: the bytecode of the recently compiled
+   patterns is shared by the RegExp objects with the same source and
+   flags (new RegExp() in functions, eval of the same code...). */
+
+#define JS_REGEXP_CACHE_HASH_SIZE 128
+
+typedef struct JSRegExpCacheEntry {
+  struct list_head link; /* LRU order, most recently used first */
+  struct JSRegExpCacheEntry* hash_next;
+  uint32_t hash;
+  int re_flags;
+  JSString* pattern;
+  JSString* bytecode;
+} JSRegExpCacheEntry;
+
+typedef struct JSRegExpCache {
+  struct list_head lru;
+  int count;
+  JSRegExpCacheEntry* hash[JS_REGEXP_CACHE_HASH_SIZE];
+} JSRegExpCache;
+
+static JSRegExpCacheEntry* js_regexp_cache_find(
+    JSRegExpCache* rc,
+    JSString* p,
+    int re_flags,
+    uint32_t h) {
+  JSRegExpCacheEntry* e;
+
+  for (e = rc->hash[h % JS_REGEXP_CACHE_HASH_SIZE]; e != NULL;
+       e = e->hash_next) {
+    if (e->hash == h && e->re_flags == re_flags && e->pattern->len == p->len &&
+        js_string_memcmp(e->pattern, 0, p, 0, p->len) == 0)
+      return e;
+  }
+  return NULL;
+}
+
+static void js_regexp_cache_remove(JSRuntime* rt, JSRegExpCacheEntry* e) {
+  JSRegExpCache* rc = rt->regexp_cache;
+  JSRegExpCacheEntry** pe;
+
+  for (pe = &rc->hash[e->hash % JS_REGEXP_CACHE_HASH_SIZE]; *pe != e;
+       pe = &(*pe)->hash_next)
+    continue;
+  *pe = e->hash_next;
+  list_del(&e->link);
+  rc->count--;
+  JS_FreeValueRT(rt, JS_MKPTR(JS_TAG_STRING, e->pattern));
+  JS_FreeValueRT(rt, JS_MKPTR(JS_TAG_STRING, e->bytecode));
+  js_free_rt(rt, e);
+}
+
+/* evict the least recently used entries above 'size' */
+static void js_regexp_cache_trim(JSRuntime* rt, int size) {
+  JSRegExpCache* rc = rt->regexp_cache;
+
+  if (!rc)
+    return;
+  while (rc->count > size) {
+    js_regexp_cache_remove(
+        rt, list_entry(rc->lru.prev, JSRegExpCacheEntry, link));
+  }
+}
+
+/* the cache is best effort: nothing is cached if out of memory */
+static void js_regexp_cache_add(
+    JSRuntime* rt,
+    JSString* p,
+    int re_flags,
+    uint32_t h,
+    JSValueConst bc) {
+  JSRegExpCache* rc = rt->regexp_cache;
+  JSRegExpCacheEntry* e;
+
+  if (!rc) {
+    rc = js_mallocz_rt(rt, sizeof(*rc));
+    if (!rc)
+      return;
+    init_list_head(&rc->lru);
+    rt->regexp_cache = rc;
+  }
+  js_regexp_cache_trim(rt, rt->regexp_cache_size - 1);
+  e = js_malloc_rt(rt, sizeof(*e));
+  if (!e)
+    return;
+  e->hash = h;
+  e->re_flags = re_flags;
+  JS_DupValueRT(rt, JS_MKPTR(JS_TAG_STRING, p));
+  e->pattern = p;
+  e->bytecode = JS_VALUE_GET_STRING(JS_DupValueRT(rt, bc));
+  e->hash_next = rc->hash[h % JS_REGEXP_CACHE_HASH_SIZE];
+  rc->hash[h % JS_REGEXP_CACHE_HASH_SIZE] = e;
+  list_add(&e->link, &rc->lru);
+  rc->count++;
+}
+
+void js_regexp_cache_free(JSRuntime* rt) {
+  js_regexp_cache_trim(rt, 0);
+  js_free_rt(rt, rt->regexp_cache);
+  rt->regexp_cache = NULL;
+}
+
+void JS_SetRegExpCacheSize(JSRuntime* rt, int size) {
+  if (size < 0)
+    size = 0;
+  rt->regexp_cache_size = size;
+  js_regexp_cache_trim(rt, size);
+}
+
 /* create a string containing the RegExp bytecode */
 JSValue
 js_compile_regexp(JSContext* ctx, JSValueConst pattern, JSValueConst flags) {
+  JSRuntime* rt = ctx->rt;
   const char* str;
   int re_flags, mask;
   uint8_t* re_bytecode_buf;
@@ -60,6 +170,10 @@ js_compile_regexp(JSContext* ctx, JSValueConst pattern, JSValueConst flags) {
   int re_bytecode_len;
   JSValue ret;
   char error_msg[64];
+  JSString* p;
+  JSRegExpCacheEntry* e;
+  uint32_t h;
+  BOOL use_cache;
 
   re_flags = 0;
   if (!JS_IsUndefined(flags)) {
@@ -112,6 +226,23 @@ js_compile_regexp(JSContext* ctx, JSValueConst pattern, JSValueConst flags) {
     return JS_ThrowSyntaxError(ctx, "invalid regular expression flags");
   }
 
+  p = NULL;
+  h = 0;
+  use_cache = rt->regexp_cache_size > 0 &&
+      JS_VALUE_GET_TAG(pattern) == JS_TAG_STRING;
+  if (use_cache) {
+    p = JS_VALUE_GET_STRING(pattern);
+    h = hash_string(p, re_flags);
+    if (rt->regexp_cache) {
+      e = js_regexp_cache_find(rt->regexp_cache, p, re_flags, h);
+      if (e) {
+        list_del(&e->link);
+        list_add(&e->link, &rt->regexp_cache->lru);
+        return JS_DupValue(ctx, JS_MKPTR(JS_TAG_STRING, e->bytecode));
+      }
+    }
+  }
+
   str = JS_ToCStringLen2(
       ctx,
       &len,
@@ -129,6 +260,8 @@ js_compile_regexp(JSContext* ctx, JSValueConst pattern, JSValueConst flags) {
 
   ret = js_new_string8_len(ctx, (const char*)re_bytecode_buf, re_bytecode_len);
   js_free(ctx, re_bytecode_buf);
+  if (use_cache && !JS_IsException(ret))
+    js_regexp_cache_add(rt, p, re_flags, h, ret);
   return ret;
 }
 
@@ -28,8 +28,16 @@
 
 #include "QuickJS/quickjs.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* default number of entries of the compiled RegExp cache */
+#define JS_REGEXP_CACHE_SIZE_DEFAULT 64
+
 JSValue
 js_compile_regexp(JSContext* ctx, JSValueConst pattern, JSValueConst flags);
+void js_regexp_cache_free(JSRuntime* rt);
 JSValue js_regexp_constructor_internal(
     JSContext* ctx,
     JSValueConst ctor,
@@ -47,4 +55,8 @@ JSValue js_regexp_toString(
     int argc,
     JSValueConst* argv);
 
+#ifdef __cplusplus
+} /* extern "C" { */
+#endif
+
 #endif
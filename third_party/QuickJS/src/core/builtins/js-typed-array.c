@@ -252,14 +252,10 @@ JSValue js_array_buffer_get_byteLength(
   return JS_NewUint32(ctx, abuf->byte_length);
 }
 
-void JS_DetachArrayBuffer(JSContext* ctx, JSValueConst obj) {
-  JSArrayBuffer* abuf = JS_GetOpaque(obj, JS_CLASS_ARRAY_BUFFER);
+/* the contents of 'abuf' must have been freed or moved elsewhere */
+static void js_array_buffer_detach(JSArrayBuffer* abuf) {
   struct list_head* el;
 
-  if (!abuf || abuf->detached)
-    return;
-  if (abuf->free_func)
-    abuf->free_func(ctx->rt, abuf->opaque, abuf->data);
   abuf->data = NULL;
   abuf->byte_length = 0;
   abuf->detached = TRUE;
@@ -278,6 +274,68 @@ void JS_DetachArrayBuffer(JSContext* ctx, JSValueConst obj) {
   }
 }
 
+void JS_DetachArrayBuffer(JSContext* ctx, JSValueConst obj) {
+  JSArrayBuffer* abuf = JS_GetOpaque(obj, JS_CLASS_ARRAY_BUFFER);
+
+  if (!abuf || abuf->detached)
+    return;
+  if (abuf->free_func)
+    abuf->free_func(ctx->rt, abuf->opaque, abuf->data);
+  js_array_buffer_detach(abuf);
+}
+
+/* contents coming from another runtime (see js_array_buffer_adopt()) */
+static void js_array_buffer_free_transferred(
+    JSRuntime* rt,
+    void* opaque,
+    void* ptr) {
+  free(ptr);
+}
+
+/* Detach the ArrayBuffer 'obj' and return its contents as a malloc()
+   block which can be given to js_array_buffer_adopt() in any runtime.
+   The data is moved instead of copied when it comes from the default
+   allocator. Return NULL if exception. */
+uint8_t* js_array_buffer_transfer(JSContext* ctx, JSValueConst obj) {
+  JSArrayBuffer* abuf = JS_GetOpaque(obj, JS_CLASS_ARRAY_BUFFER);
+  uint8_t* data;
+
+  if (!abuf || abuf->detached) {
+    JS_ThrowTypeErrorDetachedArrayBuffer(ctx);
+    return NULL;
+  }
+  if ((abuf->free_func == js_array_buffer_free &&
+       js_malloc_rt_release(ctx->rt, abuf->data)) ||
+      abuf->free_func == js_array_buffer_free_transferred) {
+    data = abuf->data;
+  } else {
+    data = malloc(max_int(abuf->byte_length, 1));
+    if (!data) {
+      JS_ThrowOutOfMemory(ctx);
+      return NULL;
+    }
+    memcpy(data, abuf->data, abuf->byte_length);
+    if (abuf->free_func)
+      abuf->free_func(ctx->rt, abuf->opaque, abuf->data);
+  }
+  js_array_buffer_detach(abuf);
+  return data;
+}
+
+/* create an ArrayBuffer owning 'data', a block returned by
+   js_array_buffer_transfer(). 'data' is freed in case of exception. */
+JSValue js_array_buffer_adopt(JSContext* ctx, uint8_t* data, size_t len) {
+  JSFreeArrayBufferDataFunc* free_func = js_array_buffer_free_transferred;
+  JSValue obj;
+
+  if (js_malloc_rt_adopt(ctx->rt, data))
+    free_func = js_array_buffer_free;
+  obj = JS_NewArrayBuffer(ctx, data, len, free_func, NULL, FALSE);
+  if (JS_IsException(obj))
+    free_func(ctx->rt, NULL, data);
+  return obj;
+}
+
 /* get an ArrayBuffer or SharedArrayBuffer */
 JSArrayBuffer* js_get_array_buffer(JSContext* ctx, JSValueConst obj) {
   JSObject* p;
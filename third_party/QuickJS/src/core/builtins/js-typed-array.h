@@ -59,6 +59,8 @@ int js_typed_array_get_length_internal(JSContext* ctx, JSValueConst obj);
 JSArrayBuffer* js_get_array_buffer(JSContext* ctx, JSValueConst obj);
 BOOL typed_array_is_detached(JSContext* ctx, JSObject* p);
 JSValue JS_ThrowTypeErrorDetachedArrayBuffer(JSContext* ctx);
+uint8_t* js_array_buffer_transfer(JSContext* ctx, JSValueConst obj);
+JSValue js_array_buffer_adopt(JSContext* ctx, uint8_t* data, size_t len);
 
 JSValue js_array_from_iterator(
     JSContext* ctx,
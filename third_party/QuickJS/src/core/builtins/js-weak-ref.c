@@ -26,6 +26,7 @@
 #include "js-weak-ref.h"
 
 #include "../common.h"
+#include "../malloc.h"
 #include "../runtime.h"
 #include "../types.h"
 
@@ -66,7 +67,7 @@ void js_weakref_free(JSRuntime* rt, JSValue val) {
        free_zero_refcount() */
     if (p->weakref_count == 0 && p->header.ref_count == 0 &&
         p->header.mark == 0) {
-      js_free_rt(rt, p);
+      js_slab_free_rt(rt, p, sizeof(JSObject));
     }
   } else if (JS_VALUE_GET_TAG(val) == JS_TAG_SYMBOL) {
     JSString* p = JS_VALUE_GET_STRING(val);
@@ -28,7 +28,9 @@
 #include "QuickJS/extension/taro_js_bytecode.h"
 #include "builtins/js-big-num.h"
 #include "builtins/js-function.h"
+#include "builtins/js-map.h"
 #include "builtins/js-object.h"
+#include "builtins/js-regexp.h"
 #include "builtins/js-typed-array.h"
 #include "exception.h"
 #include "function.h"
@@ -47,6 +49,37 @@
   __android_log_print(ANDROID_LOG_INFO, "QuickJS", __VA_ARGS__)
 #endif
 
+/* Binary image shared by the functions read from it with
+   JS_READ_OBJ_LAZY. The atom table is resolved on demand and kept here
+   so that the function bodies can be decoded later. */
+typedef struct JSBytecodeSource {
+  int ref_count;
+  const uint8_t* buf;
+  size_t buf_len;
+  JSFreeArrayBufferDataFunc* free_func;
+  void* opaque;
+  uint32_t first_atom;
+  uint32_t idx_to_atom_count;
+  JSAtom* idx_to_atom; /* JS_ATOM_NULL if not resolved yet */
+  uint32_t* atom_offsets; /* offset of each atom string in 'buf' */
+} JSBytecodeSource;
+
+static void free_bytecode_source(JSRuntime* rt, JSBytecodeSource* src) {
+  uint32_t i;
+
+  if (--src->ref_count > 0)
+    return;
+  if (src->idx_to_atom) {
+    for (i = 0; i < src->idx_to_atom_count; i++)
+      JS_FreeAtomRT(rt, src->idx_to_atom[i]);
+    js_free_rt(rt, src->idx_to_atom);
+  }
+  js_free_rt(rt, src->atom_offsets);
+  if (src->free_func)
+    src->free_func(rt, src->opaque, (void*)src->buf);
+  js_free_rt(rt, src);
+}
+
 void free_function_bytecode(JSRuntime* rt, JSFunctionBytecode* b) {
   int i;
 
@@ -57,7 +90,10 @@ void free_function_bytecode(JSRuntime* rt, JSFunctionBytecode* b) {
                JS_AtomGetStrRT(rt, buf, sizeof(buf), b->func_name));
     }
 #endif
-  free_bytecode_atoms(rt, b->byte_code_buf, b->byte_code_len, TRUE);
+  if (!b->is_lazy)
+    free_bytecode_atoms(rt, b->byte_code_buf, b->byte_code_len, TRUE);
+  if (b->byte_code_allocated)
+    js_free_rt(rt, b->byte_code_buf);
   if (b->ic != NULL)
     free_ic(b->ic);
 
@@ -86,6 +122,8 @@ void free_function_bytecode(JSRuntime* rt, JSFunctionBytecode* b) {
       js_free_rt(rt, b->debugger.breakpoints);
 #endif
   }
+  if (b->source)
+    free_bytecode_source(rt, b->source);
 
   remove_gc_object(&b->header);
   if (rt->gc_phase == JS_GC_PHASE_REMOVE_CYCLES && b->header.ref_count != 0) {
@@ -135,6 +173,36 @@ void free_bytecode_atoms(
 /*******************************************************************/
 /* binary object writer & reader */
 
+/* context snapshots: builtin object reached by following 'kind' from
+   the 'parent' entry (a root if parent < 0) */
+typedef enum {
+  BC_INTRINSIC_GLOBAL_OBJ,
+  BC_INTRINSIC_GLOBAL_VAR_OBJ,
+  BC_INTRINSIC_CLASS_PROTO, /* 'atom' is the class ID */
+  BC_INTRINSIC_VALUE,
+  BC_INTRINSIC_GETTER,
+  BC_INTRINSIC_SETTER,
+  BC_INTRINSIC_PROTO,
+} BCIntrinsicKindEnum;
+
+typedef struct BCIntrinsic {
+  JSObject* base_obj; /* same builtin in the base context */
+  int parent;
+  uint8_t kind;
+  JSAtom atom;
+} BCIntrinsic;
+
+/* property kinds of the snapshot objects, stored with the JS_PROP_C_W_E
+   flags */
+typedef enum {
+  BC_PROP_VALUE,
+  BC_PROP_GETSET,
+  BC_PROP_PROTOTYPE, /* function 'prototype' not instantiated yet */
+  BC_PROP_DELETED, /* builtin property deleted by the scripts */
+} BCPropKindEnum;
+
+#define BC_PROP_KIND_SHIFT 3
+
 typedef struct BCWriterState {
   JSContext* ctx;
   DynBuf dbuf;
@@ -152,6 +220,19 @@ typedef struct BCWriterState {
   int sab_tab_size;
   /* list of referenced objects (used if allow_reference = TRUE) */
   JSObjectList object_list;
+  /* context snapshot (JS_WriteContextSnapshot) */
+  BOOL is_snapshot : 8;
+  JSContext* base_ctx;
+  JSObjectList intrinsic_list; /* builtins of 'ctx' found in 'base_ctx' */
+  BCIntrinsic* intrinsics; /* same indexes as intrinsic_list */
+  int intrinsics_size;
+  /* the JSVarRef and JSFunctionBytecode pointers are only used as keys */
+  JSObjectList var_ref_list;
+  JSObjectList bytecode_list;
+  /* ArrayBuffers whose contents are moved (JS_WriteObjectTransfer) */
+  JSObject** transfer_objs;
+  BOOL* transfer_written;
+  int transfer_len;
 } BCWriterState;
 
 #ifdef DUMP_READ_OBJECT
@@ -176,6 +257,10 @@ static const char* const bc_tag_str[] = {
     "Date",
     "ObjectValue",
     "ObjectReference",
+    "Intrinsic",
+    "SnapshotObject",
+    "FunctionReference",
+    "ArrayBufferTransfer",
 };
 #endif
 
@@ -444,6 +529,9 @@ static int JS_WriteFunctionTag(BCWriterState* s, JSValueConst obj) {
   uint32_t flags;
   int idx, i;
 
+  if (b->is_lazy && js_materialize_function_bytecode(s->ctx, b))
+    return -1;
+
   bc_put_u8(s, BC_TAG_FUNCTION_BYTECODE);
   flags = idx = 0;
   bc_set_flags(&flags, &idx, b->has_prototype, 1);
@@ -680,10 +768,28 @@ static int JS_WriteTypedArray(BCWriterState* s, JSValueConst obj) {
 static int JS_WriteArrayBuffer(BCWriterState* s, JSValueConst obj) {
   JSObject* p = JS_VALUE_GET_OBJ(obj);
   JSArrayBuffer* abuf = p->u.array_buffer;
+  int i;
+
   if (abuf->detached) {
     JS_ThrowTypeErrorDetachedArrayBuffer(s->ctx);
     return -1;
   }
+  for (i = 0; i < s->transfer_len; i++) {
+    if (s->transfer_objs[i] == p) {
+      /* without object references, a second occurrence would have
+         no contents left */
+      if (s->transfer_written[i]) {
+        JS_ThrowTypeError(s->ctx, "transferred ArrayBuffer used twice");
+        return -1;
+      }
+      s->transfer_written[i] = TRUE;
+      /* the contents are given in the transfer table */
+      bc_put_u8(s, BC_TAG_ARRAY_BUFFER_TRANSFER);
+      bc_put_leb128(s, abuf->byte_length);
+      bc_put_leb128(s, i);
+      return 0;
+    }
+  }
   bc_put_u8(s, BC_TAG_ARRAY_BUFFER);
   bc_put_leb128(s, abuf->byte_length);
   dbuf_put(&s->dbuf, abuf->data, abuf->byte_length);
@@ -710,6 +816,623 @@ static int JS_WriteSharedArrayBuffer(BCWriterState* s, JSValueConst obj) {
   return 0;
 }
 
+/* context snapshot writer */
+
+static BOOL bc_snapshot_class_supported(int class_id) {
+  switch (class_id) {
+    case JS_CLASS_OBJECT:
+    case JS_CLASS_ARRAY:
+    case JS_CLASS_ERROR:
+    case JS_CLASS_NUMBER:
+    case JS_CLASS_STRING:
+    case JS_CLASS_BOOLEAN:
+    case JS_CLASS_BIG_INT:
+    case JS_CLASS_DATE:
+    case JS_CLASS_REGEXP:
+    case JS_CLASS_MAP:
+    case JS_CLASS_SET:
+    case JS_CLASS_BYTECODE_FUNCTION:
+    case JS_CLASS_GENERATOR_FUNCTION:
+    case JS_CLASS_ASYNC_FUNCTION:
+    case JS_CLASS_ASYNC_GENERATOR_FUNCTION:
+      return TRUE;
+    default:
+      return FALSE;
+  }
+}
+
+/* check that 'p' was not replaced by the scripts */
+static BOOL bc_snapshot_same_builtin(JSObject* p, JSObject* bp) {
+  JSShapeProperty* prs;
+  int i;
+
+  if (p->class_id != bp->class_id)
+    return FALSE;
+  switch (p->class_id) {
+    case JS_CLASS_C_FUNCTION:
+      return p->u.cfunc.c_function.generic == bp->u.cfunc.c_function.generic &&
+          p->u.cfunc.magic == bp->u.cfunc.magic;
+    case JS_CLASS_OBJECT:
+      /* an object defined by the scripts (e.g. a polyfill) usually lacks
+         some properties of the builtin one */
+      prs = get_shape_prop(bp->shape);
+      for (i = 0; i < bp->shape->prop_count; i++, prs++) {
+        if (prs->atom != JS_ATOM_NULL && !find_own_property1(p, prs->atom))
+          return FALSE;
+      }
+      return TRUE;
+    default:
+      return TRUE;
+  }
+}
+
+static int bc_snapshot_add_intrinsic(
+    BCWriterState* s,
+    JSObject* p,
+    JSObject* bp,
+    int parent,
+    int kind,
+    JSAtom atom) {
+  BCIntrinsic* e;
+  int idx;
+
+  if (js_object_list_find(s->ctx, &s->intrinsic_list, p) >= 0 ||
+      !bc_snapshot_same_builtin(p, bp))
+    return 0;
+  idx = s->intrinsic_list.object_count;
+  if (js_resize_array(
+          s->ctx,
+          (void**)&s->intrinsics,
+          sizeof(s->intrinsics[0]),
+          &s->intrinsics_size,
+          idx + 1))
+    return -1;
+  e = &s->intrinsics[idx];
+  e->base_obj = bp;
+  e->parent = parent;
+  e->kind = kind;
+  e->atom = atom;
+  return js_object_list_add(s->ctx, &s->intrinsic_list, p);
+}
+
+/* find the property 'atom' of the base object 'bp', instantiating it if
+   it is lazy */
+static int bc_snapshot_find_base_prop(
+    BCWriterState* s,
+    JSShapeProperty** pprs,
+    JSProperty** ppr,
+    JSObject* bp,
+    JSAtom atom) {
+  JSPropertyDescriptor desc;
+  JSShapeProperty* prs;
+
+  prs = find_own_property(ppr, bp, atom);
+  if (prs && (prs->flags & JS_PROP_TMASK) == JS_PROP_AUTOINIT) {
+    if (JS_GetOwnPropertyInternal(s->base_ctx, &desc, bp, atom) < 0) {
+      JS_Throw(s->ctx, JS_GetException(s->base_ctx));
+      return -1;
+    }
+    js_free_desc(s->base_ctx, &desc);
+    prs = find_own_property(ppr, bp, atom);
+  }
+  *pprs = prs;
+  return 0;
+}
+
+/* match the builtin objects of 'ctx' with the ones of the base context
+   by walking both object graphs from the same roots */
+static int bc_snapshot_build_intrinsics(BCWriterState* s) {
+  JSContext *ctx = s->ctx, *base_ctx = s->base_ctx;
+  JSObject *p, *bp;
+  JSShapeProperty *prs, *bprs;
+  JSProperty *pr, *bpr;
+  JSAtom atom;
+  int i, j, class_id;
+
+  if (bc_snapshot_add_intrinsic(
+          s,
+          JS_VALUE_GET_OBJ(ctx->global_obj),
+          JS_VALUE_GET_OBJ(base_ctx->global_obj),
+          -1,
+          BC_INTRINSIC_GLOBAL_OBJ,
+          0) ||
+      bc_snapshot_add_intrinsic(
+          s,
+          JS_VALUE_GET_OBJ(ctx->global_var_obj),
+          JS_VALUE_GET_OBJ(base_ctx->global_var_obj),
+          -1,
+          BC_INTRINSIC_GLOBAL_VAR_OBJ,
+          0))
+    return -1;
+  for (class_id = 0; class_id < ctx->rt->class_count; class_id++) {
+    if (JS_IsObject(ctx->class_proto[class_id]) &&
+        JS_IsObject(base_ctx->class_proto[class_id]) &&
+        bc_snapshot_add_intrinsic(
+            s,
+            JS_VALUE_GET_OBJ(ctx->class_proto[class_id]),
+            JS_VALUE_GET_OBJ(base_ctx->class_proto[class_id]),
+            -1,
+            BC_INTRINSIC_CLASS_PROTO,
+            class_id))
+      return -1;
+  }
+
+  /* breadth first so that the paths are as short as possible */
+  for (i = 0; i < s->intrinsic_list.object_count; i++) {
+    p = s->intrinsic_list.object_tab[i].obj;
+    bp = s->intrinsics[i].base_obj;
+    if (p->shape->proto && bp->shape->proto &&
+        bc_snapshot_add_intrinsic(
+            s,
+            p->shape->proto,
+            bp->shape->proto,
+            i,
+            BC_INTRINSIC_PROTO,
+            JS_ATOM_NULL))
+      return -1;
+    /* the shape of 'bp' may be modified by bc_snapshot_find_base_prop() */
+    for (j = 0; j < bp->shape->prop_count; j++) {
+      atom = get_shape_prop(bp->shape)[j].atom;
+      if (atom == JS_ATOM_NULL)
+        continue;
+      prs = find_own_property(&pr, p, atom);
+      if (!prs)
+        continue;
+      switch (prs->flags & JS_PROP_TMASK) {
+        case JS_PROP_NORMAL:
+          if (!JS_IsObject(pr->u.value))
+            break;
+          if (bc_snapshot_find_base_prop(s, &bprs, &bpr, bp, atom))
+            return -1;
+          if ((bprs->flags & JS_PROP_TMASK) == JS_PROP_NORMAL &&
+              JS_IsObject(bpr->u.value) &&
+              bc_snapshot_add_intrinsic(
+                  s,
+                  JS_VALUE_GET_OBJ(pr->u.value),
+                  JS_VALUE_GET_OBJ(bpr->u.value),
+                  i,
+                  BC_INTRINSIC_VALUE,
+                  atom))
+            return -1;
+          break;
+        case JS_PROP_GETSET:
+          bprs = find_own_property(&bpr, bp, atom);
+          if ((bprs->flags & JS_PROP_TMASK) != JS_PROP_GETSET)
+            break;
+          if (pr->u.getset.getter && bpr->u.getset.getter &&
+              bc_snapshot_add_intrinsic(
+                  s,
+                  pr->u.getset.getter,
+                  bpr->u.getset.getter,
+                  i,
+                  BC_INTRINSIC_GETTER,
+                  atom))
+            return -1;
+          if (pr->u.getset.setter && bpr->u.getset.setter &&
+              bc_snapshot_add_intrinsic(
+                  s,
+                  pr->u.getset.setter,
+                  bpr->u.getset.setter,
+                  i,
+                  BC_INTRINSIC_SETTER,
+                  atom))
+            return -1;
+          break;
+        default:
+          /* lazy properties were not modified */
+          break;
+      }
+    }
+  }
+  return 0;
+}
+
+static BOOL bc_snapshot_same_object(BCWriterState* s, JSObject* p, JSObject* bp) {
+  int idx;
+
+  if (!p || !bp)
+    return p == bp;
+  idx = js_object_list_find(s->ctx, &s->intrinsic_list, p);
+  return idx >= 0 && s->intrinsics[idx].base_obj == bp;
+}
+
+/* return TRUE if the property of the builtin object differs from the
+   one of the base object 'bp' */
+static int bc_snapshot_prop_modified(
+    BCWriterState* s,
+    JSObject* bp,
+    JSShapeProperty* prs,
+    JSProperty* pr) {
+  JSShapeProperty* bprs;
+  JSProperty* bpr;
+  const int mask = JS_PROP_TMASK | JS_PROP_C_W_E;
+
+  if ((prs->flags & JS_PROP_TMASK) == JS_PROP_AUTOINIT)
+    return FALSE;
+  if (bc_snapshot_find_base_prop(s, &bprs, &bpr, bp, prs->atom))
+    return -1;
+  if (!bprs || (prs->flags & mask) != (bprs->flags & mask))
+    return TRUE;
+  switch (prs->flags & JS_PROP_TMASK) {
+    case JS_PROP_NORMAL:
+      if (JS_IsObject(pr->u.value) && JS_IsObject(bpr->u.value)) {
+        return !bc_snapshot_same_object(
+            s, JS_VALUE_GET_OBJ(pr->u.value), JS_VALUE_GET_OBJ(bpr->u.value));
+      } else if (JS_IsObject(pr->u.value) || JS_IsObject(bpr->u.value)) {
+        return TRUE;
+      }
+      return !JS_SameValue(s->ctx, pr->u.value, bpr->u.value);
+    case JS_PROP_GETSET:
+      return !bc_snapshot_same_object(
+                 s, pr->u.getset.getter, bpr->u.getset.getter) ||
+          !bc_snapshot_same_object(s, pr->u.getset.setter, bpr->u.getset.setter);
+    default:
+      return FALSE;
+  }
+}
+
+static int JS_WriteSnapshotProp(
+    BCWriterState* s,
+    JSShapeProperty* prs,
+    JSProperty* pr) {
+  JSAtom atom = prs->atom;
+  int flags = prs->flags & JS_PROP_C_W_E;
+  JSObject *getter, *setter;
+
+  if (!__JS_AtomIsTaggedInt(atom) && atom >= JS_ATOM_END &&
+      !JS_AtomIsString(s->ctx, atom)) {
+    JS_ThrowTypeError(s->ctx, "unsupported symbol property");
+    return -1;
+  }
+  switch (prs->flags & JS_PROP_TMASK) {
+    case JS_PROP_NORMAL:
+      bc_put_atom(s, atom);
+      bc_put_u8(s, (BC_PROP_VALUE << BC_PROP_KIND_SHIFT) | flags);
+      return JS_WriteObjectRec(s, pr->u.value);
+    case JS_PROP_GETSET:
+      getter = pr->u.getset.getter;
+      setter = pr->u.getset.setter;
+      bc_put_atom(s, atom);
+      bc_put_u8(s, (BC_PROP_GETSET << BC_PROP_KIND_SHIFT) | flags);
+      if (JS_WriteObjectRec(
+              s, getter ? JS_MKPTR(JS_TAG_OBJECT, getter) : JS_UNDEFINED))
+        return -1;
+      return JS_WriteObjectRec(
+          s, setter ? JS_MKPTR(JS_TAG_OBJECT, setter) : JS_UNDEFINED);
+    case JS_PROP_AUTOINIT:
+      if (js_autoinit_get_id(pr) == JS_AUTOINIT_ID_PROTOTYPE) {
+        bc_put_atom(s, atom);
+        bc_put_u8(s, (BC_PROP_PROTOTYPE << BC_PROP_KIND_SHIFT) | flags);
+        return 0;
+      }
+      /* fall through */
+    default:
+      JS_ThrowTypeError(s->ctx, "unsupported property kind");
+      return -1;
+  }
+}
+
+static int JS_WriteSnapshotProps(BCWriterState* s, JSObject* p) {
+  JSShapeProperty* prs;
+  uint32_t prop_count;
+  int i;
+
+  /* the length of the arrays is written separately */
+  prop_count = 0;
+  prs = get_shape_prop(p->shape);
+  for (i = 0; i < p->shape->prop_count; i++, prs++) {
+    if (prs->atom != JS_ATOM_NULL && !(prs->flags & JS_PROP_LENGTH))
+      prop_count++;
+  }
+  bc_put_leb128(s, prop_count);
+  prs = get_shape_prop(p->shape);
+  for (i = 0; i < p->shape->prop_count; i++, prs++) {
+    if (prs->atom != JS_ATOM_NULL && !(prs->flags & JS_PROP_LENGTH)) {
+      if (JS_WriteSnapshotProp(s, prs, &p->prop[i]))
+        return -1;
+    }
+  }
+  return 0;
+}
+
+static void bc_put_intrinsic_path(BCWriterState* s, int idx) {
+  BCIntrinsic* e = &s->intrinsics[idx];
+
+  if (e->parent >= 0)
+    bc_put_intrinsic_path(s, e->parent);
+  bc_put_u8(s, e->kind);
+  switch (e->kind) {
+    case BC_INTRINSIC_CLASS_PROTO:
+      bc_put_leb128(s, e->atom);
+      break;
+    case BC_INTRINSIC_VALUE:
+    case BC_INTRINSIC_GETTER:
+    case BC_INTRINSIC_SETTER:
+      bc_put_atom(s, e->atom);
+      break;
+    default:
+      break;
+  }
+}
+
+/* return TRUE if the builtin object 'p' has a property which is not in
+   the base object 'bp' or differs from it */
+static int bc_snapshot_props_modified(BCWriterState* s, JSObject* p, JSObject* bp) {
+  JSShapeProperty* prs;
+  int i, ret;
+
+  for (i = 0; i < p->shape->prop_count; i++) {
+    prs = &get_shape_prop(p->shape)[i];
+    if (prs->atom == JS_ATOM_NULL)
+      continue;
+    ret = bc_snapshot_prop_modified(s, bp, prs, &p->prop[i]);
+    if (ret)
+      return ret;
+  }
+  return FALSE;
+}
+
+/* return TRUE if a property of the base object 'bp' was deleted from the
+   builtin object 'p' */
+static BOOL bc_snapshot_props_deleted(JSObject* p, JSObject* bp) {
+  JSShapeProperty* bprs;
+  int i;
+
+  for (i = 0; i < bp->shape->prop_count; i++) {
+    bprs = &get_shape_prop(bp->shape)[i];
+    if (bprs->atom != JS_ATOM_NULL && !find_own_property1(p, bprs->atom))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/* a builtin object is written as its path followed by the properties
+   which the scripts added, modified or deleted */
+static int JS_WriteIntrinsic(BCWriterState* s, JSObject* p, int idx) {
+  JSObject* bp = s->intrinsics[idx].base_obj;
+  uint32_t* tab = NULL;
+  JSAtom* deleted = NULL;
+  int i, prop_count, deleted_count, n, ret;
+
+  n = 0;
+  for (i = idx; i >= 0; i = s->intrinsics[i].parent)
+    n++;
+  bc_put_u8(s, BC_TAG_INTRINSIC);
+  bc_put_leb128(s, n);
+  bc_put_intrinsic_path(s, idx);
+  bc_put_u8(s, p->extensible);
+  if (js_object_list_add(s->ctx, &s->object_list, p))
+    return -1;
+
+  if (p->shape->prop_count != 0) {
+    tab = (uint32_t*)js_malloc(s->ctx, sizeof(tab[0]) * p->shape->prop_count);
+    if (!tab)
+      return -1;
+  }
+  prop_count = 0;
+  for (i = 0; i < p->shape->prop_count; i++) {
+    JSShapeProperty* prs = &get_shape_prop(p->shape)[i];
+    if (prs->atom == JS_ATOM_NULL)
+      continue;
+    ret = bc_snapshot_prop_modified(s, bp, prs, &p->prop[i]);
+    if (ret < 0)
+      goto fail;
+    if (ret)
+      tab[prop_count++] = i;
+  }
+  /* the shape of 'bp' is not modified while the properties are written */
+  deleted_count = 0;
+  if (bc_snapshot_props_deleted(p, bp)) {
+    deleted =
+        (JSAtom*)js_malloc(s->ctx, sizeof(deleted[0]) * bp->shape->prop_count);
+    if (!deleted)
+      goto fail;
+    for (i = 0; i < bp->shape->prop_count; i++) {
+      JSAtom atom = get_shape_prop(bp->shape)[i].atom;
+      if (atom != JS_ATOM_NULL && !find_own_property1(p, atom))
+        deleted[deleted_count++] = atom;
+    }
+  }
+  bc_put_leb128(s, prop_count + deleted_count);
+  for (i = 0; i < prop_count; i++) {
+    if (JS_WriteSnapshotProp(
+            s, &get_shape_prop(p->shape)[tab[i]], &p->prop[tab[i]]))
+      goto fail;
+  }
+  for (i = 0; i < deleted_count; i++) {
+    bc_put_atom(s, deleted[i]);
+    bc_put_u8(s, BC_PROP_DELETED << BC_PROP_KIND_SHIFT);
+  }
+  js_free(s->ctx, deleted);
+  js_free(s->ctx, tab);
+  return 0;
+fail:
+  js_free(s->ctx, deleted);
+  js_free(s->ctx, tab);
+  return -1;
+}
+
+/* the builtins which are not reachable from the global objects, such as
+   String.prototype, or which were reached through an unmodified property
+   and written as a bare path, are written if the scripts modified them */
+static int JS_WriteModifiedIntrinsics(BCWriterState* s) {
+  int* tab = NULL;
+  int i, count, ret;
+  JSObject *p, *bp;
+
+  count = 0;
+  if (s->intrinsic_list.object_count != 0) {
+    tab = (int*)js_malloc(
+        s->ctx, sizeof(tab[0]) * s->intrinsic_list.object_count);
+    if (!tab)
+      return -1;
+  }
+  for (i = 0; i < s->intrinsic_list.object_count; i++) {
+    p = s->intrinsic_list.object_tab[i].obj;
+    bp = s->intrinsics[i].base_obj;
+    if (js_object_list_find(s->ctx, &s->object_list, p) >= 0)
+      continue;
+    ret = p->extensible != bp->extensible;
+    if (!ret)
+      ret = bc_snapshot_props_modified(s, p, bp);
+    if (ret < 0)
+      goto fail;
+    if (ret || bc_snapshot_props_deleted(p, bp))
+      tab[count++] = i;
+  }
+  bc_put_leb128(s, count);
+  /* an entry written while writing a previous one is a reference */
+  for (i = 0; i < count; i++) {
+    p = s->intrinsic_list.object_tab[tab[i]].obj;
+    if (JS_WriteObjectRec(s, JS_MKPTR(JS_TAG_OBJECT, p)))
+      goto fail;
+  }
+  js_free(s->ctx, tab);
+  return 0;
+fail:
+  js_free(s->ctx, tab);
+  return -1;
+}
+
+static int JS_WriteSnapshotVarRef(BCWriterState* s, JSVarRef* var_ref) {
+  int idx;
+
+  if (!var_ref->is_detached) {
+    JS_ThrowTypeError(s->ctx, "cannot snapshot a running function");
+    return -1;
+  }
+  /* the variables shared by several closures are written once */
+  idx = js_object_list_find(s->ctx, &s->var_ref_list, (JSObject*)var_ref);
+  if (idx >= 0) {
+    bc_put_leb128(s, idx);
+    return 0;
+  }
+  bc_put_leb128(s, s->var_ref_list.object_count);
+  if (js_object_list_add(s->ctx, &s->var_ref_list, (JSObject*)var_ref))
+    return -1;
+  return JS_WriteObjectRec(s, var_ref->value);
+}
+
+static int JS_WriteSnapshotFunction(BCWriterState* s, JSObject* p) {
+  JSFunctionBytecode* b = p->u.func.function_bytecode;
+  JSObject* home_object = p->u.func.home_object;
+  int i;
+
+  if (JS_WriteObjectRec(s, JS_MKPTR(JS_TAG_FUNCTION_BYTECODE, b)))
+    return -1;
+  for (i = 0; i < b->closure_var_count; i++) {
+    if (JS_WriteSnapshotVarRef(s, p->u.func.var_refs[i]))
+      return -1;
+  }
+  return JS_WriteObjectRec(
+      s, home_object ? JS_MKPTR(JS_TAG_OBJECT, home_object) : JS_UNDEFINED);
+}
+
+static int JS_WriteSnapshotMap(BCWriterState* s, JSObject* p) {
+  JSMapState* ms = p->u.map_state;
+  struct list_head* el;
+  JSMapRecord* mr;
+
+  bc_put_leb128(s, ms->record_count);
+  list_for_each(el, &ms->records) {
+    mr = list_entry(el, JSMapRecord, link);
+    if (mr->empty)
+      continue;
+    if (JS_WriteObjectRec(s, mr->key))
+      return -1;
+    if (p->class_id == JS_CLASS_MAP && JS_WriteObjectRec(s, mr->value))
+      return -1;
+  }
+  return 0;
+}
+
+/* return 1 if 'p' must be written with the regular tags */
+static int JS_WriteSnapshotObject(BCWriterState* s, JSObject* p) {
+  JSObject* proto;
+  uint32_t i, len;
+  int idx, ret;
+
+  idx = js_object_list_find(s->ctx, &s->intrinsic_list, p);
+  if (idx >= 0)
+    return JS_WriteIntrinsic(s, p, idx);
+  if (!bc_snapshot_class_supported(p->class_id))
+    return 1;
+
+  bc_put_u8(s, BC_TAG_SNAPSHOT_OBJECT);
+  bc_put_leb128(s, p->class_id);
+  if (p->tmp_mark) {
+    /* the prototype chain of 'p' leads back to it: its prototype is set
+       once the prototype has been read */
+    bc_put_u8(s, BC_TAG_UNDEFINED);
+  } else {
+    proto = p->shape->proto;
+    p->tmp_mark = 1;
+    ret =
+        JS_WriteObjectRec(s, proto ? JS_MKPTR(JS_TAG_OBJECT, proto) : JS_NULL);
+    p->tmp_mark = 0;
+    if (ret)
+      return -1;
+    idx = js_object_list_find(s->ctx, &s->object_list, p);
+    if (idx >= 0) {
+      /* 'p' was written with the prototype */
+      bc_put_u8(s, 1);
+      bc_put_leb128(s, idx);
+      bc_put_u8(s, p->extensible);
+      return 0;
+    }
+  }
+  bc_put_u8(s, 0);
+  if (js_object_list_add(s->ctx, &s->object_list, p))
+    return -1;
+  bc_put_u8(s, p->extensible | (p->is_constructor << 1));
+
+  switch (p->class_id) {
+    case JS_CLASS_ARRAY:
+      len = p->fast_array ? p->u.array.count : 0;
+      bc_put_leb128(s, len);
+      for (i = 0; i < len; i++) {
+        if (JS_WriteObjectRec(s, p->u.array.u.values[i]))
+          return -1;
+      }
+      break;
+    case JS_CLASS_NUMBER:
+    case JS_CLASS_STRING:
+    case JS_CLASS_BOOLEAN:
+    case JS_CLASS_BIG_INT:
+    case JS_CLASS_DATE:
+      if (JS_WriteObjectRec(s, p->u.object_data))
+        return -1;
+      break;
+    case JS_CLASS_REGEXP:
+      JS_WriteString(s, p->u.regexp.pattern);
+      JS_WriteString(s, p->u.regexp.bytecode);
+      break;
+    case JS_CLASS_MAP:
+    case JS_CLASS_SET:
+      if (JS_WriteSnapshotMap(s, p))
+        return -1;
+      break;
+    case JS_CLASS_BYTECODE_FUNCTION:
+    case JS_CLASS_GENERATOR_FUNCTION:
+    case JS_CLASS_ASYNC_FUNCTION:
+    case JS_CLASS_ASYNC_GENERATOR_FUNCTION:
+      if (JS_WriteSnapshotFunction(s, p))
+        return -1;
+      break;
+    default:
+      break;
+  }
+  if (JS_WriteSnapshotProps(s, p))
+    return -1;
+  if (p->class_id == JS_CLASS_ARRAY) {
+    if (js_get_length32(s->ctx, &len, JS_MKPTR(JS_TAG_OBJECT, p)))
+      return -1;
+    bc_put_leb128(s, len);
+    bc_put_u8(s, get_shape_prop(p->shape)[0].flags & JS_PROP_WRITABLE);
+  }
+  return 0;
+}
+
 static int JS_WriteObjectRec(BCWriterState* s, JSValueConst obj) {
   uint32_t tag;
 
@@ -755,6 +1478,18 @@ static int JS_WriteObjectRec(BCWriterState* s, JSValueConst obj) {
     case static_cast<uint32_t>(JS_TAG_FUNCTION_BYTECODE):
       if (!s->allow_bytecode)
         goto invalid_tag;
+      if (s->is_snapshot) {
+        /* functions shared by several closures are written once */
+        JSObject* key = (JSObject*)JS_VALUE_GET_PTR(obj);
+        int idx = js_object_list_find(s->ctx, &s->bytecode_list, key);
+        if (idx >= 0) {
+          bc_put_u8(s, BC_TAG_FUNCTION_REFERENCE);
+          bc_put_leb128(s, idx);
+          break;
+        }
+        if (js_object_list_add(s->ctx, &s->bytecode_list, key))
+          goto fail;
+      }
       if (JS_WriteFunctionTag(s, obj))
         goto fail;
       break;
@@ -774,10 +1509,16 @@ static int JS_WriteObjectRec(BCWriterState* s, JSValueConst obj) {
           bc_put_u8(s, BC_TAG_OBJECT_REFERENCE);
           bc_put_leb128(s, idx);
           break;
-        } else {
-          if (js_object_list_add(s->ctx, &s->object_list, p))
+        }
+        if (s->is_snapshot) {
+          ret = JS_WriteSnapshotObject(s, p);
+          if (ret < 0)
             goto fail;
+          if (ret == 0)
+            break;
         }
+        if (js_object_list_add(s->ctx, &s->object_list, p))
+          goto fail;
       } else {
         if (p->tmp_mark) {
           JS_ThrowTypeError(s->ctx, "circular reference");
@@ -875,14 +1616,77 @@ fail:
   return -1;
 }
 
-uint8_t* JS_WriteObject2(
+static int bc_init_transfer_list(
+    BCWriterState* s,
+    JSValueConst* transfer_list,
+    int transfer_len) {
+  JSContext* ctx = s->ctx;
+  JSArrayBuffer* abuf;
+  int i, j;
+
+  s->transfer_objs =
+      (JSObject**)js_mallocz(ctx, sizeof(s->transfer_objs[0]) * transfer_len);
+  s->transfer_written =
+      (BOOL*)js_mallocz(ctx, sizeof(s->transfer_written[0]) * transfer_len);
+  if (!s->transfer_objs || !s->transfer_written)
+    return -1;
+  for (i = 0; i < transfer_len; i++) {
+    abuf = (JSArrayBuffer*)JS_GetOpaque(transfer_list[i], JS_CLASS_ARRAY_BUFFER);
+    if (!abuf) {
+      JS_ThrowTypeError(ctx, "only ArrayBuffers can be transferred");
+      return -1;
+    }
+    if (abuf->detached) {
+      JS_ThrowTypeErrorDetachedArrayBuffer(ctx);
+      return -1;
+    }
+    s->transfer_objs[i] = JS_VALUE_GET_OBJ(transfer_list[i]);
+    for (j = 0; j < i; j++) {
+      if (s->transfer_objs[j] == s->transfer_objs[i]) {
+        JS_ThrowTypeError(ctx, "duplicate ArrayBuffer in transfer list");
+        return -1;
+      }
+    }
+  }
+  s->transfer_len = transfer_len;
+  return 0;
+}
+
+/* detach the transferred ArrayBuffers once the object is written */
+static uint8_t** bc_transfer_array_buffers(
+    JSContext* ctx,
+    JSValueConst* transfer_list,
+    int transfer_len) {
+  uint8_t** transfer_tab;
+  int i;
+
+  transfer_tab =
+      (uint8_t**)js_mallocz(ctx, sizeof(transfer_tab[0]) * transfer_len);
+  if (!transfer_tab)
+    return NULL;
+  for (i = 0; i < transfer_len; i++) {
+    transfer_tab[i] = js_array_buffer_transfer(ctx, transfer_list[i]);
+    if (!transfer_tab[i]) {
+      JS_FreeTransferTab(transfer_tab, i);
+      js_free(ctx, transfer_tab);
+      return NULL;
+    }
+  }
+  return transfer_tab;
+}
+
+uint8_t* JS_WriteObjectTransfer(
     JSContext* ctx,
     size_t* psize,
     JSValueConst obj,
     int flags,
     uint8_t*** psab_tab,
-    size_t* psab_tab_len) {
+    size_t* psab_tab_len,
+    JSValueConst* transfer_list,
+    int transfer_len,
+    uint8_t*** ptransfer_tab) {
   BCWriterState ss, *s = &ss;
+  uint8_t** transfer_tab = NULL;
 
   memset(s, 0, sizeof(*s));
   s->ctx = ctx;
@@ -897,37 +1701,131 @@ uint8_t* JS_WriteObject2(
   js_dbuf_init(ctx, &s->dbuf);
   js_object_list_init(&s->object_list);
 
+  if (transfer_len > 0 &&
+      bc_init_transfer_list(s, transfer_list, transfer_len))
+    goto fail;
   if (JS_WriteObjectRec(s, obj))
     goto fail;
   if (JS_WriteObjectAtoms(s))
     goto fail;
+  if (transfer_len > 0) {
+    transfer_tab = bc_transfer_array_buffers(ctx, transfer_list, transfer_len);
+    if (!transfer_tab)
+      goto fail;
+  }
   js_object_list_end(ctx, &s->object_list);
   js_free(ctx, s->atom_to_idx);
   js_free(ctx, s->idx_to_atom);
+  js_free(ctx, s->transfer_objs);
+  js_free(ctx, s->transfer_written);
   *psize = s->dbuf.size;
   if (psab_tab)
     *psab_tab = s->sab_tab;
+  else
+    js_free(ctx, s->sab_tab);
   if (psab_tab_len)
     *psab_tab_len = s->sab_tab_len;
+  if (ptransfer_tab) {
+    *ptransfer_tab = transfer_tab;
+  } else if (transfer_tab) {
+    JS_FreeTransferTab(transfer_tab, transfer_len);
+    js_free(ctx, transfer_tab);
+  }
   return s->dbuf.buf;
 fail:
   js_object_list_end(ctx, &s->object_list);
   js_free(ctx, s->atom_to_idx);
   js_free(ctx, s->idx_to_atom);
+  js_free(ctx, s->sab_tab);
+  js_free(ctx, s->transfer_objs);
+  js_free(ctx, s->transfer_written);
   dbuf_free(&s->dbuf);
   *psize = 0;
   if (psab_tab)
     *psab_tab = NULL;
   if (psab_tab_len)
     *psab_tab_len = 0;
+  if (ptransfer_tab)
+    *ptransfer_tab = NULL;
   return NULL;
 }
 
+uint8_t* JS_WriteObject2(
+    JSContext* ctx,
+    size_t* psize,
+    JSValueConst obj,
+    int flags,
+    uint8_t*** psab_tab,
+    size_t* psab_tab_len) {
+  return JS_WriteObjectTransfer(
+      ctx, psize, obj, flags, psab_tab, psab_tab_len, NULL, 0, NULL);
+}
+
 uint8_t*
 JS_WriteObject(JSContext* ctx, size_t* psize, JSValueConst obj, int flags) {
   return JS_WriteObject2(ctx, psize, obj, flags, NULL, NULL);
 }
 
+uint8_t*
+JS_WriteContextSnapshot(JSContext* ctx, size_t* psize, JSContext* base_ctx) {
+  BCWriterState ss, *s = &ss;
+  JSContext* tmp_ctx = NULL;
+  uint8_t* buf = NULL;
+
+  memset(s, 0, sizeof(*s));
+  s->ctx = ctx;
+  s->allow_bytecode = TRUE;
+  s->allow_reference = TRUE;
+  s->is_snapshot = TRUE;
+  s->first_atom = JS_ATOM_END;
+  js_dbuf_init(ctx, &s->dbuf);
+  js_object_list_init(&s->object_list);
+  js_object_list_init(&s->intrinsic_list);
+  js_object_list_init(&s->var_ref_list);
+  js_object_list_init(&s->bytecode_list);
+  *psize = 0;
+
+  if (!base_ctx) {
+    /* the builtins are compared with the ones of a fresh context */
+    tmp_ctx = JS_NewContext(ctx->rt);
+    if (!tmp_ctx) {
+      JS_ThrowOutOfMemory(ctx);
+      goto done;
+    }
+    base_ctx = tmp_ctx;
+  } else if (base_ctx->rt != ctx->rt) {
+    JS_ThrowTypeError(ctx, "the base context must use the same runtime");
+    goto done;
+  }
+  s->base_ctx = base_ctx;
+
+  if (bc_snapshot_build_intrinsics(s))
+    goto done;
+  if (JS_WriteObjectRec(s, ctx->global_obj))
+    goto done;
+  if (JS_WriteObjectRec(s, ctx->global_var_obj))
+    goto done;
+  if (JS_WriteModifiedIntrinsics(s))
+    goto done;
+  if (JS_WriteObjectAtoms(s))
+    goto done;
+  *psize = s->dbuf.size;
+  buf = s->dbuf.buf;
+done:
+  if (!buf)
+    dbuf_free(&s->dbuf);
+  js_object_list_end(ctx, &s->object_list);
+  js_object_list_end(ctx, &s->intrinsic_list);
+  js_object_list_end(ctx, &s->var_ref_list);
+  js_object_list_end(ctx, &s->bytecode_list);
+  js_free(ctx, s->intrinsics);
+  js_free(ctx, s->atom_to_idx);
+  js_free(ctx, s->idx_to_atom);
+  if (tmp_ctx)
+    JS_FreeContext(tmp_ctx);
+  return buf;
+}
+
 typedef struct BCReaderState {
   JSContext* ctx;
   const uint8_t *buf_start, *ptr, *buf_end;
@@ -941,8 +1839,23 @@ typedef struct BCReaderState {
   BOOL allow_reference : 8;
   /* object references */
   JSObject** objects;
-  int objects_count;
+  uint32_t objects_count;
   int objects_size;
+  /* context snapshot (JS_RestoreContextSnapshot) */
+  BOOL is_snapshot : 8;
+  JSVarRef** var_refs;
+  uint32_t var_refs_count;
+  int var_refs_size;
+  JSFunctionBytecode** bytecodes;
+  uint32_t bytecodes_count;
+  int bytecodes_size;
+  /* contents of the transferred ArrayBuffers (JS_ReadObjectTransfer) */
+  uint8_t** transfer_tab;
+  uint32_t transfer_len;
+  /* JS_READ_OBJ_LAZY: nested functions are only skipped over */
+  JSBytecodeSource* source;
+  BOOL is_lazy : 8;
+  int function_level;
 
 #ifdef DUMP_READ_OBJECT
   const uint8_t* ptr_last;
@@ -1087,6 +2000,8 @@ static int bc_get_buf(BCReaderState* s, uint8_t* buf, uint32_t buf_len) {
   return 0;
 }
 
+static int bc_resolve_atom(BCReaderState* s, uint32_t idx);
+
 static int bc_idx_to_atom(BCReaderState* s, JSAtom* patom, uint32_t idx) {
   JSAtom atom;
 
@@ -1104,6 +2019,10 @@ static int bc_idx_to_atom(BCReaderState* s, JSAtom* patom, uint32_t idx) {
       *patom = JS_ATOM_NULL;
       return s->error_state = -1;
     }
+    if (s->idx_to_atom[idx] == JS_ATOM_NULL && bc_resolve_atom(s, idx)) {
+      *patom = JS_ATOM_NULL;
+      return s->error_state = -1;
+    }
     atom = JS_DupAtom(s->ctx, s->idx_to_atom[idx]);
   }
   *patom = atom;
@@ -1165,20 +2084,58 @@ static JSString* JS_ReadString(BCReaderState* s) {
   return p;
 }
 
-static uint32_t bc_get_flags(uint32_t flags, int* pidx, int n) {
-  uint32_t val;
-  /* XXX: this does not work for n == 32 */
-  val = (flags >> *pidx) & ((1U << n) - 1);
-  *pidx += n;
-  return val;
+/* resolve an atom of the table left unresolved by JS_READ_OBJ_LAZY */
+static int bc_resolve_atom(BCReaderState* s, uint32_t idx) {
+  const uint8_t* ptr;
+  JSString* p;
+  JSAtom atom;
+
+  ptr = s->ptr;
+  s->ptr = s->buf_start + s->source->atom_offsets[idx];
+  p = JS_ReadString(s);
+  s->ptr = ptr;
+  if (!p)
+    return -1;
+  atom = JS_NewAtomStr(s->ctx, p);
+  if (atom == JS_ATOM_NULL)
+    return -1;
+  s->idx_to_atom[idx] = atom;
+  return 0;
 }
 
-static int JS_ReadFunctionBytecode(
-    BCReaderState* s,
+static int bc_skip(BCReaderState* s, uint32_t len) {
+  if (unlikely(s->buf_end - s->ptr < len))
+    return bc_read_error_end(s);
+  s->ptr += len;
+  return 0;
+}
+
+static int bc_skip_leb128(BCReaderState* s) {
+  uint32_t v;
+  return bc_get_leb128(s, &v);
+}
+
+static int bc_skip_string(BCReaderState* s) {
+  uint32_t len;
+  if (bc_get_leb128(s, &len))
+    return -1;
+  return bc_skip(s, (len >> 1) << (len & 1));
+}
+
+static uint32_t bc_get_flags(uint32_t flags, int* pidx, int n) {
+  uint32_t val;
+  /* XXX: this does not work for n == 32 */
+  val = (flags >> *pidx) & ((1U << n) - 1);
+  *pidx += n;
+  return val;
+}
+
+/* 'bc_buf' is the destination of the byte code, unused for ROM data */
+static int JS_ReadFunctionBytecode(
+    BCReaderState* s,
     JSFunctionBytecode* b,
-    int byte_code_offset,
+    uint8_t* bc_buf,
     uint32_t bc_len) {
-  uint8_t* bc_buf;
   int pos, len, op;
   JSAtom atom;
   uint32_t idx;
@@ -1190,9 +2147,10 @@ static int JS_ReadFunctionBytecode(
     bc_buf = (uint8_t*)s->ptr;
     s->ptr += bc_len;
   } else {
-    bc_buf = (uint8_t*)((uint8_t*)b + byte_code_offset);
-    if (bc_get_buf(s, bc_buf, bc_len))
+    if (bc_get_buf(s, bc_buf, bc_len)) {
+      b->byte_code_len = 0; /* no atom to free */
       return -1;
+    }
   }
   b->byte_code_buf = bc_buf;
 
@@ -1232,6 +2190,7 @@ static int JS_ReadFunctionBytecode(
     }
     pos += len;
   }
+  b->byte_code_len = bc_len;
   return 0;
 }
 
@@ -1306,6 +2265,220 @@ static int BC_add_object_ref(BCReaderState* s, JSValueConst obj) {
   return BC_add_object_ref1(s, JS_VALUE_GET_OBJ(obj));
 }
 
+static int bc_skip_object_rec(BCReaderState* s);
+
+/* skip the part of a function which JS_READ_OBJ_LAZY decodes on demand */
+static int bc_skip_function_body(
+    BCReaderState* s,
+    uint32_t bc_len,
+    BOOL has_debug,
+    uint32_t cpool_count) {
+  uint32_t len, i;
+
+  if (bc_skip(s, bc_len))
+    return -1;
+  if (has_debug) {
+    if (bc_skip_leb128(s)) /* filename */
+      return -1;
+    if (bc_get_leb128(s, &len) || bc_skip(s, len)) /* pc2line */
+      return -1;
+    if (bc_get_leb128(s, &len) || bc_skip(s, len)) /* source */
+      return -1;
+    for (i = 0; i < len; i++) {
+      if (bc_skip_leb128(s)) /* inline cache atoms */
+        return -1;
+    }
+  }
+  for (i = 0; i < cpool_count; i++) {
+    if (bc_skip_object_rec(s))
+      return -1;
+  }
+  return 0;
+}
+
+static int bc_skip_function_tag(BCReaderState* s) {
+  uint16_t v16;
+  uint8_t v8;
+  uint32_t closure_var_count, cpool_count, bc_len, local_count, i;
+  int idx;
+  BOOL has_debug;
+
+  if (bc_get_u16(s, &v16) || bc_get_u8(s, &v8))
+    return -1;
+  /* same layout as JS_ReadFunctionTag(): has_debug is the 11th flag */
+  idx = 10;
+  has_debug = bc_get_flags(v16, &idx, 1);
+  /* func_name, arg_count, var_count, defined_arg_count, stack_size */
+  for (i = 0; i < 5; i++) {
+    if (bc_skip_leb128(s))
+      return -1;
+  }
+  if (bc_get_leb128(s, &closure_var_count) ||
+      bc_get_leb128(s, &cpool_count) || bc_get_leb128(s, &bc_len) ||
+      bc_get_leb128(s, &local_count))
+    return -1;
+  for (i = 0; i < local_count; i++) {
+    if (bc_skip_leb128(s) || bc_skip_leb128(s) || bc_skip_leb128(s) ||
+        bc_get_u8(s, &v8))
+      return -1;
+  }
+  for (i = 0; i < closure_var_count; i++) {
+    if (bc_skip_leb128(s) || bc_skip_leb128(s) || bc_get_u8(s, &v8))
+      return -1;
+  }
+  return bc_skip_function_body(s, bc_len, has_debug, cpool_count);
+}
+
+static int bc_skip_object_rec(BCReaderState* s) {
+  uint8_t tag, v8;
+  uint32_t len, i;
+  int32_t v;
+
+  if (js_check_stack_overflow(s->ctx->rt, 0)) {
+    JS_ThrowStackOverflow(s->ctx);
+    return s->error_state = -1;
+  }
+  if (bc_get_u8(s, &tag))
+    return -1;
+  switch (tag) {
+    case BC_TAG_NULL:
+    case BC_TAG_UNDEFINED:
+    case BC_TAG_BOOL_FALSE:
+    case BC_TAG_BOOL_TRUE:
+      return 0;
+    case BC_TAG_INT32:
+      return bc_get_sleb128(s, &v);
+    case BC_TAG_FLOAT64:
+      return bc_skip(s, 8);
+    case BC_TAG_STRING:
+      return bc_skip_string(s);
+    case BC_TAG_BIG_INT:
+    case BC_TAG_ARRAY_BUFFER:
+      if (bc_get_leb128(s, &len))
+        return -1;
+      return bc_skip(s, len);
+    case BC_TAG_FUNCTION_BYTECODE:
+      return bc_skip_function_tag(s);
+    case BC_TAG_OBJECT:
+      if (bc_get_leb128(s, &len))
+        return -1;
+      for (i = 0; i < len; i++) {
+        if (bc_skip_leb128(s) || bc_skip_object_rec(s))
+          return -1;
+      }
+      return 0;
+    case BC_TAG_ARRAY:
+    case BC_TAG_TEMPLATE_OBJECT:
+      if (bc_get_leb128(s, &len))
+        return -1;
+      for (i = 0; i < len; i++) {
+        if (bc_skip_object_rec(s))
+          return -1;
+      }
+      if (tag == BC_TAG_TEMPLATE_OBJECT)
+        return bc_skip_object_rec(s);
+      return 0;
+    case BC_TAG_TYPED_ARRAY:
+      if (bc_get_u8(s, &v8) || bc_skip_leb128(s) || bc_skip_leb128(s))
+        return -1;
+      return bc_skip_object_rec(s);
+    case BC_TAG_DATE:
+    case BC_TAG_OBJECT_VALUE:
+      return bc_skip_object_rec(s);
+    default:
+      JS_ThrowSyntaxError(
+          s->ctx,
+          "invalid tag (tag=%d pos=%u)",
+          tag,
+          (unsigned int)(s->ptr - s->buf_start));
+      return s->error_state = -1;
+  }
+}
+
+static int JS_ReadFunctionDebug(BCReaderState* s, JSFunctionBytecode* b) {
+  JSContext* ctx = s->ctx;
+  JSAtom filename;
+  int i;
+
+  /* read optional debug information */
+  bc_read_trace(s, "debug {\n");
+  if (bc_get_atom(s, &filename))
+    return -1;
+  if (filename == JS_ATOM_NULL) {
+    /* only found in corrupted input, and not a printable string */
+    JS_ThrowSyntaxError(ctx, "invalid file name");
+    return -1;
+  }
+  if (b->debug.filename == JS_ATOM_NULL) {
+    b->debug.filename = filename;
+  } else {
+    /* renamed before its lazy body was decoded */
+    JS_FreeAtom(ctx, filename);
+  }
+#ifdef DUMP_READ_OBJECT
+  bc_read_trace(s, "filename: ");
+  print_atom(s->ctx, b->debug.filename);
+  printf("\n");
+#endif
+  if (bc_get_leb128_int(s, &b->debug.pc2line_len))
+    return -1;
+  if (b->debug.pc2line_len) {
+    b->debug.pc2line_buf = (uint8_t*)js_mallocz(ctx, b->debug.pc2line_len);
+    if (!b->debug.pc2line_buf)
+      return -1;
+    if (bc_get_buf(s, b->debug.pc2line_buf, b->debug.pc2line_len))
+      return -1;
+  }
+  if (bc_get_leb128_int(s, &b->debug.source_len))
+    return -1;
+  if (b->debug.source_len) {
+    bc_read_trace(s, "source: %d bytes\n", b->source_len);
+    b->debug.source = (char*)js_mallocz(ctx, b->debug.source_len);
+    if (!b->debug.source)
+      return -1;
+    if (bc_get_buf(s, (uint8_t*)b->debug.source, b->debug.source_len))
+      return -1;
+    b->ic = init_ic(ctx);
+    if (b->ic == NULL)
+      return -1;
+    for (i = 0; i < b->debug.source_len; i++) {
+      JSAtom atom;
+      bc_get_atom(s, &atom);
+      int flag = add_ic_slot1(b->ic, atom);
+      if (flag >= 0) {
+        JS_FreeAtom(ctx, atom);
+      }
+    }
+    rebuild_ic(b->ic);
+  } else {
+    b->ic = NULL;
+  }
+  bc_read_trace(s, "}\n");
+  return 0;
+}
+
+static int JS_ReadFunctionCpool(BCReaderState* s, JSFunctionBytecode* b) {
+  JSValue val;
+  int i;
+
+  if (b->cpool_count == 0)
+    return 0;
+  bc_read_trace(s, "cpool {\n");
+  /* with JS_READ_OBJ_LAZY, the nested functions are only skipped */
+  s->function_level++;
+  for (i = 0; i < b->cpool_count; i++) {
+    val = JS_ReadObjectRec(s);
+    if (JS_IsException(val)) {
+      s->function_level--;
+      return -1;
+    }
+    b->cpool[i] = val;
+  }
+  s->function_level--;
+  bc_read_trace(s, "}\n");
+  return 0;
+}
+
 static JSValue JS_ReadFunctionTag(BCReaderState* s) {
   JSContext* ctx = s->ctx;
   JSFunctionBytecode bc, *b;
@@ -1315,10 +2488,12 @@ static JSValue JS_ReadFunctionTag(BCReaderState* s) {
   int idx, i, local_count;
   int function_size, cpool_offset, byte_code_offset;
   int closure_var_offset, vardefs_offset;
+  BOOL is_lazy;
 
   memset(&bc, 0, sizeof(bc));
   bc.header.ref_count = 1;
   // bc.gc_header.mark = 0;
+  is_lazy = s->is_lazy && s->function_level > 0;
 
   if (bc_get_u16(s, &v16))
     goto fail;
@@ -1369,7 +2544,7 @@ static JSValue JS_ReadFunctionTag(BCReaderState* s) {
   closure_var_offset = function_size;
   function_size += bc.closure_var_count * sizeof(*bc.closure_var);
   byte_code_offset = function_size;
-  if (!bc.read_only_bytecode) {
+  if (!bc.read_only_bytecode && !is_lazy) {
     function_size += bc.byte_code_len;
   }
 
@@ -1379,6 +2554,9 @@ static JSValue JS_ReadFunctionTag(BCReaderState* s) {
 
   memcpy(b, &bc, offsetof(JSFunctionBytecode, debug));
   b->header.ref_count = 1;
+  /* set once byte_code_buf is valid so that a failure before freeing
+     the function does not scan a missing buffer for atoms */
+  b->byte_code_len = 0;
   if (local_count != 0) {
     b->vardefs = (JSVarDef*)((uint8_t*)b + vardefs_offset);
   }
@@ -1393,6 +2571,18 @@ static JSValue JS_ReadFunctionTag(BCReaderState* s) {
 
   obj = JS_MKPTR(JS_TAG_FUNCTION_BYTECODE, b);
 
+  if (s->is_snapshot) {
+    /* same order as the writer: before the nested functions */
+    if (js_resize_array(
+            ctx,
+            (void**)&s->bytecodes,
+            sizeof(s->bytecodes[0]),
+            &s->bytecodes_size,
+            s->bytecodes_count + 1))
+      goto fail;
+    s->bytecodes[s->bytecodes_count++] = b;
+  }
+
 #ifdef DUMP_READ_OBJECT
   bc_read_trace(s, "name: ");
   print_atom(s->ctx, b->func_name);
@@ -1410,7 +2600,7 @@ static JSValue JS_ReadFunctionTag(BCReaderState* s) {
       s,
       "stack=%d bclen=%d locals=%d\n",
       b->stack_size,
-      b->byte_code_len,
+      bc.byte_code_len,
       local_count);
 
   if (local_count != 0) {
@@ -1465,69 +2655,32 @@ static JSValue JS_ReadFunctionTag(BCReaderState* s) {
     }
     bc_read_trace(s, "}\n");
   }
-  {
+  if (is_lazy) {
+    /* only the header is needed to create closures: the rest is
+       decoded by js_materialize_function_bytecode() */
+    b->is_lazy = TRUE;
+    b->byte_code_len = bc.byte_code_len;
+    b->source = s->source;
+    b->source->ref_count++;
+    b->source_offset = s->ptr - s->buf_start;
+    if (bc_skip_function_body(
+            s, b->byte_code_len, b->has_debug, b->cpool_count))
+      goto fail;
+  } else {
     bc_read_trace(s, "bytecode {\n");
-    if (JS_ReadFunctionBytecode(s, b, byte_code_offset, b->byte_code_len))
+    if (JS_ReadFunctionBytecode(
+            s, b, (uint8_t*)b + byte_code_offset, bc.byte_code_len))
       goto fail;
     bc_read_trace(s, "}\n");
-  }
-  if (b->has_debug) {
-    /* read optional debug information */
-    bc_read_trace(s, "debug {\n");
-    if (bc_get_atom(s, &b->debug.filename)) {
-      goto fail;
+    if (b->read_only_bytecode && s->source) {
+      /* keep the borrowed buffer alive */
+      b->source = s->source;
+      b->source->ref_count++;
     }
-#ifdef DUMP_READ_OBJECT
-    bc_read_trace(s, "filename: ");
-    print_atom(s->ctx, b->debug.filename);
-    printf("\n");
-#endif
-    if (bc_get_leb128_int(s, &b->debug.pc2line_len)) {
+    if (b->has_debug && JS_ReadFunctionDebug(s, b))
       goto fail;
-    }
-    if (b->debug.pc2line_len) {
-      b->debug.pc2line_buf = (uint8_t*)js_mallocz(ctx, b->debug.pc2line_len);
-      if (!b->debug.pc2line_buf)
-        goto fail;
-      if (bc_get_buf(s, b->debug.pc2line_buf, b->debug.pc2line_len))
-        goto fail;
-    }
-    if (bc_get_leb128_int(s, &b->debug.source_len))
+    if (JS_ReadFunctionCpool(s, b))
       goto fail;
-    if (b->debug.source_len) {
-      bc_read_trace(s, "source: %d bytes\n", b->source_len);
-      b->debug.source = (char*)js_mallocz(ctx, b->debug.source_len);
-      if (!b->debug.source)
-        goto fail;
-      if (bc_get_buf(s, (uint8_t*)b->debug.source, b->debug.source_len))
-        goto fail;
-      b->ic = init_ic(ctx);
-      if (b->ic == NULL)
-        goto fail;
-      for (i = 0; i < b->debug.source_len; i++) {
-        JSAtom atom;
-        bc_get_atom(s, &atom);
-        int flag = add_ic_slot1(b->ic, atom);
-        if (flag >= 0) {
-          JS_FreeAtom(ctx, atom);
-        }
-      }
-      rebuild_ic(b->ic);
-    } else {
-      b->ic = NULL;
-    }
-    bc_read_trace(s, "}\n");
-  }
-  if (b->cpool_count != 0) {
-    bc_read_trace(s, "cpool {\n");
-    for (i = 0; i < b->cpool_count; i++) {
-      JSValue val;
-      val = JS_ReadObjectRec(s);
-      if (JS_IsException(val))
-        goto fail;
-      b->cpool[i] = val;
-    }
-    bc_read_trace(s, "}\n");
   }
   b->realm = JS_DupContext(ctx);
   return obj;
@@ -1803,6 +2956,30 @@ fail:
   return JS_EXCEPTION;
 }
 
+static JSValue JS_ReadArrayBufferTransfer(BCReaderState* s) {
+  JSContext* ctx = s->ctx;
+  uint32_t byte_length, idx;
+  uint8_t* data;
+  JSValue obj;
+
+  if (bc_get_leb128(s, &byte_length))
+    return JS_EXCEPTION;
+  if (bc_get_leb128(s, &idx))
+    return JS_EXCEPTION;
+  if (idx >= s->transfer_len || !s->transfer_tab[idx])
+    return JS_ThrowSyntaxError(ctx, "invalid transferred ArrayBuffer");
+  data = s->transfer_tab[idx];
+  s->transfer_tab[idx] = NULL;
+  obj = js_array_buffer_adopt(ctx, data, byte_length);
+  if (JS_IsException(obj))
+    return obj;
+  if (BC_add_object_ref(s, obj)) {
+    JS_FreeValue(ctx, obj);
+    return JS_EXCEPTION;
+  }
+  return obj;
+}
+
 static JSValue JS_ReadSharedArrayBuffer(BCReaderState* s) {
   JSContext* ctx = s->ctx;
   uint32_t byte_length;
@@ -1880,6 +3057,498 @@ fail:
   return JS_EXCEPTION;
 }
 
+/* context snapshot reader */
+
+static int JS_ReadSnapshotProps(
+    BCReaderState* s,
+    JSValueConst obj,
+    BOOL is_new) {
+  JSContext* ctx = s->ctx;
+  JSObject* p = JS_VALUE_GET_OBJ(obj);
+  JSValue val = JS_UNDEFINED, getter = JS_UNDEFINED, setter = JS_UNDEFINED;
+  JSProperty* pr;
+  JSAtom atom = JS_ATOM_NULL;
+  uint32_t i, prop_count;
+  uint8_t v8;
+  int flags;
+  BOOL fast;
+
+  if (bc_get_leb128(s, &prop_count))
+    return -1;
+  for (i = 0; i < prop_count; i++) {
+    if (bc_get_atom(s, &atom) || bc_get_u8(s, &v8))
+      goto fail;
+    flags = v8 & JS_PROP_C_W_E;
+    /* the properties of a new ordinary object can be added directly */
+    fast = is_new && !p->is_exotic && !find_own_property1(p, atom);
+    switch (v8 >> BC_PROP_KIND_SHIFT) {
+      case BC_PROP_VALUE:
+        val = JS_ReadObjectRec(s);
+        if (JS_IsException(val))
+          goto fail;
+        if (fast) {
+          pr = add_property(ctx, p, atom, flags);
+          if (!pr)
+            goto fail;
+          pr->u.value = val;
+        } else if (JS_DefinePropertyValue(
+                       ctx, obj, atom, val, flags | JS_PROP_THROW) < 0) {
+          val = JS_UNDEFINED;
+          goto fail;
+        }
+        val = JS_UNDEFINED;
+        break;
+      case BC_PROP_GETSET:
+        getter = JS_ReadObjectRec(s);
+        if (JS_IsException(getter))
+          goto fail;
+        setter = JS_ReadObjectRec(s);
+        if (JS_IsException(setter))
+          goto fail;
+        if ((!JS_IsUndefined(getter) && !JS_IsFunction(ctx, getter)) ||
+            (!JS_IsUndefined(setter) && !JS_IsFunction(ctx, setter))) {
+          JS_ThrowSyntaxError(ctx, "invalid accessor");
+          goto fail;
+        }
+        if (fast) {
+          pr = add_property(ctx, p, atom, flags | JS_PROP_GETSET);
+          if (!pr)
+            goto fail;
+          pr->u.getset.getter =
+              JS_IsObject(getter) ? JS_VALUE_GET_OBJ(getter) : NULL;
+          pr->u.getset.setter =
+              JS_IsObject(setter) ? JS_VALUE_GET_OBJ(setter) : NULL;
+        } else if (JS_DefinePropertyGetSet(
+                       ctx,
+                       obj,
+                       atom,
+                       getter,
+                       setter,
+                       flags | JS_PROP_THROW) < 0) {
+          getter = setter = JS_UNDEFINED;
+          goto fail;
+        }
+        getter = setter = JS_UNDEFINED;
+        break;
+      case BC_PROP_DELETED:
+        if (is_new) {
+          JS_ThrowSyntaxError(ctx, "invalid deleted property");
+          goto fail;
+        }
+        if (JS_DeleteProperty(ctx, obj, atom, JS_PROP_THROW) < 0)
+          goto fail;
+        break;
+      case BC_PROP_PROTOTYPE:
+        if (!JS_IsFunction(ctx, obj) || !fast) {
+          JS_ThrowSyntaxError(ctx, "invalid prototype property");
+          goto fail;
+        }
+        if (JS_DefineAutoInitProperty(
+                ctx, obj, atom, JS_AUTOINIT_ID_PROTOTYPE, NULL, flags) < 0)
+          goto fail;
+        break;
+      default:
+        JS_ThrowSyntaxError(ctx, "invalid property kind");
+        goto fail;
+    }
+    JS_FreeAtom(ctx, atom);
+    atom = JS_ATOM_NULL;
+  }
+  return 0;
+fail:
+  JS_FreeValue(ctx, val);
+  JS_FreeValue(ctx, getter);
+  JS_FreeValue(ctx, setter);
+  JS_FreeAtom(ctx, atom);
+  return -1;
+}
+
+static JSValue JS_ReadIntrinsic(BCReaderState* s) {
+  JSContext* ctx = s->ctx;
+  JSValue obj = JS_UNDEFINED, val;
+  JSPropertyDescriptor desc;
+  JSObject* p;
+  JSAtom atom;
+  uint32_t i, n;
+  uint8_t kind, extensible;
+  int ret, class_id;
+
+  if (bc_get_leb128(s, &n))
+    return JS_EXCEPTION;
+  if (n == 0)
+    goto not_found;
+  for (i = 0; i < n; i++) {
+    if (bc_get_u8(s, &kind))
+      goto fail;
+    val = JS_UNDEFINED;
+    if (i == 0) {
+      switch (kind) {
+        case BC_INTRINSIC_GLOBAL_OBJ:
+          val = JS_DupValue(ctx, ctx->global_obj);
+          break;
+        case BC_INTRINSIC_GLOBAL_VAR_OBJ:
+          val = JS_DupValue(ctx, ctx->global_var_obj);
+          break;
+        case BC_INTRINSIC_CLASS_PROTO:
+          if (bc_get_leb128_int(s, &class_id))
+            goto fail;
+          if (class_id < 0 || class_id >= ctx->rt->class_count)
+            goto not_found;
+          val = JS_DupValue(ctx, ctx->class_proto[class_id]);
+          break;
+        default:
+          goto not_found;
+      }
+    } else {
+      p = JS_VALUE_GET_OBJ(obj);
+      switch (kind) {
+        case BC_INTRINSIC_PROTO:
+          if (p->shape->proto)
+            val = JS_DupValue(ctx, JS_MKPTR(JS_TAG_OBJECT, p->shape->proto));
+          break;
+        case BC_INTRINSIC_VALUE:
+        case BC_INTRINSIC_GETTER:
+        case BC_INTRINSIC_SETTER:
+          if (bc_get_atom(s, &atom))
+            goto fail;
+          ret = JS_GetOwnPropertyInternal(ctx, &desc, p, atom);
+          JS_FreeAtom(ctx, atom);
+          if (ret < 0)
+            goto fail;
+          if (ret) {
+            if (kind == BC_INTRINSIC_VALUE) {
+              val = desc.value;
+              desc.value = JS_UNDEFINED;
+            } else if (kind == BC_INTRINSIC_GETTER) {
+              val = desc.getter;
+              desc.getter = JS_UNDEFINED;
+            } else {
+              val = desc.setter;
+              desc.setter = JS_UNDEFINED;
+            }
+            js_free_desc(ctx, &desc);
+          }
+          break;
+        default:
+          goto not_found;
+      }
+    }
+    JS_FreeValue(ctx, obj);
+    obj = val;
+    if (!JS_IsObject(obj))
+      goto not_found;
+  }
+  if (bc_get_u8(s, &extensible))
+    goto fail;
+  if (BC_add_object_ref(s, obj))
+    goto fail;
+  if (JS_ReadSnapshotProps(s, obj, FALSE))
+    goto fail;
+  if (!extensible && JS_PreventExtensions(ctx, obj) < 0)
+    goto fail;
+  return obj;
+not_found:
+  JS_ThrowTypeError(ctx, "builtin object not found");
+fail:
+  JS_FreeValue(ctx, obj);
+  return JS_EXCEPTION;
+}
+
+static JSVarRef* JS_ReadSnapshotVarRef(BCReaderState* s) {
+  JSContext* ctx = s->ctx;
+  JSVarRef* var_ref;
+  JSValue val;
+  uint32_t idx;
+
+  if (bc_get_leb128(s, &idx))
+    return NULL;
+  if (idx < s->var_refs_count) {
+    var_ref = s->var_refs[idx];
+    var_ref->header.ref_count++;
+    return var_ref;
+  }
+  if (idx != s->var_refs_count) {
+    JS_ThrowSyntaxError(ctx, "invalid variable reference");
+    return NULL;
+  }
+  if (js_resize_array(
+          ctx,
+          (void**)&s->var_refs,
+          sizeof(s->var_refs[0]),
+          &s->var_refs_size,
+          s->var_refs_count + 1))
+    return NULL;
+  var_ref = (JSVarRef*)js_slab_alloc(ctx, sizeof(JSVarRef));
+  if (!var_ref)
+    return NULL;
+  var_ref->header.ref_count = 1;
+  add_gc_object(ctx->rt, &var_ref->header, JS_GC_OBJ_TYPE_VAR_REF);
+  var_ref->is_detached = TRUE;
+  var_ref->value = JS_UNDEFINED;
+  var_ref->pvalue = &var_ref->value;
+  s->var_refs[s->var_refs_count++] = var_ref;
+  /* registered first: the value may contain closures sharing it */
+  val = JS_ReadObjectRec(s);
+  if (JS_IsException(val)) {
+    free_var_ref(ctx->rt, var_ref);
+    return NULL;
+  }
+  var_ref->value = val;
+  return var_ref;
+}
+
+static int JS_ReadSnapshotFunction(BCReaderState* s, JSObject* p) {
+  JSContext* ctx = s->ctx;
+  JSFunctionBytecode* b;
+  JSVarRef* var_ref;
+  JSValue val;
+  int i;
+
+  val = JS_ReadObjectRec(s);
+  if (JS_IsException(val))
+    return -1;
+  if (JS_VALUE_GET_TAG(val) != JS_TAG_FUNCTION_BYTECODE) {
+    JS_FreeValue(ctx, val);
+    goto invalid;
+  }
+  b = (JSFunctionBytecode*)JS_VALUE_GET_PTR(val);
+  p->u.func.function_bytecode = b;
+  if (GET_CLASS_ID_BY_FUNC_KIND(b->func_kind) != p->class_id)
+    goto invalid;
+  if (b->closure_var_count != 0) {
+    p->u.func.var_refs = (JSVarRef**)js_mallocz(
+        ctx, sizeof(p->u.func.var_refs[0]) * b->closure_var_count);
+    if (!p->u.func.var_refs)
+      return -1;
+    for (i = 0; i < b->closure_var_count; i++) {
+      var_ref = JS_ReadSnapshotVarRef(s);
+      if (!var_ref)
+        return -1;
+      p->u.func.var_refs[i] = var_ref;
+    }
+  }
+  val = JS_ReadObjectRec(s);
+  if (JS_IsException(val))
+    return -1;
+  if (JS_IsObject(val)) {
+    p->u.func.home_object = JS_VALUE_GET_OBJ(val);
+  } else if (!JS_IsUndefined(val)) {
+    JS_FreeValue(ctx, val);
+    goto invalid;
+  }
+  return 0;
+invalid:
+  JS_ThrowSyntaxError(ctx, "invalid function");
+  return -1;
+}
+
+static int JS_ReadSnapshotMap(BCReaderState* s, JSValueConst obj, int class_id) {
+  JSContext* ctx = s->ctx;
+  JSValue args[2], ret;
+  uint32_t i, count;
+
+  if (bc_get_leb128(s, &count))
+    return -1;
+  for (i = 0; i < count; i++) {
+    args[0] = JS_ReadObjectRec(s);
+    if (JS_IsException(args[0]))
+      return -1;
+    args[1] = JS_UNDEFINED;
+    if (class_id == JS_CLASS_MAP) {
+      args[1] = JS_ReadObjectRec(s);
+      if (JS_IsException(args[1])) {
+        JS_FreeValue(ctx, args[0]);
+        return -1;
+      }
+    }
+    ret = js_map_set(ctx, obj, 2, args, class_id - JS_CLASS_MAP);
+    JS_FreeValue(ctx, args[0]);
+    JS_FreeValue(ctx, args[1]);
+    if (JS_IsException(ret))
+      return -1;
+    JS_FreeValue(ctx, ret);
+  }
+  return 0;
+}
+
+static JSValue JS_ReadSnapshotObject(BCReaderState* s) {
+  JSContext* ctx = s->ctx;
+  JSValue obj = JS_UNDEFINED, proto, val;
+  JSString *pattern, *bc;
+  JSObject* p;
+  uint32_t class_id, idx, i, len;
+  uint8_t v8, flags;
+  BOOL deferred;
+
+  if (bc_get_leb128(s, &class_id))
+    return JS_EXCEPTION;
+  if (!bc_snapshot_class_supported(class_id))
+    return JS_ThrowSyntaxError(ctx, "invalid object class");
+  proto = JS_ReadObjectRec(s);
+  if (JS_IsException(proto))
+    return JS_EXCEPTION;
+  if (!JS_IsObject(proto) && !JS_IsNull(proto) && !JS_IsUndefined(proto)) {
+    JS_ThrowSyntaxError(ctx, "invalid prototype");
+    goto fail;
+  }
+  /* the prototype chain leads back to the object */
+  deferred = JS_IsUndefined(proto);
+  if (bc_get_u8(s, &v8))
+    goto fail;
+  if (v8) {
+    /* the object was read with its prototype */
+    if (bc_get_leb128(s, &idx) || bc_get_u8(s, &v8))
+      goto fail;
+    if (deferred || idx >= s->objects_count) {
+      JS_ThrowSyntaxError(ctx, "invalid object reference");
+      goto fail;
+    }
+    obj = JS_DupValue(ctx, JS_MKPTR(JS_TAG_OBJECT, s->objects[idx]));
+    if (JS_SetPrototypeInternal(ctx, obj, proto, TRUE) < 0)
+      goto fail;
+    if (!v8 && JS_PreventExtensions(ctx, obj) < 0)
+      goto fail;
+    JS_FreeValue(ctx, proto);
+    return obj;
+  }
+  if (bc_get_u8(s, &flags))
+    goto fail;
+
+  switch (class_id) {
+    case JS_CLASS_ARRAY:
+      obj = JS_NewArray(ctx);
+      break;
+    case JS_CLASS_NUMBER:
+    case JS_CLASS_STRING:
+    case JS_CLASS_BOOLEAN:
+    case JS_CLASS_BIG_INT:
+      val = JS_ReadObjectRec(s);
+      if (JS_IsException(val))
+        goto fail;
+      if (JS_IsObject(val) || JS_IsNull(val) || JS_IsUndefined(val)) {
+        JS_FreeValue(ctx, val);
+        JS_ThrowSyntaxError(ctx, "invalid object value");
+        goto fail;
+      }
+      obj = JS_ToObject(ctx, val);
+      JS_FreeValue(ctx, val);
+      if (!JS_IsException(obj) &&
+          JS_VALUE_GET_OBJ(obj)->class_id != class_id) {
+        JS_FreeValue(ctx, obj);
+        obj = JS_ThrowSyntaxError(ctx, "invalid object value");
+      }
+      break;
+    case JS_CLASS_DATE:
+      val = JS_ReadObjectRec(s);
+      if (JS_IsException(val))
+        goto fail;
+      if (!JS_IsNumber(val)) {
+        JS_FreeValue(ctx, val);
+        JS_ThrowSyntaxError(ctx, "invalid object value");
+        goto fail;
+      }
+      obj = JS_NewObjectClass(ctx, JS_CLASS_DATE);
+      if (!JS_IsException(obj))
+        JS_SetObjectData(ctx, obj, val);
+      break;
+    case JS_CLASS_REGEXP:
+      pattern = JS_ReadString(s);
+      if (!pattern)
+        goto fail;
+      bc = JS_ReadString(s);
+      if (!bc) {
+        js_free_string(ctx->rt, pattern);
+        goto fail;
+      }
+      obj = js_regexp_constructor_internal(
+          ctx,
+          JS_UNDEFINED,
+          JS_MKPTR(JS_TAG_STRING, pattern),
+          JS_MKPTR(JS_TAG_STRING, bc));
+      break;
+    case JS_CLASS_MAP:
+    case JS_CLASS_SET:
+      obj = js_map_constructor(ctx, JS_UNDEFINED, 0, NULL, class_id - JS_CLASS_MAP);
+      break;
+    default:
+      obj = JS_NewObjectProtoClass(ctx, deferred ? JS_NULL : proto, class_id);
+      if (!JS_IsException(obj) && class_id != JS_CLASS_OBJECT &&
+          class_id != JS_CLASS_ERROR) {
+        p = JS_VALUE_GET_OBJ(obj);
+        p->u.func.function_bytecode = NULL;
+        p->u.func.var_refs = NULL;
+        p->u.func.home_object = NULL;
+      }
+      break;
+  }
+  if (JS_IsException(obj))
+    goto fail;
+  p = JS_VALUE_GET_OBJ(obj);
+  if (!deferred &&
+      p->shape->proto != (JS_IsObject(proto) ? JS_VALUE_GET_OBJ(proto) : NULL) &&
+      JS_SetPrototypeInternal(ctx, obj, proto, TRUE) < 0)
+    goto fail;
+  JS_FreeValue(ctx, proto);
+  proto = JS_UNDEFINED;
+  if (BC_add_object_ref(s, obj))
+    goto fail;
+  p->is_constructor = (flags >> 1) & 1;
+
+  switch (class_id) {
+    case JS_CLASS_ARRAY:
+      if (bc_get_leb128(s, &len))
+        goto fail;
+      for (i = 0; i < len; i++) {
+        val = JS_ReadObjectRec(s);
+        if (JS_IsException(val))
+          goto fail;
+        if (JS_DefinePropertyValueUint32(ctx, obj, i, val, JS_PROP_C_W_E) < 0)
+          goto fail;
+      }
+      break;
+    case JS_CLASS_MAP:
+    case JS_CLASS_SET:
+      if (JS_ReadSnapshotMap(s, obj, class_id))
+        goto fail;
+      break;
+    case JS_CLASS_BYTECODE_FUNCTION:
+    case JS_CLASS_GENERATOR_FUNCTION:
+    case JS_CLASS_ASYNC_FUNCTION:
+    case JS_CLASS_ASYNC_GENERATOR_FUNCTION:
+      if (JS_ReadSnapshotFunction(s, p))
+        goto fail;
+      break;
+    default:
+      break;
+  }
+  if (JS_ReadSnapshotProps(s, obj, TRUE))
+    goto fail;
+  if (class_id == JS_CLASS_ARRAY) {
+    if (bc_get_leb128(s, &len) || bc_get_u8(s, &v8))
+      goto fail;
+    if (JS_SetProperty(ctx, obj, JS_ATOM_length, JS_NewUint32(ctx, len)) < 0)
+      goto fail;
+    if (!(v8 & JS_PROP_WRITABLE) &&
+        JS_DefineProperty(
+            ctx,
+            obj,
+            JS_ATOM_length,
+            JS_UNDEFINED,
+            JS_UNDEFINED,
+            JS_UNDEFINED,
+            JS_PROP_HAS_WRITABLE | JS_PROP_THROW) < 0)
+      goto fail;
+  }
+  /* a deferred object is made non extensible once its prototype is set */
+  if (!(flags & 1) && !deferred && JS_PreventExtensions(ctx, obj) < 0)
+    goto fail;
+  return obj;
+fail:
+  JS_FreeValue(ctx, proto);
+  JS_FreeValue(ctx, obj);
+  return JS_EXCEPTION;
+}
+
 static JSValue JS_ReadObjectRec(BCReaderState* s) {
   JSContext* ctx = s->ctx;
   uint8_t tag;
@@ -1953,6 +3622,9 @@ static JSValue JS_ReadObjectRec(BCReaderState* s) {
         goto invalid_tag;
       obj = JS_ReadSharedArrayBuffer(s);
       break;
+    case BC_TAG_ARRAY_BUFFER_TRANSFER:
+      obj = JS_ReadArrayBufferTransfer(s);
+      break;
     case BC_TAG_DATE:
       obj = JS_ReadDate(s);
       break;
@@ -1975,6 +3647,33 @@ static JSValue JS_ReadObjectRec(BCReaderState* s) {
       }
       obj = JS_DupValue(ctx, JS_MKPTR(JS_TAG_OBJECT, s->objects[val]));
     } break;
+    case BC_TAG_INTRINSIC:
+      if (!s->is_snapshot)
+        goto invalid_tag;
+      obj = JS_ReadIntrinsic(s);
+      break;
+    case BC_TAG_SNAPSHOT_OBJECT:
+      if (!s->is_snapshot)
+        goto invalid_tag;
+      obj = JS_ReadSnapshotObject(s);
+      break;
+    case BC_TAG_FUNCTION_REFERENCE: {
+      uint32_t val;
+      if (!s->is_snapshot)
+        goto invalid_tag;
+      if (bc_get_leb128(s, &val))
+        return JS_EXCEPTION;
+      bc_read_trace(s, "%u\n", val);
+      if (val >= s->bytecodes_count) {
+        return JS_ThrowSyntaxError(
+            ctx,
+            "invalid function reference (%u >= %u)",
+            val,
+            s->bytecodes_count);
+      }
+      obj = JS_DupValue(
+          ctx, JS_MKPTR(JS_TAG_FUNCTION_BYTECODE, s->bytecodes[val]));
+    } break;
     default:
     invalid_tag:
       return JS_ThrowSyntaxError(
@@ -1990,7 +3689,7 @@ static JSValue JS_ReadObjectRec(BCReaderState* s) {
 static int JS_ReadObjectAtoms(BCReaderState* s) {
   uint8_t v8;
   JSString* p;
-  int i;
+  uint32_t i;
   JSAtom atom;
 
   if (bc_get_u8(s, &v8))
@@ -2010,6 +3709,22 @@ static int JS_ReadObjectAtoms(BCReaderState* s) {
         (JSAtom*)js_mallocz(s->ctx, s->idx_to_atom_count * sizeof(s->idx_to_atom[0]));
     if (!s->idx_to_atom)
       return s->error_state = -1;
+    if (s->source)
+      s->source->idx_to_atom = s->idx_to_atom;
+    if (s->is_lazy && !s->is_rom_data) {
+      /* the atoms are created by bc_resolve_atom() when first used */
+      s->source->atom_offsets = (uint32_t*)js_malloc(
+          s->ctx, s->idx_to_atom_count * sizeof(s->source->atom_offsets[0]));
+      if (!s->source->atom_offsets)
+        return s->error_state = -1;
+      for (i = 0; i < s->idx_to_atom_count; i++) {
+        s->source->atom_offsets[i] = s->ptr - s->buf_start;
+        if (bc_skip_string(s))
+          return -1;
+      }
+      bc_read_trace(s, "}\n");
+      return 0;
+    }
   }
   for (i = 0; i < s->idx_to_atom_count; i++) {
     p = JS_ReadString(s);
@@ -2028,17 +3743,28 @@ static int JS_ReadObjectAtoms(BCReaderState* s) {
 
 static void bc_reader_free(BCReaderState* s) {
   int i;
-  if (s->idx_to_atom) {
+  if (s->source) {
+    /* the atom table is owned by the source */
+    free_bytecode_source(s->ctx->rt, s->source);
+  } else if (s->idx_to_atom) {
     for (i = 0; i < s->idx_to_atom_count; i++) {
       JS_FreeAtom(s->ctx, s->idx_to_atom[i]);
     }
     js_free(s->ctx, s->idx_to_atom);
   }
   js_free(s->ctx, s->objects);
+  js_free(s->ctx, s->var_refs);
+  js_free(s->ctx, s->bytecodes);
 }
 
-JSValue
-JS_ReadObject(JSContext* ctx, const uint8_t* buf, size_t buf_len, int flags) {
+static JSValue bc_read_object(
+    JSContext* ctx,
+    const uint8_t* buf,
+    size_t buf_len,
+    int flags,
+    JSBytecodeSource* src,
+    uint8_t** transfer_tab,
+    int transfer_len) {
   BCReaderState ss, *s = &ss;
   JSValue obj;
 
@@ -2058,11 +3784,229 @@ JS_ReadObject(JSContext* ctx, const uint8_t* buf, size_t buf_len, int flags) {
     s->first_atom = JS_ATOM_END;
   else
     s->first_atom = 1;
+  s->transfer_tab = transfer_tab;
+  s->transfer_len = max_int(transfer_len, 0);
+  s->source = src;
+  if (src) {
+    src->first_atom = s->first_atom;
+    /* object references are numbered in reading order, which skipping
+       the function bodies would break */
+    s->is_lazy = ((flags & JS_READ_OBJ_LAZY) != 0) && s->allow_bytecode &&
+        !s->allow_reference;
+  }
   if (JS_ReadObjectAtoms(s)) {
     obj = JS_EXCEPTION;
   } else {
     obj = JS_ReadObjectRec(s);
   }
+  if (src)
+    src->idx_to_atom_count = s->idx_to_atom ? s->idx_to_atom_count : 0;
   bc_reader_free(s);
   return obj;
 }
+
+static void js_free_bytecode_buf(JSRuntime* rt, void* opaque, void* ptr) {
+  js_free_rt(rt, ptr);
+}
+
+JSValue
+JS_ReadObject(JSContext* ctx, const uint8_t* buf, size_t buf_len, int flags) {
+  uint8_t* copy;
+
+  if (flags & JS_READ_OBJ_LAZY) {
+    /* the function bodies are decoded after returning: ROM data is
+       permanent, otherwise keep a private copy of the buffer */
+    if (flags & JS_READ_OBJ_ROM_DATA)
+      return JS_ReadObject2(ctx, buf, buf_len, flags, NULL, NULL);
+    copy = (uint8_t*)js_malloc(ctx, max_int(buf_len, 1));
+    if (!copy)
+      return JS_EXCEPTION;
+    memcpy(copy, buf, buf_len);
+    return JS_ReadObject2(
+        ctx, copy, buf_len, flags, js_free_bytecode_buf, NULL);
+  }
+  return bc_read_object(ctx, buf, buf_len, flags, NULL, NULL, 0);
+}
+
+JSValue JS_ReadObject2(
+    JSContext* ctx,
+    const uint8_t* buf,
+    size_t buf_len,
+    int flags,
+    JSFreeArrayBufferDataFunc* free_func,
+    void* opaque) {
+  JSBytecodeSource* src;
+
+  src = (JSBytecodeSource*)js_mallocz(ctx, sizeof(*src));
+  if (!src) {
+    if (free_func)
+      free_func(ctx->rt, opaque, (void*)buf);
+    return JS_EXCEPTION;
+  }
+  src->ref_count = 1;
+  src->buf = buf;
+  src->buf_len = buf_len;
+  src->free_func = free_func;
+  src->opaque = opaque;
+  /* the reader reference is released by bc_reader_free() */
+  return bc_read_object(ctx, buf, buf_len, flags, src, NULL, 0);
+}
+
+JSValue JS_ReadObjectTransfer(
+    JSContext* ctx,
+    const uint8_t* buf,
+    size_t buf_len,
+    int flags,
+    uint8_t** transfer_tab,
+    int transfer_len) {
+  JSValue obj;
+
+  obj = bc_read_object(
+      ctx,
+      buf,
+      buf_len,
+      flags & ~JS_READ_OBJ_LAZY,
+      NULL,
+      transfer_tab,
+      transfer_len);
+  /* the contents which were not referenced are dropped */
+  JS_FreeTransferTab(transfer_tab, transfer_len);
+  return obj;
+}
+
+void JS_FreeTransferTab(uint8_t** transfer_tab, int transfer_len) {
+  int i;
+
+  for (i = 0; i < transfer_len; i++) {
+    free(transfer_tab[i]);
+    transfer_tab[i] = NULL;
+  }
+}
+
+int JS_RestoreContextSnapshot(
+    JSContext* ctx,
+    const uint8_t* buf,
+    size_t buf_len) {
+  BCReaderState ss, *s = &ss;
+  JSValue obj;
+  uint32_t j, count;
+  int i, ret = -1;
+
+  memset(s, 0, sizeof(*s));
+  s->ctx = ctx;
+  s->buf_start = buf;
+  s->buf_end = buf + buf_len;
+  s->ptr = buf;
+  s->allow_bytecode = TRUE;
+  s->allow_reference = TRUE;
+  s->is_snapshot = TRUE;
+  s->first_atom = JS_ATOM_END;
+  if (JS_ReadObjectAtoms(s))
+    goto done;
+  /* the global object, then the global lexical variables */
+  for (i = 0; i < 2; i++) {
+    obj = JS_ReadObjectRec(s);
+    if (JS_IsException(obj))
+      goto done;
+    JS_FreeValue(ctx, obj);
+  }
+  /* then the other modified builtins */
+  if (bc_get_leb128(s, &count))
+    goto done;
+  for (j = 0; j < count; j++) {
+    obj = JS_ReadObjectRec(s);
+    if (JS_IsException(obj))
+      goto done;
+    JS_FreeValue(ctx, obj);
+  }
+  ret = 0;
+done:
+  bc_reader_free(s);
+  return ret;
+}
+
+int js_materialize_function_bytecode(JSContext* ctx, JSFunctionBytecode* b) {
+  JSBytecodeSource* src = b->source;
+  BCReaderState ss, *s = &ss;
+  uint8_t* bc_buf = NULL;
+  JSAtom filename;
+  int i, bc_len;
+
+  memset(s, 0, sizeof(*s));
+  /* objects of the constant pool belong to the function realm */
+  s->ctx = b->realm;
+  s->buf_start = src->buf;
+  s->buf_end = src->buf + src->buf_len;
+  s->ptr = src->buf + b->source_offset;
+  s->first_atom = src->first_atom;
+  s->idx_to_atom_count = src->idx_to_atom_count;
+  s->idx_to_atom = src->idx_to_atom;
+  s->allow_bytecode = TRUE;
+  s->is_rom_data = b->read_only_bytecode;
+  s->source = src;
+  s->is_lazy = TRUE;
+
+  filename = b->debug.filename;
+  bc_len = b->byte_code_len;
+  if (!s->is_rom_data) {
+    bc_buf = (uint8_t*)js_malloc(ctx, max_int(bc_len, 1));
+    if (!bc_buf)
+      return -1;
+  }
+  if (JS_ReadFunctionBytecode(s, b, bc_buf, bc_len))
+    goto fail;
+  b->byte_code_allocated = (bc_buf != NULL);
+  if (b->has_debug && JS_ReadFunctionDebug(s, b))
+    goto fail;
+  if (JS_ReadFunctionCpool(s, b))
+    goto fail;
+  if (filename != JS_ATOM_NULL) {
+    /* the nested functions inherit a file name set before decoding, as
+       taro_js_set_function_bytecode_name() does for decoded ones */
+    for (i = 0; i < b->cpool_count; i++) {
+      JSFunctionBytecode* b1;
+      if (JS_VALUE_GET_TAG(b->cpool[i]) != JS_TAG_FUNCTION_BYTECODE)
+        continue;
+      b1 = (JSFunctionBytecode*)JS_VALUE_GET_PTR(b->cpool[i]);
+      if (b1->is_lazy && b1->has_debug &&
+          b1->debug.filename == JS_ATOM_NULL)
+        b1->debug.filename = JS_DupAtom(ctx, filename);
+    }
+  }
+  b->is_lazy = FALSE;
+  if (!b->read_only_bytecode) {
+    b->source = NULL;
+    free_bytecode_source(ctx->rt, src);
+  }
+  return 0;
+fail:
+  /* back to the lazy state, a later call will retry */
+  if (b->byte_code_buf) {
+    free_bytecode_atoms(ctx->rt, b->byte_code_buf, b->byte_code_len, TRUE);
+    b->byte_code_buf = NULL;
+  }
+  b->byte_code_len = bc_len;
+  b->byte_code_allocated = FALSE;
+  js_free(ctx, bc_buf);
+  if (b->ic) {
+    free_ic(b->ic);
+    b->ic = NULL;
+  }
+  if (b->has_debug) {
+    if (filename == JS_ATOM_NULL) {
+      JS_FreeAtom(ctx, b->debug.filename);
+      b->debug.filename = JS_ATOM_NULL;
+    }
+    js_free(ctx, b->debug.pc2line_buf);
+    b->debug.pc2line_buf = NULL;
+    b->debug.pc2line_len = 0;
+    js_free(ctx, b->debug.source);
+    b->debug.source = NULL;
+    b->debug.source_len = 0;
+  }
+  for (i = 0; i < b->cpool_count; i++) {
+    JS_FreeValue(ctx, b->cpool[i]);
+    b->cpool[i] = JS_UNDEFINED;
+  }
+  return -1;
+}
@@ -41,6 +41,8 @@ void free_bytecode_atoms(
     const uint8_t* bc_buf,
     int bc_len,
     BOOL use_short_opcodes);
+/* decode the body of a function read with JS_READ_OBJ_LAZY */
+int js_materialize_function_bytecode(JSContext* ctx, JSFunctionBytecode* b);
 
 #ifdef __cplusplus
 }
@@ -33,6 +33,7 @@
 #include "builtins/js-object.h"
 #include "builtins/js-operator.h"
 #include "builtins/js-regexp.h"
+#include "bytecode.h"
 #include "common.h"
 #include "convertion.h"
 #include "exception.h"
@@ -319,6 +320,8 @@ JSValue JS_CallInternal(
         caller_ctx, func_obj, this_obj, argc, (JSValueConst*)argv, flags);
   }
   b = p->u.func.function_bytecode;
+  if (unlikely(b->is_lazy) && js_materialize_function_bytecode(caller_ctx, b))
+    return JS_EXCEPTION;
 
   if (unlikely(argc < b->arg_count || (flags & JS_CALL_FLAG_COPY_ARGV))) {
     arg_allocated_size = b->arg_count;
@@ -462,9 +465,13 @@ restart:
       BREAK;
       CASE(OP_push_true) : * sp++ = JS_TRUE;
       BREAK;
-      CASE(OP_object) : * sp++ = JS_NewObject(ctx);
-      if (unlikely(JS_IsException(sp[-1])))
-        goto exception;
+      CASE(OP_object) : {
+        /* allocation site for the heap profiler */
+        sf->cur_pc = pc;
+        *sp++ = JS_NewObject(ctx);
+        if (unlikely(JS_IsException(sp[-1])))
+          goto exception;
+      }
       BREAK;
       CASE(OP_special_object) : {
         int arg = *pc++;
@@ -680,6 +687,7 @@ restart:
       CASE(OP_fclosure) : {
         JSValue bfunc = JS_DupValue(ctx, b->cpool[get_u32(pc)]);
         pc += 4;
+        sf->cur_pc = pc;
         *sp++ = js_closure(ctx, bfunc, var_refs, sf);
         if (unlikely(JS_IsException(sp[-1])))
           goto exception;
@@ -759,6 +767,7 @@ restart:
 
         call_argc = get_u16(pc);
         pc += 2;
+        sf->cur_pc = pc;
         ret_val = JS_NewArray(ctx);
         if (unlikely(JS_IsException(ret_val)))
           goto exception;
@@ -1382,16 +1391,16 @@ restart:
       BREAK;
 
       CASE(OP_goto) : pc += (int32_t)get_u32(pc);
-      if (unlikely(js_poll_interrupts(ctx)))
+      if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
         goto exception;
       BREAK;
 #if SHORT_OPCODES
       CASE(OP_goto16) : pc += (int16_t)get_u16(pc);
-      if (unlikely(js_poll_interrupts(ctx)))
+      if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
         goto exception;
       BREAK;
       CASE(OP_goto8) : pc += (int8_t)pc[0];
-      if (unlikely(js_poll_interrupts(ctx)))
+      if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
         goto exception;
       BREAK;
 #endif
@@ -1410,7 +1419,7 @@ restart:
         if (res) {
           pc += (int32_t)get_u32(pc - 4) - 4;
         }
-        if (unlikely(js_poll_interrupts(ctx)))
+        if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
           goto exception;
       }
       BREAK;
@@ -1431,7 +1440,7 @@ restart:
         if (!res) {
           pc += (int32_t)get_u32(pc - 4) - 4;
         }
-        if (unlikely(js_poll_interrupts(ctx)))
+        if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
           goto exception;
       }
       BREAK;
@@ -1451,7 +1460,7 @@ restart:
         if (res) {
           pc += (int8_t)pc[-1] - 1;
         }
-        if (unlikely(js_poll_interrupts(ctx)))
+        if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
           goto exception;
       }
       BREAK;
@@ -1470,7 +1479,7 @@ restart:
         if (!res) {
           pc += (int8_t)pc[-1] - 1;
         }
-        if (unlikely(js_poll_interrupts(ctx)))
+        if (unlikely(js_poll_interrupts_pc(ctx, sf, pc)))
           goto exception;
       }
       BREAK;
@@ -37,6 +37,9 @@
 #include "runtime.h"
 #include "shape.h"
 
+/* number of young objects scanned at once by JS_RunGCStep() */
+#define JS_GC_STEP_SLICE_SIZE 1024
+
 __maybe_unused void
 JS_DumpValue(JSContext* ctx, const char* str, JSValueConst val) {
   printf("%s=", str);
@@ -276,7 +279,7 @@ void free_var_ref(JSRuntime* rt, JSVarRef* var_ref) {
           async_func_free(rt, var_ref->async_func);
       }
       remove_gc_object(&var_ref->header);
-      js_free_rt(rt, var_ref);
+      js_slab_free_rt(rt, var_ref, sizeof(JSVarRef));
     }
   }
 }
@@ -318,7 +321,7 @@ void free_object(JSRuntime* rt, JSObject* p) {
   remove_gc_object(&p->header);
   if (rt->gc_phase == JS_GC_PHASE_REMOVE_CYCLES) {
     if (p->header.ref_count == 0 && p->weakref_count == 0) {
-      js_free_rt(rt, p);
+      js_slab_free_rt(rt, p, sizeof(JSObject));
     } else {
       /* keep the object structure because there are may be
          references to it */
@@ -327,7 +330,7 @@ void free_object(JSRuntime* rt, JSObject* p) {
   } else {
     /* keep the object structure in case there are weak references to it */
     if (p->weakref_count == 0) {
-      js_free_rt(rt, p);
+      js_slab_free_rt(rt, p, sizeof(JSObject));
     } else {
       p->header.mark = 0; /* reset the mark so that the weakref can be freed */
     }
@@ -434,6 +437,7 @@ void __JS_FreeValueRT(JSRuntime* rt, JSValue v) {
 #ifdef DUMP_LEAKS
         list_del(&p->link);
 #endif
+        js_heap_profiler_free_string(rt, p);
         js_free_rt(rt, p);
       }
     } break;
@@ -457,6 +461,12 @@ void __JS_FreeValueRT(JSRuntime* rt, JSValue v) {
         if (rt->gc_phase == JS_GC_PHASE_NONE) {
           free_zero_refcount(rt);
         }
+      } else if (p->mark == 0) {
+        /* object outside of the scanned generation which was only
+           referenced by the freed cycles */
+        list_del(&p->link);
+        list_add_tail(&p->link, &rt->tmp_obj_list);
+        p->mark = 1;
       }
     } break;
     case JS_TAG_BIG_INT: {
@@ -752,7 +762,9 @@ void gc_decref(JSRuntime* rt) {
 
 void gc_scan_incref_child(JSRuntime* rt, JSGCObjectHeader* p) {
   p->ref_count++;
-  if (p->ref_count == 1) {
+  /* mark = 0 for the objects which are not scanned by a young
+     generation collection */
+  if (p->ref_count == 1 && p->mark == 1) {
     /* ref_count was 0: remove from tmp_obj_list and add at the
        end of gc_obj_list */
     list_del(&p->link);
@@ -835,6 +847,8 @@ void gc_free_cycles(JSRuntime* rt) {
         ((JSObject*)p)->weakref_count != 0) {
       /* keep the object because there are weak references to it */
       p->mark = 0;
+    } else if (p->gc_obj_type == JS_GC_OBJ_TYPE_JS_OBJECT) {
+      js_slab_free_rt(rt, p, sizeof(JSObject));
     } else {
       js_free_rt(rt, p);
     }
@@ -843,14 +857,27 @@ void gc_free_cycles(JSRuntime* rt) {
   init_list_head(&rt->gc_zero_ref_count_list);
 }
 
-void JS_RunGCInternal(JSRuntime* rt, BOOL remove_weak_objects) {
-  if (remove_weak_objects) {
-    /* free the weakly referenced object or symbol structures, delete
-       the associated Map/Set entries and queue the finalization
-       registry callbacks. */
-    gc_remove_weak_objects(rt);
-  }
+/* move the objects of 'from' at the end of 'to' */
+static void gc_list_splice_tail(struct list_head* to, struct list_head* from) {
+  if (list_empty(from))
+    return;
+  from->next->prev = to->prev;
+  to->prev->next = from->next;
+  from->prev->next = to;
+  to->prev = from->prev;
+  init_list_head(from);
+}
+
+void gc_merge_generations(JSRuntime* rt) {
+  gc_list_splice_tail(&rt->gc_obj_list, &rt->gc_old_obj_list);
+}
 
+/* Trial deletion restricted to rt->gc_obj_list: the references coming
+   from the other objects are counted as external references, so the
+   objects they reference are kept. The decremented refcounts of the
+   old objects are restored by gc_scan() and the old objects which
+   become unreferenced are freed with the cycles. */
+void gc_collect_young(JSRuntime* rt) {
   /* decrement the reference of the children of each object. mark =
      1 after this pass. */
   gc_decref(rt);
@@ -860,10 +887,72 @@ void JS_RunGCInternal(JSRuntime* rt, BOOL remove_weak_objects) {
 
   /* free the GC objects in a cycle */
   gc_free_cycles(rt);
+
+  /* the survivors are tenured */
+  gc_list_splice_tail(&rt->gc_old_obj_list, &rt->gc_obj_list);
+}
+
+void JS_RunGCInternal(JSRuntime* rt, BOOL remove_weak_objects) {
+  if (remove_weak_objects) {
+    /* free the weakly referenced object or symbol structures, delete
+       the associated Map/Set entries and queue the finalization
+       registry callbacks. */
+    gc_remove_weak_objects(rt);
+  }
+
+  gc_merge_generations(rt);
+  gc_collect_young(rt);
+  rt->malloc_gc_full_threshold = rt->malloc_state.malloc_size * 2;
 }
 
 void JS_RunGC(JSRuntime* rt) {
+  /* the megamorphic cache holds shape references, drop them so that
+     the cached shapes and their prototypes can be collected */
+  ic_stub_cache_flush(rt);
   JS_RunGCInternal(rt, TRUE);
+  js_slab_trim(rt);
+}
+
+void JS_SetGCGenerational(JSRuntime* rt, BOOL enable) {
+  rt->gc_generational = enable;
+}
+
+static int64_t gc_get_time_us(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+BOOL JS_RunGCStep(JSRuntime* rt, int64_t budget_us) {
+  struct list_head pending, *el;
+  int64_t deadline;
+  int n;
+
+  if (rt->gc_phase != JS_GC_PHASE_NONE)
+    return !list_empty(&rt->gc_obj_list);
+  ic_stub_cache_flush(rt);
+  deadline = gc_get_time_us() + budget_us;
+  do {
+    /* the oldest young objects form the slice, the others wait in
+       'pending' and are seen as external references */
+    init_list_head(&pending);
+    n = 0;
+    list_for_each(el, &rt->gc_obj_list) {
+      if (++n > JS_GC_STEP_SLICE_SIZE)
+        break;
+    }
+    if (el != &rt->gc_obj_list) {
+      pending.next = el;
+      pending.prev = rt->gc_obj_list.prev;
+      pending.prev->next = &pending;
+      rt->gc_obj_list.prev = el->prev;
+      el->prev->next = &rt->gc_obj_list;
+      el->prev = &pending;
+    }
+    gc_collect_young(rt);
+    gc_list_splice_tail(&rt->gc_obj_list, &pending);
+  } while (!list_empty(&rt->gc_obj_list) && gc_get_time_us() < deadline);
+  return !list_empty(&rt->gc_obj_list);
 }
 
 void JS_TurnOffGC(JSRuntime* rt) {
@@ -57,6 +57,12 @@ typedef enum JSFreeModuleEnum {
   JS_FREE_MODULE_NOT_EVALUATED,
 } JSFreeModuleEnum;
 
+/* iterate over the GC objects of the young and old generations */
+#define gc_for_each_obj(el, rt)                                   \
+  for (int gc_gen_ = 0; gc_gen_ < 2; gc_gen_++)                    \
+    list_for_each(                                                 \
+        el, gc_gen_ == 0 ? &(rt)->gc_obj_list : &(rt)->gc_old_obj_list)
+
 void js_object_list_init(JSObjectList* s);
 uint32_t js_object_list_get_hash(JSObject* p, uint32_t hash_size);
 int js_object_list_resize_hash(
@@ -96,6 +102,8 @@ void gc_scan_incref_child2(JSRuntime* rt, JSGCObjectHeader* p);
 void gc_scan(JSRuntime* rt);
 void gc_free_cycles(JSRuntime* rt);
 
+void gc_merge_generations(JSRuntime* rt);
+void gc_collect_young(JSRuntime* rt);
 void JS_RunGCInternal(JSRuntime* rt, BOOL remove_weak_objects);
 void JS_RunGC(JSRuntime* rt);
 
@@ -0,0 +1,1402 @@
+/*
+ * QuickJS Javascript Engine
+ *
+ * Copyright (c) 2017-2025 Fabrice Bellard
+ * Copyright (c) 2017-2025 Charlie Gordon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "heap_profiler.h"
+#include "gc.h"
+#include "malloc.h"
+#include "memory.h"
+#include "profiler.h"
+#include "runtime.h"
+#include "string-utils.h"
+
+/* Allocation site heap profiler. While tracking, the new objects store
+   the index of their allocation site (function and pc of the innermost
+   stack frame) in JSObject.alloc_site and the new strings are recorded
+   in a pointer map. The heap graph is built from the mark_children()
+   edges completed with the property names and the referenced strings.
+   The retained sizes come from its dominator tree. */
+
+#define JS_HEAP_SITE_CACHE_BITS 10
+#define JS_HEAP_SITE_CACHE_SIZE (1 << JS_HEAP_SITE_CACHE_BITS)
+/* max number of characters of the string node names */
+#define JS_HEAP_STRING_NAME_MAX 256
+#define JS_HEAP_DUMP_SITE_COUNT 20
+#define JS_HEAP_NAME_BUF_SIZE 256
+
+/* open addressing map from a non zero key to a 32 bit value */
+typedef struct JSHeapMap {
+  uintptr_t* keys;
+  uint32_t* values;
+  uint32_t count;
+  uint32_t size; /* power of two or 0 */
+} JSHeapMap;
+
+typedef struct JSHeapSite {
+  /* JSFunctionBytecode or C function object, a reference is held.
+     NULL for sites[0] which collects the allocations done outside of
+     any function and the untagged nodes. */
+  JSGCObjectHeader* func;
+  BOOL is_bytecode;
+  uint32_t pc;
+  uint32_t hash_next; /* -1 if no next entry */
+  uint64_t alloc_count;
+  uint64_t alloc_size;
+  uint32_t live_count;
+  uint64_t self_size;
+  uint64_t retained_size;
+} JSHeapSite;
+
+typedef struct JSHeapSiteCacheEntry {
+  JSGCObjectHeader* func;
+  uint32_t pc;
+  uint32_t site;
+} JSHeapSiteCacheEntry;
+
+/* same order as the V8 snapshot node types */
+typedef enum {
+  JS_HEAP_NODE_HIDDEN,
+  JS_HEAP_NODE_ARRAY,
+  JS_HEAP_NODE_STRING,
+  JS_HEAP_NODE_OBJECT,
+  JS_HEAP_NODE_CODE,
+  JS_HEAP_NODE_CLOSURE,
+  JS_HEAP_NODE_REGEXP,
+  JS_HEAP_NODE_NUMBER,
+  JS_HEAP_NODE_NATIVE,
+  JS_HEAP_NODE_SYNTHETIC,
+  JS_HEAP_NODE_CONCATENATED_STRING,
+} JSHeapNodeTypeEnum;
+
+/* same order as the V8 snapshot edge types */
+typedef enum {
+  JS_HEAP_EDGE_CONTEXT,
+  JS_HEAP_EDGE_ELEMENT,
+  JS_HEAP_EDGE_PROPERTY,
+  JS_HEAP_EDGE_INTERNAL,
+  JS_HEAP_EDGE_HIDDEN,
+  JS_HEAP_EDGE_SHORTCUT,
+  JS_HEAP_EDGE_WEAK,
+} JSHeapEdgeTypeEnum;
+
+/* fixed names, the first entries of the snapshot string table */
+enum {
+  JS_HEAP_STR_EMPTY,
+  JS_HEAP_STR_ROOT,
+  JS_HEAP_STR_SHAPE,
+  JS_HEAP_STR_VAR_REF,
+  JS_HEAP_STR_ASYNC_FUNCTION,
+  JS_HEAP_STR_CONTEXT,
+  JS_HEAP_STR_MODULE,
+  JS_HEAP_STR_PROTO,
+  JS_HEAP_STR_VALUE,
+  JS_HEAP_STR_LEFT,
+  JS_HEAP_STR_RIGHT,
+  JS_HEAP_STR_ANONYMOUS,
+  JS_HEAP_STR_COUNT,
+};
+
+static const char* const js_heap_fixed_strings[JS_HEAP_STR_COUNT] = {
+    "",
+    "(GC roots)",
+    "(shape)",
+    "(closure variable)",
+    "(async function)",
+    "(context)",
+    "(module)",
+    "__proto__",
+    "value",
+    "left",
+    "right",
+    "(anonymous)",
+};
+
+typedef struct JSHeapNode {
+  /* JSGCObjectHeader, JSString or JSStringRope, NULL for the root */
+  void* ptr;
+  uint8_t type; /* JS_HEAP_NODE_x */
+  BOOL is_gc_object;
+  uint32_t site;
+  uint32_t self_size;
+  uint32_t ref_count; /* number of references from the GC objects */
+  uint32_t last_src; /* used to merge the duplicated edges */
+  uint32_t edge_start;
+  uint32_t edge_count;
+  uint64_t retained_size;
+} JSHeapNode;
+
+typedef struct JSHeapEdge {
+  uint8_t type; /* JS_HEAP_EDGE_x */
+  /* atom for the property edges, index for the element edges and
+     JS_HEAP_STR_x for the other edges */
+  uint32_t name;
+  uint32_t to;
+} JSHeapEdge;
+
+typedef struct JSHeapGraph {
+  JSHeapNode* nodes; /* nodes[0] is the root */
+  uint32_t node_count;
+  uint32_t node_size;
+  JSHeapEdge* edges;
+  uint32_t edge_count;
+  uint32_t edge_size;
+  JSHeapMap node_map; /* pointer -> node index */
+  uint32_t cur_node; /* node whose children are marked */
+  BOOL out_of_memory;
+} JSHeapGraph;
+
+struct JSHeapProfiler {
+  BOOL tracking;
+  JSHeapSite* sites;
+  uint32_t site_count;
+  uint32_t site_size;
+  uint32_t* site_hash;
+  uint32_t site_hash_size; /* power of two */
+  JSHeapMap strings; /* JSString pointer -> site */
+  JSHeapGraph* graph; /* only set while the graph is built */
+  JSHeapSiteCacheEntry site_cache[JS_HEAP_SITE_CACHE_SIZE];
+};
+
+static uint32_t js_heap_map_hash(uintptr_t key, uint32_t size) {
+  uint64_t h = (uint64_t)key * 0x9e3779b97f4a7c15;
+  return (uint32_t)(h >> 32) & (size - 1);
+}
+
+static int js_heap_map_resize(JSRuntime* rt, JSHeapMap* m, uint32_t new_size) {
+  uintptr_t* keys;
+  uint32_t* values;
+  uint32_t i, h;
+
+  keys = js_mallocz_rt(rt, sizeof(keys[0]) * new_size);
+  values = js_malloc_rt(rt, sizeof(values[0]) * new_size);
+  if (!keys || !values) {
+    js_free_rt(rt, keys);
+    js_free_rt(rt, values);
+    return -1;
+  }
+  for (i = 0; i < m->size; i++) {
+    if (m->keys[i]) {
+      h = js_heap_map_hash(m->keys[i], new_size);
+      while (keys[h])
+        h = (h + 1) & (new_size - 1);
+      keys[h] = m->keys[i];
+      values[h] = m->values[i];
+    }
+  }
+  js_free_rt(rt, m->keys);
+  js_free_rt(rt, m->values);
+  m->keys = keys;
+  m->values = values;
+  m->size = new_size;
+  return 0;
+}
+
+static void js_heap_map_free(JSRuntime* rt, JSHeapMap* m) {
+  js_free_rt(rt, m->keys);
+  js_free_rt(rt, m->values);
+  memset(m, 0, sizeof(*m));
+}
+
+/* return the slot of 'key' or the free slot where it can be added */
+static uint32_t js_heap_map_slot(JSHeapMap* m, uintptr_t key) {
+  uint32_t h = js_heap_map_hash(key, m->size);
+  while (m->keys[h] && m->keys[h] != key)
+    h = (h + 1) & (m->size - 1);
+  return h;
+}
+
+static int
+js_heap_map_set(JSRuntime* rt, JSHeapMap* m, uintptr_t key, uint32_t value) {
+  uint32_t h;
+  if (2 * (m->count + 1) > m->size) {
+    if (js_heap_map_resize(rt, m, max_int(m->size * 2, 64)))
+      return -1;
+  }
+  h = js_heap_map_slot(m, key);
+  if (!m->keys[h]) {
+    m->keys[h] = key;
+    m->count++;
+  }
+  m->values[h] = value;
+  return 0;
+}
+
+static BOOL js_heap_map_get(JSHeapMap* m, uintptr_t key, uint32_t* pvalue) {
+  uint32_t h;
+  if (m->count == 0)
+    return FALSE;
+  h = js_heap_map_slot(m, key);
+  if (!m->keys[h])
+    return FALSE;
+  *pvalue = m->values[h];
+  return TRUE;
+}
+
+static BOOL js_heap_map_delete(JSHeapMap* m, uintptr_t key, uint32_t* pvalue) {
+  uint32_t i, j, h, mask;
+
+  if (m->count == 0)
+    return FALSE;
+  i = js_heap_map_slot(m, key);
+  if (!m->keys[i])
+    return FALSE;
+  *pvalue = m->values[i];
+  /* move back the next entries of the cluster which are not in the
+     cyclic range (i, j] of their hash slot */
+  mask = m->size - 1;
+  for (j = (i + 1) & mask; m->keys[j]; j = (j + 1) & mask) {
+    h = js_heap_map_hash(m->keys[j], m->size);
+    if (i < j ? (h <= i || h > j) : (h <= i && h > j)) {
+      m->keys[i] = m->keys[j];
+      m->values[i] = m->values[j];
+      i = j;
+    }
+  }
+  m->keys[i] = 0;
+  m->count--;
+  return TRUE;
+}
+
+static uint32_t js_heap_site_hash(
+    JSGCObjectHeader* func,
+    uint32_t pc,
+    uint32_t hash_size) {
+  return (js_profiler_hash_ptr(func, hash_size) ^ (pc * 0x9e370001)) &
+      (hash_size - 1);
+}
+
+static int js_heap_find_site(
+    JSRuntime* rt,
+    JSHeapProfiler* s,
+    JSGCObjectHeader* func,
+    BOOL is_bytecode,
+    uint32_t pc) {
+  JSHeapSite* site;
+  uint32_t h, i;
+  int ret;
+
+  if (s->site_hash) {
+    h = js_heap_site_hash(func, pc, s->site_hash_size);
+    for (i = s->site_hash[h]; i != -1; i = s->sites[i].hash_next) {
+      if (s->sites[i].func == func && s->sites[i].pc == pc)
+        return i;
+    }
+  }
+  if (js_profiler_grow(
+          rt, (void**)&s->sites, &s->site_size, s->site_count, sizeof(*site)))
+    return -1;
+  ret = js_profiler_resize_hash(
+      rt, &s->site_hash, &s->site_hash_size, s->site_count);
+  if (ret < 0)
+    return -1;
+  if (ret > 0) {
+    /* sites[0] is not hashed */
+    for (i = 1; i < s->site_count; i++) {
+      site = &s->sites[i];
+      h = js_heap_site_hash(site->func, site->pc, s->site_hash_size);
+      site->hash_next = s->site_hash[h];
+      s->site_hash[h] = i;
+    }
+  }
+  i = s->site_count++;
+  site = &s->sites[i];
+  memset(site, 0, sizeof(*site));
+  site->func = func;
+  site->is_bytecode = is_bytecode;
+  site->pc = pc;
+  func->ref_count++;
+  h = js_heap_site_hash(func, pc, s->site_hash_size);
+  site->hash_next = s->site_hash[h];
+  s->site_hash[h] = i;
+  return i;
+}
+
+uint32_t __js_heap_profiler_alloc_site(JSRuntime* rt, size_t size) {
+  JSHeapProfiler* s = rt->heap_profiler;
+  JSStackFrame* sf = rt->current_stack_frame;
+  JSHeapSiteCacheEntry* e;
+  JSGCObjectHeader* func;
+  JSFunctionBytecode* b = NULL;
+  JSObject* p;
+  uint32_t pc = 0;
+  int site = 0;
+
+  if (!s->tracking)
+    return 0;
+  if (sf && JS_VALUE_GET_TAG(sf->cur_func) == JS_TAG_OBJECT) {
+    p = JS_VALUE_GET_OBJ(sf->cur_func);
+    if (js_class_has_bytecode(p->class_id)) {
+      b = p->u.func.function_bytecode;
+      func = &b->header;
+      if (b->byte_code_buf && sf->cur_pc > b->byte_code_buf &&
+          sf->cur_pc <= b->byte_code_buf + b->byte_code_len)
+        pc = sf->cur_pc - b->byte_code_buf - 1;
+    } else {
+      func = &p->header;
+    }
+    e = &s->site_cache
+             [(js_profiler_hash_ptr(func, JS_HEAP_SITE_CACHE_SIZE) ^ pc) &
+              (JS_HEAP_SITE_CACHE_SIZE - 1)];
+    if (e->func == func && e->pc == pc) {
+      site = e->site;
+    } else {
+      site = js_heap_find_site(rt, s, func, b != NULL, pc);
+      if (site < 0) {
+        site = 0;
+      } else {
+        /* the cached function cannot be freed while it is a site */
+        e->func = func;
+        e->pc = pc;
+        e->site = site;
+      }
+    }
+  }
+  s->sites[site].alloc_count++;
+  s->sites[site].alloc_size += size;
+  return site;
+}
+
+static size_t js_heap_string_size(JSString* str) {
+  return sizeof(*str) + (str->len << str->is_wide_char) + 1 -
+      str->is_wide_char;
+}
+
+void __js_heap_profiler_tag_string(JSRuntime* rt, JSString* str) {
+  JSHeapProfiler* s = rt->heap_profiler;
+  uint32_t site;
+
+  if (!s->tracking)
+    return;
+  site = __js_heap_profiler_alloc_site(rt, js_heap_string_size(str));
+  /* the string is not tagged if the map cannot be resized */
+  if (site != 0)
+    js_heap_map_set(rt, &s->strings, (uintptr_t)str, site);
+}
+
+void __js_heap_profiler_untag_string(
+    JSRuntime* rt,
+    JSString* str,
+    BOOL cancel_alloc) {
+  JSHeapProfiler* s = rt->heap_profiler;
+  uint32_t site;
+
+  if (js_heap_map_delete(&s->strings, (uintptr_t)str, &site) &&
+      cancel_alloc) {
+    s->sites[site].alloc_count--;
+    s->sites[site].alloc_size -= js_heap_string_size(str);
+  }
+}
+
+static JSHeapProfiler* js_heap_profiler_new(JSRuntime* rt) {
+  JSHeapProfiler* s;
+
+  s = js_mallocz_rt(rt, sizeof(*s));
+  if (!s)
+    return NULL;
+  if (js_profiler_grow(
+          rt, (void**)&s->sites, &s->site_size, 0, sizeof(s->sites[0]))) {
+    js_free_rt(rt, s);
+    return NULL;
+  }
+  memset(&s->sites[0], 0, sizeof(s->sites[0]));
+  s->sites[0].hash_next = -1;
+  s->site_count = 1;
+  return s;
+}
+
+int js_heap_profiler_start(JSRuntime* rt) {
+  JSHeapProfiler* s;
+  struct list_head* el;
+
+  js_heap_profiler_free(rt);
+  s = js_heap_profiler_new(rt);
+  if (!s)
+    return -1;
+  /* forget the sites of a previous profile */
+  gc_for_each_obj(el, rt) {
+    JSGCObjectHeader* gp = list_entry(el, JSGCObjectHeader, link);
+    if (gp->gc_obj_type == JS_GC_OBJ_TYPE_JS_OBJECT)
+      ((JSObject*)gp)->alloc_site = 0;
+  }
+  s->tracking = TRUE;
+  rt->heap_profiler = s;
+  return 0;
+}
+
+void js_heap_profiler_stop(JSRuntime* rt) {
+  if (rt->heap_profiler)
+    rt->heap_profiler->tracking = FALSE;
+}
+
+void js_heap_profiler_free(JSRuntime* rt) {
+  JSHeapProfiler* s = rt->heap_profiler;
+  uint32_t i;
+
+  if (!s)
+    return;
+  /* the strings freed from now on must not be looked up */
+  rt->heap_profiler = NULL;
+  for (i = 1; i < s->site_count; i++) {
+    JSHeapSite* site = &s->sites[i];
+    JS_FreeValueRT(
+        rt,
+        JS_MKPTR(
+            site->is_bytecode ? JS_TAG_FUNCTION_BYTECODE : JS_TAG_OBJECT,
+            site->func));
+  }
+  js_free_rt(rt, s->sites);
+  js_free_rt(rt, s->site_hash);
+  js_heap_map_free(rt, &s->strings);
+  js_free_rt(rt, s);
+}
+
+/* heap graph */
+
+static int js_heap_graph_add_node(
+    JSRuntime* rt,
+    JSHeapGraph* g,
+    void* ptr,
+    int type,
+    BOOL is_gc_object,
+    uint32_t site,
+    size_t self_size) {
+  JSHeapNode* n;
+  uint32_t i;
+
+  if (js_profiler_grow(
+          rt, (void**)&g->nodes, &g->node_size, g->node_count, sizeof(*n)))
+    return -1;
+  i = g->node_count;
+  if (ptr && js_heap_map_set(rt, &g->node_map, (uintptr_t)ptr, i))
+    return -1;
+  g->node_count++;
+  n = &g->nodes[i];
+  memset(n, 0, sizeof(*n));
+  n->ptr = ptr;
+  n->type = type;
+  n->is_gc_object = is_gc_object;
+  n->site = site;
+  n->self_size = self_size > UINT32_MAX ? UINT32_MAX : self_size;
+  n->last_src = -1;
+  return i;
+}
+
+static void js_heap_graph_add_edge(
+    JSRuntime* rt,
+    JSHeapGraph* g,
+    int type,
+    uint32_t name,
+    uint32_t to) {
+  JSHeapEdge* e;
+  if (js_profiler_grow(
+          rt, (void**)&g->edges, &g->edge_size, g->edge_count, sizeof(*e))) {
+    g->out_of_memory = TRUE;
+    return;
+  }
+  e = &g->edges[g->edge_count++];
+  e->type = type;
+  e->name = name;
+  e->to = to;
+  g->nodes[to].last_src = g->cur_node;
+}
+
+static int js_heap_gc_object_node_type(JSGCObjectHeader* gp) {
+  JSObject* p;
+
+  switch (gp->gc_obj_type) {
+    case JS_GC_OBJ_TYPE_JS_OBJECT:
+      p = (JSObject*)gp;
+      switch (p->class_id) {
+        case JS_CLASS_C_FUNCTION:
+        case JS_CLASS_BOUND_FUNCTION:
+        case JS_CLASS_C_FUNCTION_DATA:
+          return JS_HEAP_NODE_CLOSURE;
+        case JS_CLASS_REGEXP:
+          return JS_HEAP_NODE_REGEXP;
+        default:
+          if (js_class_has_bytecode(p->class_id))
+            return JS_HEAP_NODE_CLOSURE;
+          return JS_HEAP_NODE_OBJECT;
+      }
+    case JS_GC_OBJ_TYPE_FUNCTION_BYTECODE:
+      return JS_HEAP_NODE_CODE;
+    default:
+      return JS_HEAP_NODE_HIDDEN;
+  }
+}
+
+/* return the node of a string, it is added to the graph if needed. -1
+   if memory error. */
+static int
+js_heap_graph_get_string_node(JSRuntime* rt, JSHeapGraph* g, JSValueConst val) {
+  JSHeapProfiler* s = rt->heap_profiler;
+  void* ptr = JS_VALUE_GET_PTR(val);
+  uint32_t i, site = 0;
+
+  if (js_heap_map_get(&g->node_map, (uintptr_t)ptr, &i))
+    return i;
+  if (JS_VALUE_GET_TAG(val) == JS_TAG_STRING_ROPE) {
+    return js_heap_graph_add_node(
+        rt,
+        g,
+        ptr,
+        JS_HEAP_NODE_CONCATENATED_STRING,
+        FALSE,
+        0,
+        sizeof(JSStringRope));
+  }
+  js_heap_map_get(&s->strings, (uintptr_t)ptr, &site);
+  return js_heap_graph_add_node(
+      rt,
+      g,
+      ptr,
+      JS_HEAP_NODE_STRING,
+      FALSE,
+      site,
+      js_heap_string_size(ptr));
+}
+
+/* add an edge to a value referenced by the current node. Unlike the
+   mark_children() edges, several edges may go to the same node. */
+static void js_heap_graph_add_value_edge(
+    JSRuntime* rt,
+    JSHeapGraph* g,
+    int type,
+    uint32_t name,
+    JSValueConst val) {
+  uint32_t to;
+  int ret;
+
+  switch (JS_VALUE_GET_TAG(val)) {
+    case JS_TAG_STRING:
+    case JS_TAG_STRING_ROPE:
+      ret = js_heap_graph_get_string_node(rt, g, val);
+      if (ret < 0) {
+        g->out_of_memory = TRUE;
+        return;
+      }
+      to = ret;
+      break;
+    case JS_TAG_OBJECT:
+    case JS_TAG_FUNCTION_BYTECODE:
+    case JS_TAG_MODULE:
+      if (!js_heap_map_get(&g->node_map, (uintptr_t)JS_VALUE_GET_PTR(val), &to))
+        return;
+      break;
+    default:
+      return;
+  }
+  js_heap_graph_add_edge(rt, g, type, name, to);
+}
+
+static void js_heap_graph_mark_child(JSRuntime* rt, JSGCObjectHeader* gp) {
+  JSHeapGraph* g = rt->heap_profiler->graph;
+  JSHeapNode* src;
+  uint32_t to, name;
+
+  if (!js_heap_map_get(&g->node_map, (uintptr_t)gp, &to))
+    return;
+  g->nodes[to].ref_count++;
+  /* already referenced by a named edge */
+  if (g->nodes[to].last_src == g->cur_node)
+    return;
+  src = &g->nodes[g->cur_node];
+  if (gp->gc_obj_type == JS_GC_OBJ_TYPE_SHAPE) {
+    name = JS_HEAP_STR_SHAPE;
+  } else if (
+      src->is_gc_object &&
+      ((JSGCObjectHeader*)src->ptr)->gc_obj_type == JS_GC_OBJ_TYPE_SHAPE) {
+    name = JS_HEAP_STR_PROTO;
+  } else if (gp->gc_obj_type == JS_GC_OBJ_TYPE_VAR_REF) {
+    name = JS_HEAP_STR_VAR_REF;
+  } else {
+    name = JS_HEAP_STR_EMPTY;
+  }
+  js_heap_graph_add_edge(rt, g, JS_HEAP_EDGE_INTERNAL, name, to);
+}
+
+static void js_heap_graph_add_object_edges(
+    JSRuntime* rt,
+    JSHeapGraph* g,
+    JSObject* p) {
+  JSShape* sh = p->shape;
+  JSShapeProperty* prs;
+  JSProperty* pr;
+  uint32_t i;
+  int type;
+
+  prs = get_shape_prop(sh);
+  for (i = 0; i < sh->prop_count; i++, prs++) {
+    pr = &p->prop[i];
+    if (prs->atom == JS_ATOM_NULL)
+      continue;
+    if (__JS_AtomIsTaggedInt(prs->atom)) {
+      type = JS_HEAP_EDGE_ELEMENT;
+    } else {
+      type = JS_HEAP_EDGE_PROPERTY;
+    }
+    switch (prs->flags & JS_PROP_TMASK) {
+      case JS_PROP_NORMAL:
+        js_heap_graph_add_value_edge(rt, g, type, prs->atom, pr->u.value);
+        break;
+      case JS_PROP_GETSET:
+        if (pr->u.getset.getter) {
+          js_heap_graph_add_value_edge(
+              rt,
+              g,
+              type,
+              prs->atom,
+              JS_MKPTR(JS_TAG_OBJECT, pr->u.getset.getter));
+        }
+        if (pr->u.getset.setter) {
+          js_heap_graph_add_value_edge(
+              rt,
+              g,
+              type,
+              prs->atom,
+              JS_MKPTR(JS_TAG_OBJECT, pr->u.getset.setter));
+        }
+        break;
+      case JS_PROP_VARREF:
+        if (pr->u.var_ref->is_detached) {
+          js_heap_graph_add_value_edge(
+              rt, g, type, prs->atom, *pr->u.var_ref->pvalue);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  switch (p->class_id) {
+    case JS_CLASS_ARRAY:
+    case JS_CLASS_ARGUMENTS:
+      if (p->fast_array) {
+        for (i = 0; i < p->u.array.count; i++) {
+          js_heap_graph_add_value_edge(
+              rt,
+              g,
+              JS_HEAP_EDGE_ELEMENT,
+              __JS_AtomFromUInt32(i),
+              p->u.array.u.values[i]);
+        }
+      }
+      break;
+    case JS_CLASS_STRING:
+      js_heap_graph_add_value_edge(
+          rt, g, JS_HEAP_EDGE_INTERNAL, JS_HEAP_STR_VALUE, p->u.object_data);
+      break;
+    default:
+      break;
+  }
+}
+
+static void js_heap_graph_free(JSRuntime* rt, JSHeapGraph* g) {
+  js_free_rt(rt, g->nodes);
+  js_free_rt(rt, g->edges);
+  js_heap_map_free(rt, &g->node_map);
+}
+
+static int js_heap_graph_build(JSRuntime* rt, JSHeapGraph* g) {
+  JSHeapProfiler* s = rt->heap_profiler;
+  struct list_head* el;
+  JSHeapNode* n;
+  uint32_t i, j, k, site;
+
+  memset(g, 0, sizeof(*g));
+  if (js_heap_graph_add_node(
+          rt, g, NULL, JS_HEAP_NODE_SYNTHETIC, FALSE, 0, 0) < 0)
+    goto fail;
+  gc_for_each_obj(el, rt) {
+    JSGCObjectHeader* gp = list_entry(el, JSGCObjectHeader, link);
+    site = 0;
+    if (gp->gc_obj_type == JS_GC_OBJ_TYPE_JS_OBJECT) {
+      site = ((JSObject*)gp)->alloc_site;
+      if (site >= s->site_count)
+        site = 0;
+    }
+    if (js_heap_graph_add_node(
+            rt,
+            g,
+            gp,
+            js_heap_gc_object_node_type(gp),
+            TRUE,
+            site,
+            js_gc_object_self_size(rt, gp)) < 0)
+      goto fail;
+  }
+
+  /* the string nodes are added while the edges are built */
+  s->graph = g;
+  for (i = 1; i < g->node_count && !g->out_of_memory; i++) {
+    n = &g->nodes[i];
+    g->cur_node = i;
+    n->edge_start = g->edge_count;
+    if (n->is_gc_object) {
+      JSGCObjectHeader* gp = n->ptr;
+      if (gp->gc_obj_type == JS_GC_OBJ_TYPE_JS_OBJECT) {
+        js_heap_graph_add_object_edges(rt, g, (JSObject*)gp);
+      } else if (gp->gc_obj_type == JS_GC_OBJ_TYPE_VAR_REF) {
+        JSVarRef* var_ref = (JSVarRef*)gp;
+        if (var_ref->is_detached) {
+          js_heap_graph_add_value_edge(
+              rt,
+              g,
+              JS_HEAP_EDGE_INTERNAL,
+              JS_HEAP_STR_VALUE,
+              *var_ref->pvalue);
+        }
+      }
+      mark_children(rt, gp, js_heap_graph_mark_child);
+    } else if (n->type == JS_HEAP_NODE_CONCATENATED_STRING) {
+      JSStringRope* r = n->ptr;
+      js_heap_graph_add_value_edge(
+          rt, g, JS_HEAP_EDGE_INTERNAL, JS_HEAP_STR_LEFT, r->left);
+      js_heap_graph_add_value_edge(
+          rt, g, JS_HEAP_EDGE_INTERNAL, JS_HEAP_STR_RIGHT, r->right);
+    }
+    /* 'n' may have been moved */
+    g->nodes[i].edge_count = g->edge_count - g->nodes[i].edge_start;
+  }
+  s->graph = NULL;
+  if (g->out_of_memory)
+    goto fail;
+
+  /* the functions referenced by the sites are not roots */
+  for (i = 1; i < s->site_count; i++) {
+    if (js_heap_map_get(&g->node_map, (uintptr_t)s->sites[i].func, &j))
+      g->nodes[j].ref_count++;
+  }
+
+  /* the GC objects referenced from outside of the heap are the roots */
+  g->cur_node = 0;
+  g->nodes[0].edge_start = g->edge_count;
+  k = 0;
+  for (i = 1; i < g->node_count; i++) {
+    n = &g->nodes[i];
+    if (n->is_gc_object &&
+        ((JSGCObjectHeader*)n->ptr)->ref_count > (int)n->ref_count) {
+      js_heap_graph_add_edge(rt, g, JS_HEAP_EDGE_ELEMENT, k++, i);
+    }
+  }
+  if (g->out_of_memory)
+    goto fail;
+  g->nodes[0].edge_count = g->edge_count - g->nodes[0].edge_start;
+  return 0;
+fail:
+  s->graph = NULL;
+  js_heap_graph_free(rt, g);
+  return -1;
+}
+
+/* Compute the dominator tree with the Cooper, Harvey and Kennedy
+   iterative algorithm, then the retained sizes of the nodes and of
+   the sites. The retained size of a site does not count twice the
+   nodes dominated by another node of the same site. */
+static int js_heap_graph_compute_retained(JSRuntime* rt, JSHeapGraph* g) {
+  JSHeapProfiler* s = rt->heap_profiler;
+  uint32_t node_count = g->node_count;
+  uint32_t *post, *order, *idom, *stack, *pos, *pred_start, *preds;
+  uint32_t *child_start, *children, *path_count;
+  uint32_t i, j, v, w, b, new_idom, count, sp;
+  BOOL changed;
+  int ret = -1;
+
+  post = js_malloc_rt(rt, sizeof(post[0]) * node_count);
+  order = js_malloc_rt(rt, sizeof(order[0]) * node_count);
+  idom = js_malloc_rt(rt, sizeof(idom[0]) * node_count);
+  stack = js_malloc_rt(rt, sizeof(stack[0]) * node_count);
+  pos = js_malloc_rt(rt, sizeof(pos[0]) * node_count);
+  pred_start = js_mallocz_rt(rt, sizeof(pred_start[0]) * (node_count + 1));
+  preds = js_malloc_rt(rt, sizeof(preds[0]) * max_int(g->edge_count, 1));
+  child_start = js_mallocz_rt(rt, sizeof(child_start[0]) * (node_count + 1));
+  children = js_malloc_rt(rt, sizeof(children[0]) * node_count);
+  path_count = js_mallocz_rt(rt, sizeof(path_count[0]) * s->site_count);
+  if (!post || !order || !idom || !stack || !pos || !pred_start || !preds ||
+      !child_start || !children || !path_count)
+    goto done;
+
+  /* depth first post order from the root. post[v] = -1 if v is not
+     reachable. */
+  for (i = 0; i < node_count; i++)
+    post[i] = -1;
+  count = 0;
+  sp = 0;
+  stack[sp] = 0;
+  pos[sp++] = g->nodes[0].edge_start;
+  post[0] = -2;
+  while (sp > 0) {
+    v = stack[sp - 1];
+    if (pos[sp - 1] < g->nodes[v].edge_start + g->nodes[v].edge_count) {
+      w = g->edges[pos[sp - 1]++].to;
+      if (post[w] == -1) {
+        post[w] = -2;
+        stack[sp] = w;
+        pos[sp++] = g->nodes[w].edge_start;
+      }
+    } else {
+      post[v] = count;
+      order[count++] = v;
+      sp--;
+    }
+  }
+
+  /* predecessors of the reachable nodes */
+  for (i = 0; i < count; i++) {
+    v = order[i];
+    for (j = 0; j < g->nodes[v].edge_count; j++)
+      pred_start[g->edges[g->nodes[v].edge_start + j].to + 1]++;
+  }
+  for (i = 0; i < node_count; i++)
+    pred_start[i + 1] += pred_start[i];
+  for (i = 0; i < node_count; i++)
+    pos[i] = pred_start[i];
+  for (i = 0; i < count; i++) {
+    v = order[i];
+    for (j = 0; j < g->nodes[v].edge_count; j++) {
+      w = g->edges[g->nodes[v].edge_start + j].to;
+      preds[pos[w]++] = v;
+    }
+  }
+
+  for (i = 0; i < node_count; i++)
+    idom[i] = -1;
+  idom[0] = 0;
+  do {
+    changed = FALSE;
+    /* reverse post order, the root is the last node */
+    for (i = count - 1; i-- > 0;) {
+      b = order[i];
+      new_idom = -1;
+      for (j = pred_start[b]; j < pred_start[b + 1]; j++) {
+        v = preds[j];
+        if (idom[v] == -1)
+          continue;
+        if (new_idom == -1) {
+          new_idom = v;
+        } else {
+          w = new_idom;
+          while (v != w) {
+            while (post[v] < post[w])
+              v = idom[v];
+            while (post[w] < post[v])
+              w = idom[w];
+          }
+          new_idom = v;
+        }
+      }
+      if (idom[b] != new_idom) {
+        idom[b] = new_idom;
+        changed = TRUE;
+      }
+    }
+  } while (changed);
+
+  /* the dominated nodes come first in post order */
+  for (i = 0; i < node_count; i++)
+    g->nodes[i].retained_size = post[i] == -1 ? 0 : g->nodes[i].self_size;
+  for (i = 0; i + 1 < count; i++) {
+    v = order[i];
+    g->nodes[idom[v]].retained_size += g->nodes[v].retained_size;
+  }
+
+  /* dominator tree */
+  for (i = 0; i + 1 < count; i++)
+    child_start[idom[order[i]] + 1]++;
+  for (i = 0; i < node_count; i++)
+    child_start[i + 1] += child_start[i];
+  for (i = 0; i < node_count; i++)
+    pos[i] = child_start[i];
+  for (i = 0; i + 1 < count; i++) {
+    v = order[i];
+    children[pos[idom[v]]++] = v;
+  }
+
+  for (i = 0; i < s->site_count; i++) {
+    s->sites[i].live_count = 0;
+    s->sites[i].self_size = 0;
+    s->sites[i].retained_size = 0;
+  }
+  /* pre order walk of the dominator tree counting the sites of the
+     dominators of each node */
+  sp = 0;
+  stack[sp] = 0;
+  pos[sp++] = child_start[0];
+  while (sp > 0) {
+    v = stack[sp - 1];
+    if (pos[sp - 1] < child_start[v + 1]) {
+      w = children[pos[sp - 1]++];
+      b = g->nodes[w].site;
+      s->sites[b].live_count++;
+      s->sites[b].self_size += g->nodes[w].self_size;
+      if (path_count[b]++ == 0)
+        s->sites[b].retained_size += g->nodes[w].retained_size;
+      stack[sp] = w;
+      pos[sp++] = child_start[w];
+    } else {
+      if (v != 0)
+        path_count[g->nodes[v].site]--;
+      sp--;
+    }
+  }
+  ret = 0;
+done:
+  js_free_rt(rt, post);
+  js_free_rt(rt, order);
+  js_free_rt(rt, idom);
+  js_free_rt(rt, stack);
+  js_free_rt(rt, pos);
+  js_free_rt(rt, pred_start);
+  js_free_rt(rt, preds);
+  js_free_rt(rt, child_start);
+  js_free_rt(rt, children);
+  js_free_rt(rt, path_count);
+  return ret;
+}
+
+int js_heap_profiler_compute(JSRuntime* rt) {
+  JSHeapGraph graph;
+  int ret;
+
+  if (!rt->heap_profiler)
+    return 0;
+  if (js_heap_graph_build(rt, &graph))
+    return -1;
+  ret = js_heap_graph_compute_retained(rt, &graph);
+  js_heap_graph_free(rt, &graph);
+  return ret;
+}
+
+/* fill the location fields of 'st'. 'name_buf' and 'filename_buf' are
+   used to store the strings. */
+static void js_heap_site_get_location(
+    JSRuntime* rt,
+    JSHeapSite* site,
+    JSHeapSiteStats* st,
+    char* name_buf,
+    char* filename_buf,
+    int buf_size) {
+  st->func_name = js_heap_fixed_strings[JS_HEAP_STR_ANONYMOUS];
+  st->filename = NULL;
+  st->line_num = 0;
+  st->col_num = 0;
+  if (!site->func)
+    return;
+  if (site->is_bytecode) {
+    JSFunctionBytecode* b = (JSFunctionBytecode*)site->func;
+    if (b->func_name != JS_ATOM_NULL)
+      st->func_name = JS_AtomGetStrRT(rt, name_buf, buf_size, b->func_name);
+    if (b->has_debug) {
+      if (b->debug.filename != JS_ATOM_NULL) {
+        st->filename =
+            JS_AtomGetStrRT(rt, filename_buf, buf_size, b->debug.filename);
+      }
+      st->line_num = find_line_num(b->realm, b, site->pc, &st->col_num);
+      if (st->line_num < 0) {
+        st->line_num = 0;
+        st->col_num = 0;
+      }
+    }
+  } else {
+    JSObject* p = (JSObject*)site->func;
+    JSContext* realm = p->class_id == JS_CLASS_C_FUNCTION ? p->u.cfunc.realm
+                                                          : NULL;
+    const char* name;
+    if (realm) {
+      name = get_func_name(realm, JS_MKPTR(JS_TAG_OBJECT, p));
+      if (name) {
+        if (name[0] != '\0') {
+          pstrcpy(name_buf, buf_size, name);
+          st->func_name = name_buf;
+        }
+        JS_FreeCString(realm, name);
+      }
+    }
+  }
+  if (st->func_name[0] == '\0')
+    st->func_name = js_heap_fixed_strings[JS_HEAP_STR_ANONYMOUS];
+}
+
+static void js_heap_site_get_stats(
+    JSRuntime* rt,
+    JSHeapSite* site,
+    JSHeapSiteStats* st,
+    char* name_buf,
+    char* filename_buf,
+    int buf_size) {
+  js_heap_site_get_location(rt, site, st, name_buf, filename_buf, buf_size);
+  st->alloc_count = site->alloc_count;
+  st->alloc_size = site->alloc_size;
+  st->live_count = site->live_count;
+  st->self_size = site->self_size;
+  st->retained_size = site->retained_size;
+}
+
+void js_heap_profiler_for_each_site(
+    JSRuntime* rt,
+    JSHeapSiteFunc* func,
+    void* opaque) {
+  JSHeapProfiler* s = rt->heap_profiler;
+  char name_buf[JS_HEAP_NAME_BUF_SIZE], filename_buf[JS_HEAP_NAME_BUF_SIZE];
+  JSHeapSiteStats st;
+  uint32_t i;
+
+  if (!s)
+    return;
+  for (i = 1; i < s->site_count; i++) {
+    js_heap_site_get_stats(
+        rt, &s->sites[i], &st, name_buf, filename_buf, sizeof(name_buf));
+    func(rt, &st, opaque);
+  }
+}
+
+static int js_heap_site_cmp(const void* a, const void* b, void* opaque) {
+  JSHeapProfiler* s = opaque;
+  uint64_t size_a = s->sites[*(const uint32_t*)a].retained_size;
+  uint64_t size_b = s->sites[*(const uint32_t*)b].retained_size;
+  return (size_a < size_b) - (size_a > size_b);
+}
+
+void js_heap_profiler_dump(FILE* fp, JSRuntime* rt) {
+  JSHeapProfiler* s = rt->heap_profiler;
+  char name_buf[JS_HEAP_NAME_BUF_SIZE], filename_buf[JS_HEAP_NAME_BUF_SIZE];
+  JSHeapSiteStats st;
+  uint32_t* tab;
+  uint32_t i, n;
+
+  if (!s || js_heap_profiler_compute(rt))
+    return;
+  n = s->site_count - 1;
+  tab = js_malloc_rt(rt, sizeof(tab[0]) * max_int(n, 1));
+  if (!tab)
+    return;
+  for (i = 0; i < n; i++)
+    tab[i] = i + 1;
+  rqsort(tab, n, sizeof(tab[0]), js_heap_site_cmp, s);
+  fprintf(
+      fp,
+      "\n"
+      "Allocation sites\n"
+      "  %8s %10s %10s %10s  %s\n",
+      "LIVE",
+      "SELF",
+      "RETAINED",
+      "ALLOCATED",
+      "FUNCTION");
+  for (i = 0; i < min_uint32(n, JS_HEAP_DUMP_SITE_COUNT); i++) {
+    js_heap_site_get_stats(
+        rt, &s->sites[tab[i]], &st, name_buf, filename_buf, sizeof(name_buf));
+    fprintf(
+        fp,
+        "  %8u %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "  %s %s:%d:%d\n",
+        st.live_count,
+        st.self_size,
+        st.retained_size,
+        st.alloc_size,
+        st.func_name,
+        st.filename ? st.filename : "?",
+        st.line_num,
+        st.col_num);
+  }
+  js_free_rt(rt, tab);
+}
+
+/* heap snapshot */
+
+typedef struct JSHeapSnapshotStrings {
+  DynBuf dbuf; /* comma separated JSON strings */
+  uint32_t count;
+  JSHeapMap atoms; /* atom -> string index */
+} JSHeapSnapshotStrings;
+
+static uint32_t js_heap_add_cstring(JSHeapSnapshotStrings* ss, const char* str) {
+  if (ss->count != 0)
+    dbuf_putc(&ss->dbuf, ',');
+  js_profiler_put_json_str(&ss->dbuf, str);
+  return ss->count++;
+}
+
+static uint32_t
+js_heap_add_atom(JSRuntime* rt, JSHeapSnapshotStrings* ss, JSAtom atom) {
+  char buf[ATOM_GET_STR_BUF_SIZE];
+  uint32_t idx;
+
+  if (atom == JS_ATOM_NULL)
+    return JS_HEAP_STR_EMPTY;
+  if (js_heap_map_get(&ss->atoms, atom, &idx))
+    return idx;
+  idx = js_heap_add_cstring(ss, JS_AtomGetStrRT(rt, buf, sizeof(buf), atom));
+  js_heap_map_set(rt, &ss->atoms, atom, idx);
+  return idx;
+}
+
+/* append at most '*plen' characters of a string or rope as UTF-8 */
+static void js_heap_put_string_chars(DynBuf* dbuf, JSValueConst val, int* plen) {
+  uint8_t buf[UTF8_CHAR_LEN_MAX];
+  JSString* p;
+  uint32_t i, c;
+
+  if (JS_VALUE_GET_TAG(val) == JS_TAG_STRING_ROPE) {
+    JSStringRope* r = JS_VALUE_GET_STRING_ROPE(val);
+    js_heap_put_string_chars(dbuf, r->left, plen);
+    js_heap_put_string_chars(dbuf, r->right, plen);
+    return;
+  }
+  p = JS_VALUE_GET_STRING(val);
+  for (i = 0; i < p->len && *plen > 0; i++, (*plen)--) {
+    c = p->is_wide_char ? p->u.str16[i] : p->u.str8[i];
+    if (c == '\"' || c == '\\') {
+      dbuf_putc(dbuf, '\\');
+      dbuf_putc(dbuf, c);
+    } else if (c < 0x20 || (c >= 0xd800 && c < 0xe000)) {
+      /* the surrogates are not paired */
+      dbuf_printf(dbuf, "\\u%04x", c);
+    } else if (c < 0x80) {
+      dbuf_putc(dbuf, c);
+    } else {
+      dbuf_put(dbuf, buf, unicode_to_utf8(buf, c));
+    }
+  }
+}
+
+static uint32_t js_heap_add_node_name(
+    JSRuntime* rt,
+    JSHeapSnapshotStrings* ss,
+    JSHeapNode* n) {
+  JSGCObjectHeader* gp;
+  JSObject* p;
+  int len;
+
+  if (!n->ptr)
+    return JS_HEAP_STR_EMPTY;
+  if (!n->is_gc_object) {
+    len = JS_HEAP_STRING_NAME_MAX;
+    if (ss->count != 0)
+      dbuf_putc(&ss->dbuf, ',');
+    dbuf_putc(&ss->dbuf, '\"');
+    js_heap_put_string_chars(
+        &ss->dbuf,
+        JS_MKPTR(
+            n->type == JS_HEAP_NODE_STRING ? JS_TAG_STRING
+                                           : JS_TAG_STRING_ROPE,
+            n->ptr),
+        &len);
+    dbuf_putc(&ss->dbuf, '\"');
+    return ss->count++;
+  }
+  gp = n->ptr;
+  switch (gp->gc_obj_type) {
+    case JS_GC_OBJ_TYPE_JS_OBJECT:
+      p = (JSObject*)gp;
+      if (js_class_has_bytecode(p->class_id)) {
+        if (p->u.func.function_bytecode->func_name == JS_ATOM_NULL)
+          return JS_HEAP_STR_ANONYMOUS;
+        return js_heap_add_atom(
+            rt, ss, p->u.func.function_bytecode->func_name);
+      }
+      return js_heap_add_atom(rt, ss, rt->class_array[p->class_id].class_name);
+    case JS_GC_OBJ_TYPE_FUNCTION_BYTECODE:
+      return js_heap_add_atom(rt, ss, ((JSFunctionBytecode*)gp)->func_name);
+    case JS_GC_OBJ_TYPE_SHAPE:
+      return JS_HEAP_STR_SHAPE;
+    case JS_GC_OBJ_TYPE_VAR_REF:
+      return JS_HEAP_STR_VAR_REF;
+    case JS_GC_OBJ_TYPE_ASYNC_FUNCTION:
+      return JS_HEAP_STR_ASYNC_FUNCTION;
+    case JS_GC_OBJ_TYPE_JS_CONTEXT:
+      return JS_HEAP_STR_CONTEXT;
+    case JS_GC_OBJ_TYPE_MODULE:
+      return JS_HEAP_STR_MODULE;
+    default:
+      return JS_HEAP_STR_EMPTY;
+  }
+}
+
+static const char js_heap_snapshot_meta[] =
+    "{\"node_fields\":[\"type\",\"name\",\"id\",\"self_size\",\"edge_count\","
+    "\"trace_node_id\"],"
+    "\"node_types\":[[\"hidden\",\"array\",\"string\",\"object\",\"code\","
+    "\"closure\",\"regexp\",\"number\",\"native\",\"synthetic\","
+    "\"concatenated string\",\"sliced string\",\"symbol\",\"bigint\"],"
+    "\"string\",\"number\",\"number\",\"number\",\"number\"],"
+    "\"edge_fields\":[\"type\",\"name_or_index\",\"to_node\"],"
+    "\"edge_types\":[[\"context\",\"element\",\"property\",\"internal\","
+    "\"hidden\",\"shortcut\",\"weak\"],\"string_or_number\",\"node\"],"
+    "\"trace_function_info_fields\":[\"function_id\",\"name\","
+    "\"script_name\",\"script_id\",\"line\",\"column\"],"
+    "\"trace_node_fields\":[\"id\",\"function_info_index\",\"count\","
+    "\"size\",\"children\"],"
+    "\"sample_fields\":[\"timestamp_us\",\"last_assigned_id\"],"
+    "\"location_fields\":[\"object_index\",\"script_id\",\"line\","
+    "\"column\"]}";
+
+/* number of fields of a node in the snapshot */
+#define JS_HEAP_NODE_FIELD_COUNT 6
+
+static void js_heap_write_snapshot(
+    JSRuntime* rt,
+    JSHeapGraph* g,
+    DynBuf* dbuf,
+    JSHeapSnapshotStrings* ss) {
+  JSHeapProfiler* s = rt->heap_profiler;
+  char name_buf[JS_HEAP_NAME_BUF_SIZE], filename_buf[JS_HEAP_NAME_BUF_SIZE];
+  JSHeapSiteStats st;
+  JSHeapNode* n;
+  JSHeapEdge* e;
+  uint32_t i, j, name, trace_count;
+
+  for (i = 0; i < JS_HEAP_STR_COUNT; i++)
+    js_heap_add_cstring(ss, js_heap_fixed_strings[i]);
+
+  /* sites[0] is the root of the allocation trace tree */
+  trace_count = s->site_count > 1 ? s->site_count : 0;
+  dbuf_printf(
+      dbuf,
+      "{\"snapshot\":{\"meta\":%s,\"node_count\":%u,\"edge_count\":%u,"
+      "\"trace_function_count\":%u},\n\"nodes\":[",
+      js_heap_snapshot_meta,
+      g->node_count,
+      g->edge_count,
+      trace_count);
+  for (i = 0; i < g->node_count; i++) {
+    n = &g->nodes[i];
+    name = i == 0 ? JS_HEAP_STR_EMPTY : js_heap_add_node_name(rt, ss, n);
+    dbuf_printf(
+        dbuf,
+        "%s%u,%u,%u,%u,%u,%u",
+        i ? ",\n" : "",
+        n->type,
+        name,
+        2 * i + 1,
+        n->self_size,
+        n->edge_count,
+        n->site && trace_count ? n->site + 1 : 0);
+  }
+  dbuf_printf(dbuf, "],\n\"edges\":[");
+  for (i = 0; i < g->node_count; i++) {
+    n = &g->nodes[i];
+    for (j = 0; j < n->edge_count; j++) {
+      e = &g->edges[n->edge_start + j];
+      if (e->type == JS_HEAP_EDGE_PROPERTY) {
+        name = js_heap_add_atom(rt, ss, e->name);
+      } else if (e->type == JS_HEAP_EDGE_ELEMENT && i != 0) {
+        name = __JS_AtomToUInt32(e->name);
+      } else {
+        name = e->name;
+      }
+      dbuf_printf(
+          dbuf,
+          "%s%u,%u,%u",
+          i || j ? ",\n" : "",
+          e->type,
+          name,
+          e->to * JS_HEAP_NODE_FIELD_COUNT);
+    }
+  }
+
+  dbuf_printf(dbuf, "],\n\"trace_function_infos\":[");
+  for (i = 0; i < trace_count; i++) {
+    js_heap_site_get_location(
+        rt, &s->sites[i], &st, name_buf, filename_buf, sizeof(name_buf));
+    dbuf_printf(
+        dbuf,
+        "%s%u,%u,%u,0,%d,%d",
+        i ? ",\n" : "",
+        i,
+        i ? js_heap_add_cstring(ss, st.func_name) : JS_HEAP_STR_ROOT,
+        st.filename ? js_heap_add_cstring(ss, st.filename) : JS_HEAP_STR_EMPTY,
+        st.line_num,
+        st.col_num);
+  }
+  dbuf_printf(dbuf, "],\n\"trace_tree\":[");
+  if (trace_count) {
+    /* one child of the root per site */
+    dbuf_printf(
+        dbuf,
+        "1,0,%" PRIu64 ",%" PRIu64 ",[",
+        s->sites[0].alloc_count,
+        s->sites[0].alloc_size);
+    for (i = 1; i < trace_count; i++) {
+      dbuf_printf(
+          dbuf,
+          "%s%u,%u,%" PRIu64 ",%" PRIu64 ",[]",
+          i > 1 ? "," : "",
+          i + 1,
+          i,
+          s->sites[i].alloc_count,
+          s->sites[i].alloc_size);
+    }
+    dbuf_putc(dbuf, ']');
+  }
+  dbuf_printf(dbuf, "],\n\"samples\":[],\n\"locations\":[],\n\"strings\":[");
+  dbuf_put(dbuf, ss->dbuf.buf, ss->dbuf.size);
+  dbuf_printf(dbuf, "]}\n");
+}
+
+JSValue js_heap_profiler_take_snapshot(JSContext* ctx) {
+  JSRuntime* rt = ctx->rt;
+  JSHeapProfiler* s = rt->heap_profiler;
+  BOOL is_temporary = FALSE;
+  JSHeapSnapshotStrings ss;
+  JSHeapGraph graph;
+  DynBuf dbuf;
+  JSValue ret;
+
+  /* only the reachable objects are in the snapshot */
+  JS_RunGC(rt);
+  if (!s) {
+    s = js_heap_profiler_new(rt);
+    if (!s)
+      return JS_ThrowOutOfMemory(ctx);
+    rt->heap_profiler = s;
+    is_temporary = TRUE;
+  }
+  if (js_heap_graph_build(rt, &graph)) {
+    ret = JS_ThrowOutOfMemory(ctx);
+    goto done;
+  }
+  if (js_heap_graph_compute_retained(rt, &graph)) {
+    js_heap_graph_free(rt, &graph);
+    ret = JS_ThrowOutOfMemory(ctx);
+    goto done;
+  }
+  js_dbuf_init(ctx, &dbuf);
+  js_dbuf_init(ctx, &ss.dbuf);
+  ss.count = 0;
+  memset(&ss.atoms, 0, sizeof(ss.atoms));
+  js_heap_write_snapshot(rt, &graph, &dbuf, &ss);
+  js_heap_graph_free(rt, &graph);
+  if (dbuf_error(&dbuf) || dbuf_error(&ss.dbuf)) {
+    ret = JS_ThrowOutOfMemory(ctx);
+  } else {
+    ret = JS_NewStringLen(ctx, (const char*)dbuf.buf, dbuf.size);
+  }
+  js_heap_map_free(rt, &ss.atoms);
+  dbuf_free(&ss.dbuf);
+  dbuf_free(&dbuf);
+done:
+  if (is_temporary)
+    js_heap_profiler_free(rt);
+  return ret;
+}
@@ -0,0 +1,117 @@
+/*
+ * QuickJS Javascript Engine
+ *
+ * Copyright (c) 2017-2025 Fabrice Bellard
+ * Copyright (c) 2017-2025 Charlie Gordon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+#include "QuickJS/quickjs.h"
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct JSHeapProfiler JSHeapProfiler;
+
+/* per allocation site statistics. The live and retained sizes are
+   updated by js_heap_profiler_compute(). */
+typedef struct JSHeapSiteStats {
+  const char* func_name; /* only valid during the callback */
+  const char* filename; /* only valid during the callback, may be NULL */
+  int line_num; /* 0 if unknown */
+  int col_num;
+  uint64_t alloc_count; /* allocations since the profiler was started */
+  uint64_t alloc_size;
+  uint32_t live_count; /* reachable objects and strings */
+  uint64_t self_size;
+  uint64_t retained_size; /* memory freed if the site objects were freed */
+} JSHeapSiteStats;
+
+typedef void JSHeapSiteFunc(
+    JSRuntime* rt,
+    const JSHeapSiteStats* site,
+    void* opaque);
+
+int js_heap_profiler_start(JSRuntime* rt);
+void js_heap_profiler_stop(JSRuntime* rt);
+void js_heap_profiler_free(JSRuntime* rt);
+/* walk the heap and update the live and retained sizes of the sites */
+int js_heap_profiler_compute(JSRuntime* rt);
+void js_heap_profiler_for_each_site(
+    JSRuntime* rt,
+    JSHeapSiteFunc* func,
+    void* opaque);
+/* print the sites with the largest retained size */
+void js_heap_profiler_dump(FILE* fp, JSRuntime* rt);
+/* V8 .heapsnapshot JSON string. The heap profiler does not need to be
+   started, but the nodes are only tagged with their allocation site
+   if it was. */
+JSValue js_heap_profiler_take_snapshot(JSContext* ctx);
+
+uint32_t __js_heap_profiler_alloc_site(JSRuntime* rt, size_t size);
+void __js_heap_profiler_tag_string(JSRuntime* rt, JSString* str);
+void __js_heap_profiler_untag_string(
+    JSRuntime* rt,
+    JSString* str,
+    BOOL cancel_alloc);
+
+/* allocation site of a new object of 'size' bytes, 0 if the heap
+   profiler is not tracking the allocations */
+static inline uint32_t js_heap_profiler_alloc_site(
+    JSRuntime* rt,
+    size_t size) {
+  if (likely(!rt->heap_profiler))
+    return 0;
+  return __js_heap_profiler_alloc_site(rt, size);
+}
+
+/* the strings have no room for the site, it is kept in a side table
+   which must be updated at the same places as the DUMP_LEAKS string
+   list */
+static inline void js_heap_profiler_tag_string(JSRuntime* rt, JSString* str) {
+  if (unlikely(rt->heap_profiler))
+    __js_heap_profiler_tag_string(rt, str);
+}
+
+static inline void js_heap_profiler_free_string(
+    JSRuntime* rt,
+    JSString* str) {
+  if (unlikely(rt->heap_profiler))
+    __js_heap_profiler_untag_string(rt, str, FALSE);
+}
+
+/* the string was allocated by a StringBuffer which may reallocate it,
+   js_heap_profiler_tag_string() is called again by string_buffer_end() */
+static inline void js_heap_profiler_cancel_string(
+    JSRuntime* rt,
+    JSString* str) {
+  if (unlikely(rt->heap_profiler))
+    __js_heap_profiler_untag_string(rt, str, TRUE);
+}
+
+#ifdef __cplusplus
+}
+#endif
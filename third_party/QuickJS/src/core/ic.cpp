@@ -109,7 +109,7 @@ int free_ic(InlineCache* ic) {
     for (ch = ic->hash[i]; ch != NULL; ch = ch_next) {
       ch_next = ch->next;
       JS_FreeAtom(ic->ctx, ch->atom);
-      js_free(ic->ctx, ch);
+      js_slab_free_rt(rt, ch, sizeof(InlineCacheHashSlot));
     }
   }
   if (ic->count > 0)
@@ -200,3 +200,51 @@ int ic_free_shape_proto_watchpoints(JSRuntime* rt, JSShape* shape) {
   }
   return 0;
 }
+
+int ic_stub_cache_add(
+    JSRuntime* rt,
+    JSShape* shape,
+    JSAtom atom,
+    uint32_t prop_offset) {
+  InlineCacheStubEntry* e;
+  JSShapeProperty* prs;
+  JSShape* sh;
+  // only plain writable data properties, the entry is shared by the get
+  // and put sites of every function
+  prs = get_shape_prop(shape) + prop_offset;
+  JS_ASSERT(prs->atom == atom);
+  if ((prs->flags & (JS_PROP_TMASK | JS_PROP_WRITABLE | JS_PROP_LENGTH)) !=
+      JS_PROP_WRITABLE)
+    return -1;
+  if (!rt->ic_stub_cache) [[unlikely]] {
+    rt->ic_stub_cache = (InlineCacheStubEntry*)js_mallocz_rt(
+        rt, sizeof(InlineCacheStubEntry) * IC_STUB_CACHE_SIZE);
+    if (!rt->ic_stub_cache)
+      return -1;
+  }
+  e = rt->ic_stub_cache + get_ic_stub_hash(shape, atom);
+  sh = e->shape;
+  e->shape = js_dup_shape(shape);
+  e->atom = atom;
+  e->prop_offset = prop_offset;
+  js_free_shape_null(rt, sh);
+  return 0;
+}
+
+void ic_stub_cache_flush(JSRuntime* rt) {
+  uint32_t i;
+  JSShape* sh;
+  if (!rt->ic_stub_cache)
+    return;
+  for (i = 0; i < IC_STUB_CACHE_SIZE; i++) {
+    sh = rt->ic_stub_cache[i].shape;
+    rt->ic_stub_cache[i].shape = NULL;
+    js_free_shape_null(rt, sh);
+  }
+}
+
+void ic_stub_cache_free(JSRuntime* rt) {
+  ic_stub_cache_flush(rt);
+  js_free_rt(rt, rt->ic_stub_cache);
+  rt->ic_stub_cache = NULL;
+}
@@ -2,6 +2,7 @@
 
 #include "QuickJS/quickjs.h"
 #include "exception.h"
+#include "malloc.h"
 #include "shape.h"
 #include "types.h"
 
@@ -26,6 +27,14 @@ int ic_delete_shape_proto_watchpoints(
     JSAtom atom);
 int ic_free_shape_proto_watchpoints(JSRuntime* rt, JSShape* shape);
 
+int ic_stub_cache_add(
+    JSRuntime* rt,
+    JSShape* shape,
+    JSAtom atom,
+    uint32_t prop_offset);
+void ic_stub_cache_flush(JSRuntime* rt);
+void ic_stub_cache_free(JSRuntime* rt);
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,6 +43,29 @@ static force_inline uint32_t get_index_hash(JSAtom atom, int hash_bits) {
   return (atom * 0x9e370001) >> (32 - hash_bits);
 }
 
+static force_inline uint32_t get_ic_stub_hash(JSShape* shape, JSAtom atom) {
+  uint32_t h = (uint32_t)((uintptr_t)shape >> 3) ^ (atom * 0x9e370001);
+  return (h * 0x9e370001) >> (32 - IC_STUB_CACHE_BITS);
+}
+
+static force_inline int32_t
+get_ic_stub_prop_offset(JSRuntime* rt, JSShape* shape, JSAtom atom) {
+  InlineCacheStubEntry* e;
+  if (unlikely(!rt->ic_stub_cache))
+    return -1;
+  e = rt->ic_stub_cache + get_ic_stub_hash(shape, atom);
+  if (likely(e->shape == shape && e->atom == atom))
+    return e->prop_offset;
+  return -1;
+}
+
+static force_inline void set_ic_state(InlineCacheRingSlot* cr, int state) {
+  if (cr->state != state) {
+    cr->state = state;
+    cr->transitions++;
+  }
+}
+
 static force_inline JSAtom get_ic_atom(InlineCache* ic, uint32_t cache_offset) {
   JS_ASSERT(cache_offset < ic->capacity);
   return ic->cache[cache_offset].atom;
@@ -75,11 +107,31 @@ static force_inline uint32_t add_ic_slot(
 
     i = (i + 1) % IC_CACHE_ITEM_CAPACITY;
     if (unlikely(i == cr->index)) {
-      cr->index = (cr->index + 1) % IC_CACHE_ITEM_CAPACITY;
       break;
     }
   }
 
+  // prefer a free item, the hit path moves cr->index around
+  for (i = 0; i < IC_CACHE_ITEM_CAPACITY; i++) {
+    if (cr->buffer[i].shape == NULL)
+      break;
+  }
+  if (i < IC_CACHE_ITEM_CAPACITY) {
+    cr->index = i;
+    set_ic_state(
+        cr,
+        cr->state == IC_STATE_UNINITIALIZED ? IC_STATE_MONOMORPHIC
+                                            : IC_STATE_POLYMORPHIC);
+  } else {
+    // the ring is full: own properties go to the stub cache instead of
+    // evicting items that are still hot
+    set_ic_state(cr, IC_STATE_MEGAMORPHIC);
+    if (!prototype &&
+        ic_stub_cache_add(rt, object->shape, atom, prop_offset) == 0)
+      goto end;
+    cr->index = (cr->index + 1) % IC_CACHE_ITEM_CAPACITY;
+  }
+
   ci = cr->buffer + cr->index;
   sh = ci->shape;
   if (ci->watchpoint_ref)
@@ -115,7 +167,8 @@ static force_inline uint32_t add_ic_slot1(InlineCache* ic, JSAtom atom) {
     if (likely(ch->atom == atom))
       goto fail;
   }
-  ch = (InlineCacheHashSlot*)js_malloc(ic->ctx, sizeof(InlineCacheHashSlot));
+  ch = (InlineCacheHashSlot*)js_slab_alloc(
+      ic->ctx, sizeof(InlineCacheHashSlot));
   if (unlikely(!ch))
     goto fail;
   ch->atom = JS_DupAtom(ic->ctx, atom);
@@ -141,11 +194,20 @@ static force_inline int32_t get_ic_prop_offset(
   InlineCacheRingItem* buffer;
   JS_ASSERT(cache_offset < ic->capacity);
   cr = ic->cache + cache_offset;
+  if (unlikely(cr->state == IC_STATE_MEGAMORPHIC)) {
+    int32_t offset = get_ic_stub_prop_offset(ic->ctx->rt, shape, cr->atom);
+    if (offset >= 0) {
+      cr->hits++;
+      *prototype = NULL;
+      return offset;
+    }
+  }
   i = cr->index;
   for (;;) {
     buffer = cr->buffer + i;
     if (likely(buffer->shape == shape)) {
       cr->index = i;
+      cr->hits++;
       *prototype = buffer->proto;
       return buffer->prop_offset;
     }
@@ -156,6 +218,7 @@ static force_inline int32_t get_ic_prop_offset(
     }
   }
 
+  cr->misses++;
   *prototype = NULL;
   return -1;
 }
@@ -25,6 +25,8 @@
 
 #include "malloc.h"
 #include "exception.h"
+#include "gc.h"
+#include "ic.h"
 #include "QuickJS/cutils.h"
 
 void js_trigger_gc(JSRuntime* rt, size_t size) {
@@ -38,6 +40,16 @@ void js_trigger_gc(JSRuntime* rt, size_t size) {
 #ifdef DUMP_GC
     printf("GC: size=%" PRIu64 "\n", (uint64_t)rt->malloc_state.malloc_size);
 #endif
+    if (rt->gc_generational &&
+        rt->malloc_state.malloc_size + size < rt->malloc_gc_full_threshold) {
+      /* only scan the objects allocated since the last collection,
+         the cached shapes are dropped as in JS_RunGC() */
+      ic_stub_cache_flush(rt);
+      gc_collect_young(rt);
+      rt->malloc_gc_threshold =
+          rt->malloc_state.malloc_size + MALLOC_GC_THRESHOLD;
+      return;
+    }
     JS_RunGC(rt);
     rt->malloc_gc_threshold =
         rt->malloc_state.malloc_size + (rt->malloc_state.malloc_size >> 1);
@@ -179,6 +191,110 @@ no_inline int js_realloc_array(
   return 0;
 }
 
+/* slab pages start small so that idle size classes cost little and
+   double up to JS_SLAB_PAGE_MAX_SIZE */
+#define JS_SLAB_PAGE_MIN_SIZE 4096
+#define JS_SLAB_PAGE_MAX_SIZE 65536
+
+typedef struct JSSlabPage {
+  struct JSSlabPage* next;
+  size_t size;
+} JSSlabPage;
+
+/* keep the slots aligned on JS_SLAB_GRANULE */
+#define JS_SLAB_PAGE_HEADER_SIZE \
+  ((sizeof(JSSlabPage) + JS_SLAB_GRANULE - 1) & ~(size_t)(JS_SLAB_GRANULE - 1))
+
+void* js_slab_alloc_slow(JSRuntime* rt, JSSlabClass* sc, size_t slot_size) {
+  JSSlabPage* page;
+  size_t size;
+  uint8_t* ptr;
+
+  if ((size_t)(sc->bump_end - sc->bump_ptr) < slot_size) {
+    size = JS_SLAB_PAGE_MAX_SIZE;
+    if (sc->page_count < 4)
+      size = JS_SLAB_PAGE_MIN_SIZE << sc->page_count;
+    page = js_malloc_rt(rt, size);
+    if (unlikely(!page))
+      return NULL;
+    page->next = sc->pages;
+    page->size = size;
+    sc->pages = page;
+    sc->page_count++;
+    sc->page_size += size;
+    sc->bump_ptr = (uint8_t*)page + JS_SLAB_PAGE_HEADER_SIZE;
+    sc->bump_end = sc->bump_ptr +
+        (size - JS_SLAB_PAGE_HEADER_SIZE) / slot_size * slot_size;
+    js_slab_poison(sc->bump_ptr, sc->bump_end - sc->bump_ptr);
+  }
+  ptr = sc->bump_ptr;
+  sc->bump_ptr += slot_size;
+  sc->used_count++;
+  js_slab_unpoison(ptr, slot_size);
+  return ptr;
+}
+
+/* Throw out of memory in case of error */
+void* js_slab_alloc(JSContext* ctx, size_t size) {
+  void* ptr;
+  ptr = js_slab_alloc_rt(ctx->rt, size);
+  if (unlikely(!ptr)) {
+    JS_ThrowOutOfMemory(ctx);
+    return NULL;
+  }
+  return ptr;
+}
+
+static void js_slab_free_pages(JSRuntime* rt, JSSlabClass* sc) {
+  JSSlabPage *page, *page_next;
+
+  for (page = sc->pages; page != NULL; page = page_next) {
+    page_next = page->next;
+    js_slab_unpoison(page, page->size);
+    js_free_rt(rt, page);
+  }
+  memset(sc, 0, sizeof(*sc));
+}
+
+/* give back the pages of the size classes which have no live slot */
+void js_slab_trim(JSRuntime* rt) {
+  int i;
+
+  for (i = 0; i < JS_SLAB_CLASS_COUNT; i++) {
+    JSSlabClass* sc = &rt->slab_classes[i];
+    if (sc->pages && sc->used_count == 0)
+      js_slab_free_pages(rt, sc);
+  }
+}
+
+/* release all the pages at once. The live slots are leaked objects:
+   they are reported with DUMP_LEAKS and, with AddressSanitizer, their
+   pages are kept so that the leak checker reports them and what they
+   reference. */
+void js_slab_free_all(JSRuntime* rt) {
+  int i;
+#ifdef DUMP_LEAKS
+  BOOL header_done = FALSE;
+#endif
+
+  for (i = 0; i < JS_SLAB_CLASS_COUNT; i++) {
+    JSSlabClass* sc = &rt->slab_classes[i];
+    if (sc->used_count != 0) {
+#ifdef DUMP_LEAKS
+      if (!header_done) {
+        printf("Slab leaks:\n    %6s %6s\n", "SIZE", "COUNT");
+        header_done = TRUE;
+      }
+      printf("    %6d %6" PRId64 "\n", (i + 1) * JS_SLAB_GRANULE, sc->used_count);
+#endif
+#ifdef JS_SLAB_ASAN
+      continue;
+#endif
+    }
+    js_slab_free_pages(rt, sc);
+  }
+}
+
 void* js_def_malloc(JSMallocState* s, size_t size) {
   void* ptr;
 
@@ -207,6 +323,35 @@ void js_def_free(JSMallocState* s, void* ptr) {
   free(ptr);
 }
 
+/* Remove 'ptr', allocated with js_malloc_rt(), from the memory
+   accounting of 'rt': it becomes a plain malloc() block owned by the
+   caller. Return FALSE if the runtime does not use the default
+   allocator, in which case nothing is changed. */
+BOOL js_malloc_rt_release(JSRuntime* rt, void* ptr) {
+  if (rt->mf.js_free != js_def_free)
+    return FALSE;
+  rt->malloc_state.malloc_count--;
+  rt->malloc_state.malloc_size -=
+      js_def_malloc_usable_size(ptr) + MALLOC_OVERHEAD;
+  return TRUE;
+}
+
+/* Inverse of js_malloc_rt_release(): on success the malloc() block
+   'ptr' must be freed with js_free_rt(). */
+BOOL js_malloc_rt_adopt(JSRuntime* rt, void* ptr) {
+  JSMallocState* s = &rt->malloc_state;
+  size_t size;
+
+  if (rt->mf.js_free != js_def_free)
+    return FALSE;
+  size = js_def_malloc_usable_size(ptr) + MALLOC_OVERHEAD;
+  if (s->malloc_size + size > s->malloc_limit)
+    return FALSE;
+  s->malloc_count++;
+  s->malloc_size += size;
+  return TRUE;
+}
+
 void* js_def_realloc(JSMallocState* s, void* ptr, size_t size) {
   size_t old_size;
 
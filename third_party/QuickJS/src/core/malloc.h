@@ -90,6 +90,23 @@
 #endif
 #endif
 
+#if defined(__SANITIZE_ADDRESS__)
+#define JS_SLAB_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define JS_SLAB_ASAN 1
+#endif
+#endif
+
+#ifdef JS_SLAB_ASAN
+#include <sanitizer/asan_interface.h>
+#define js_slab_poison(p, n) ASAN_POISON_MEMORY_REGION(p, n)
+#define js_slab_unpoison(p, n) ASAN_UNPOISON_MEMORY_REGION(p, n)
+#else
+#define js_slab_poison(p, n) ((void)(p), (void)(n))
+#define js_slab_unpoison(p, n) ((void)(p), (void)(n))
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -124,9 +141,54 @@ void js_def_free(JSMallocState* s, void* ptr);
 void* js_def_realloc(JSMallocState* s, void* ptr, size_t size);
 size_t js_def_malloc_usable_size(const void* ptr);
 size_t js_malloc_usable_size_unknown(const void* ptr);
+BOOL js_malloc_rt_release(JSRuntime* rt, void* ptr);
+BOOL js_malloc_rt_adopt(JSRuntime* rt, void* ptr);
 
 void* js_bf_realloc(void* opaque, void* ptr, size_t size);
 
+void* js_slab_alloc_slow(JSRuntime* rt, JSSlabClass* sc, size_t slot_size);
+void* js_slab_alloc(JSContext* ctx, size_t size);
+void js_slab_trim(JSRuntime* rt);
+void js_slab_free_all(JSRuntime* rt);
+
+/* Small fixed size structures (objects, shapes, closure variables...)
+   are carved from per-runtime pages and recycled through per size
+   class free lists. The same 'size' must be given to js_slab_free_rt().
+   Larger sizes fall back to js_malloc_rt(). */
+static inline void* js_slab_alloc_rt(JSRuntime* rt, size_t size) {
+  JSSlabClass* sc;
+  size_t slot_size;
+  void* ptr;
+
+  if (unlikely(size > JS_SLAB_MAX_SIZE))
+    return js_malloc_rt(rt, size);
+  sc = &rt->slab_classes[(size - 1) / JS_SLAB_GRANULE];
+  slot_size = (size + JS_SLAB_GRANULE - 1) & ~(size_t)(JS_SLAB_GRANULE - 1);
+  ptr = sc->free_list;
+  if (unlikely(!ptr))
+    return js_slab_alloc_slow(rt, sc, slot_size);
+  sc->free_list = *(void**)ptr;
+  sc->used_count++;
+  js_slab_unpoison(ptr, slot_size);
+  return ptr;
+}
+
+static inline void js_slab_free_rt(JSRuntime* rt, void* ptr, size_t size) {
+  JSSlabClass* sc;
+  size_t slot_size;
+
+  if (unlikely(size > JS_SLAB_MAX_SIZE)) {
+    js_free_rt(rt, ptr);
+    return;
+  }
+  sc = &rt->slab_classes[(size - 1) / JS_SLAB_GRANULE];
+  slot_size = (size + JS_SLAB_GRANULE - 1) & ~(size_t)(JS_SLAB_GRANULE - 1);
+  *(void**)ptr = sc->free_list;
+  sc->free_list = ptr;
+  sc->used_count--;
+  js_slab_poison((uint8_t*)ptr + sizeof(void*), slot_size - sizeof(void*));
+}
+
 #ifdef __cplusplus
 } /* extern "C" { */
 #endif
@@ -25,6 +25,8 @@
 
 #include "memory.h"
 #include "function.h"
+#include "gc.h"
+#include "heap_profiler.h"
 #include "runtime.h"
 #include "shape.h"
 #include "string-utils.h"
@@ -114,6 +116,78 @@ static void compute_value_size(JSValueConst val, JSMemoryUsage_helper* hp) {
   }
 }
 
+/* approximate size of the memory owned by a GC object, with the same
+   accounting as JS_ComputeMemoryUsage(). The strings referenced by the
+   object are not included. */
+size_t js_gc_object_self_size(JSRuntime* rt, JSGCObjectHeader* gp) {
+  switch (gp->gc_obj_type) {
+    case JS_GC_OBJ_TYPE_JS_OBJECT: {
+      JSObject* p = (JSObject*)gp;
+      size_t size = sizeof(JSObject);
+      if (p->prop)
+        size += p->shape->prop_size * sizeof(*p->prop);
+      switch (p->class_id) {
+        case JS_CLASS_ARRAY:
+        case JS_CLASS_ARGUMENTS:
+          if (p->fast_array && p->u.array.u.values)
+            size += p->u.array.count * sizeof(*p->u.array.u.values);
+          break;
+        case JS_CLASS_BYTECODE_FUNCTION:
+          if (p->u.func.var_refs) {
+            size += p->u.func.function_bytecode->closure_var_count *
+                sizeof(*p->u.func.var_refs);
+          }
+          break;
+        case JS_CLASS_BOUND_FUNCTION: {
+          JSBoundFunction* bf = p->u.bound_function;
+          size += sizeof(*bf) + bf->argc * sizeof(*bf->argv);
+        } break;
+        case JS_CLASS_C_FUNCTION_DATA: {
+          JSCFunctionDataRecord* fd = p->u.c_function_data_record;
+          if (fd)
+            size += sizeof(*fd) + fd->data_len * sizeof(*fd->data);
+        } break;
+        case JS_CLASS_FOR_IN_ITERATOR:
+          if (p->u.for_in_iterator)
+            size += sizeof(*p->u.for_in_iterator);
+          break;
+        case JS_CLASS_ARRAY_BUFFER:
+        case JS_CLASS_SHARED_ARRAY_BUFFER: {
+          JSArrayBuffer* abuf = p->u.array_buffer;
+          if (abuf) {
+            size += sizeof(*abuf);
+            if (abuf->data)
+              size += abuf->byte_length;
+          }
+        } break;
+        default:
+          break;
+      }
+      return size;
+    }
+    case JS_GC_OBJ_TYPE_FUNCTION_BYTECODE: {
+      JSMemoryUsage_helper mem = {0};
+      compute_bytecode_size((JSFunctionBytecode*)gp, &mem);
+      return (size_t)mem.js_func_size + mem.js_func_code_size +
+          mem.js_func_pc2line_size + mem.js_func_pc2column_size;
+    }
+    case JS_GC_OBJ_TYPE_SHAPE: {
+      JSShape* sh = (JSShape*)gp;
+      return get_shape_size(sh->prop_hash_mask + 1, sh->prop_size);
+    }
+    case JS_GC_OBJ_TYPE_VAR_REF:
+      return sizeof(JSVarRef);
+    case JS_GC_OBJ_TYPE_ASYNC_FUNCTION:
+      return sizeof(JSAsyncFunctionState);
+    case JS_GC_OBJ_TYPE_JS_CONTEXT:
+      return sizeof(JSContext) + sizeof(JSValue) * rt->class_count;
+    case JS_GC_OBJ_TYPE_MODULE:
+      return sizeof(JSModuleDef);
+    default:
+      return 0;
+  }
+}
+
 void JS_ComputeMemoryUsage(JSRuntime* rt, JSMemoryUsage* s) {
   struct list_head *el, *el1;
   int i;
@@ -179,7 +253,7 @@ void JS_ComputeMemoryUsage(JSRuntime* rt, JSMemoryUsage* s) {
     }
   }
 
-  list_for_each(el, &rt->gc_obj_list) {
+  gc_for_each_obj(el, rt) {
     JSGCObjectHeader* gp = list_entry(el, JSGCObjectHeader, link);
     JSObject* p;
     JSShape* sh;
@@ -369,6 +443,15 @@ void JS_ComputeMemoryUsage(JSRuntime* rt, JSMemoryUsage* s) {
     }
   }
 
+  /* slab pages, their slots are already counted above */
+  for (i = 0; i < JS_SLAB_CLASS_COUNT; i++) {
+    JSSlabClass* sc = &rt->slab_classes[i];
+    s->slab_count += sc->page_count;
+    s->slab_size += sc->page_size;
+    s->slab_used_count += sc->used_count;
+    s->slab_used_size += sc->used_count * JS_SLAB_GRANULE * (i + 1);
+  }
+
   /* atoms */
   s->memory_used_count += 2; /* rt->atom_array, rt->atom_hash */
   s->atom_count = rt->atom_count;
@@ -442,7 +525,7 @@ void JS_DumpMemoryUsage(FILE* fp, const JSMemoryUsage* s, JSRuntime* rt) {
       int obj_classes[JS_CLASS_INIT_COUNT + 1] = {0};
       int class_id;
       struct list_head* el;
-      list_for_each(el, &rt->gc_obj_list) {
+      gc_for_each_obj(el, rt) {
         JSGCObjectHeader* gp = list_entry(el, JSGCObjectHeader, link);
         JSObject* p;
         if (gp->gc_obj_type == JS_GC_OBJ_TYPE_JS_OBJECT) {
@@ -479,6 +562,8 @@ void JS_DumpMemoryUsage(FILE* fp, const JSMemoryUsage* s, JSRuntime* rt) {
             0,
             "other");
     }
+    if (rt->heap_profiler)
+      js_heap_profiler_dump(fp, rt);
     fprintf(fp, "\n");
   }
 #endif
@@ -600,4 +685,19 @@ void JS_DumpMemoryUsage(FILE* fp, const JSMemoryUsage* s, JSRuntime* rt) {
         s->binary_object_count,
         s->binary_object_size);
   }
+  if (s->slab_count) {
+    fprintf(
+        fp,
+        "%-20s %8" PRId64 " %8" PRId64 "\n",
+        "slab pages",
+        s->slab_count,
+        s->slab_size);
+    fprintf(
+        fp,
+        "%-20s %8" PRId64 " %8" PRId64 "  (%0.1f%% used)\n",
+        "  slots",
+        s->slab_used_count,
+        s->slab_used_size,
+        100.0 * s->slab_used_size / s->slab_size);
+  }
 }
@@ -29,4 +29,6 @@
 #include "QuickJS/cutils.h"
 #include "QuickJS/quickjs.h"
 
+size_t js_gc_object_self_size(JSRuntime* rt, JSGCObjectHeader* gp);
+
 #endif
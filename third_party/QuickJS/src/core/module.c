@@ -915,7 +915,7 @@ int js_resolve_module(JSContext* ctx, JSModuleDef* m) {
 
 static JSVarRef* js_create_module_var(JSContext* ctx, BOOL is_lexical) {
   JSVarRef* var_ref;
-  var_ref = js_malloc(ctx, sizeof(JSVarRef));
+  var_ref = js_slab_alloc(ctx, sizeof(JSVarRef));
   if (!var_ref)
     return NULL;
   var_ref->header.ref_count = 1;
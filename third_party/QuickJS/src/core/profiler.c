@@ -0,0 +1,697 @@
+/*
+ * QuickJS Javascript Engine
+ *
+ * Copyright (c) 2017-2025 Fabrice Bellard
+ * Copyright (c) 2017-2025 Charlie Gordon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "profiler.h"
+#include "malloc.h"
+#include "runtime.h"
+
+/* Sampling CPU profiler. The clock is checked from the interrupt
+   polling path, so only the time spent running JS code (including the
+   C functions it calls) is sampled. Each sample walks the stack frames
+   and is added to a call tree whose nodes are (function, line)
+   locations. The sample sequence is kept for the trace-event export. */
+
+#define JS_PROFILER_MAX_DEPTH 128
+#define JS_PROFILER_PC_CACHE_BITS 10
+#define JS_PROFILER_PC_CACHE_SIZE (1 << JS_PROFILER_PC_CACHE_BITS)
+
+typedef struct JSProfilerFunc {
+  /* JSFunctionBytecode or C function object, a reference is held */
+  JSGCObjectHeader* obj;
+  BOOL is_bytecode;
+  uint32_t hash_next; /* -1 if no next entry */
+} JSProfilerFunc;
+
+typedef struct JSProfilerLoc {
+  uint32_t func;
+  int line_num; /* 0 if unknown */
+  int col_num;
+  uint32_t hash_next;
+} JSProfilerLoc;
+
+typedef struct JSProfilerNode {
+  uint32_t parent; /* -1 for the root */
+  uint32_t loc; /* -1 for the root */
+  uint32_t first_child;
+  uint32_t next_sibling;
+  uint32_t hit_count;
+} JSProfilerNode;
+
+typedef struct JSProfilerSample {
+  uint32_t node;
+  uint32_t delta_us; /* time since the previous sample */
+} JSProfilerSample;
+
+typedef struct JSProfilerPCCacheEntry {
+  JSGCObjectHeader* obj;
+  uint32_t pc;
+  uint32_t loc;
+} JSProfilerPCCacheEntry;
+
+struct JSProfiler {
+  BOOL running;
+  uint32_t interval_us;
+  int64_t start_time;
+  int64_t last_time;
+  int64_t next_time;
+  int64_t end_time;
+
+  JSProfilerFunc* funcs;
+  uint32_t func_count;
+  uint32_t func_size;
+  uint32_t* func_hash;
+  uint32_t func_hash_size; /* power of two */
+
+  JSProfilerLoc* locs;
+  uint32_t loc_count;
+  uint32_t loc_size;
+  uint32_t* loc_hash;
+  uint32_t loc_hash_size; /* power of two */
+
+  JSProfilerNode* nodes; /* nodes[0] is the root */
+  uint32_t node_count;
+  uint32_t node_size;
+
+  JSProfilerSample* samples;
+  uint32_t sample_count;
+  uint32_t sample_size;
+
+  JSProfilerPCCacheEntry pc_cache[JS_PROFILER_PC_CACHE_SIZE];
+};
+
+static int64_t js_profiler_now_us(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+int js_profiler_grow(
+    JSRuntime* rt,
+    void** parray,
+    uint32_t* psize,
+    uint32_t count,
+    size_t elem_size) {
+  uint32_t new_size;
+  void* new_array;
+  if (count < *psize)
+    return 0;
+  new_size = max_int(*psize * 3 / 2, 16);
+  new_array = js_realloc_rt(rt, *parray, new_size * elem_size);
+  if (!new_array)
+    return -1;
+  *parray = new_array;
+  *psize = new_size;
+  return 0;
+}
+
+int js_profiler_resize_hash(
+    JSRuntime* rt,
+    uint32_t** phash,
+    uint32_t* phash_size,
+    uint32_t count) {
+  uint32_t new_size;
+  uint32_t* new_hash;
+  if (count < *phash_size)
+    return 0;
+  new_size = max_int(*phash_size * 2, 64);
+  new_hash = js_malloc_rt(rt, sizeof(new_hash[0]) * new_size);
+  if (!new_hash)
+    return -1;
+  memset(new_hash, 0xff, sizeof(new_hash[0]) * new_size);
+  js_free_rt(rt, *phash);
+  *phash = new_hash;
+  *phash_size = new_size;
+  return 1; /* the entries must be rehashed */
+}
+
+uint32_t js_profiler_hash_ptr(const void* ptr, uint32_t hash_size) {
+  uintptr_t h = (uintptr_t)ptr >> 3;
+  return ((uint32_t)h * 0x9e370001) & (hash_size - 1);
+}
+
+static uint32_t js_profiler_hash_loc(
+    uint32_t func,
+    int line_num,
+    uint32_t hash_size) {
+  return ((func * 0x9e370001) ^ (uint32_t)line_num) & (hash_size - 1);
+}
+
+static int js_profiler_find_func(
+    JSRuntime* rt,
+    JSProfiler* s,
+    JSGCObjectHeader* obj,
+    BOOL is_bytecode) {
+  JSProfilerFunc* f;
+  uint32_t h, i;
+  int ret;
+
+  if (s->func_hash) {
+    h = js_profiler_hash_ptr(obj, s->func_hash_size);
+    for (i = s->func_hash[h]; i != -1; i = s->funcs[i].hash_next) {
+      if (s->funcs[i].obj == obj)
+        return i;
+    }
+  }
+  if (js_profiler_grow(
+          rt, (void**)&s->funcs, &s->func_size, s->func_count, sizeof(*f)))
+    return -1;
+  ret = js_profiler_resize_hash(
+      rt, &s->func_hash, &s->func_hash_size, s->func_count);
+  if (ret < 0)
+    return -1;
+  if (ret > 0) {
+    for (i = 0; i < s->func_count; i++) {
+      h = js_profiler_hash_ptr(s->funcs[i].obj, s->func_hash_size);
+      s->funcs[i].hash_next = s->func_hash[h];
+      s->func_hash[h] = i;
+    }
+  }
+  i = s->func_count++;
+  f = &s->funcs[i];
+  f->obj = obj;
+  f->is_bytecode = is_bytecode;
+  obj->ref_count++;
+  h = js_profiler_hash_ptr(obj, s->func_hash_size);
+  f->hash_next = s->func_hash[h];
+  s->func_hash[h] = i;
+  return i;
+}
+
+static int js_profiler_find_loc(
+    JSRuntime* rt,
+    JSProfiler* s,
+    uint32_t func,
+    int line_num,
+    int col_num) {
+  JSProfilerLoc* l;
+  uint32_t h, i;
+  int ret;
+
+  if (s->loc_hash) {
+    h = js_profiler_hash_loc(func, line_num, s->loc_hash_size);
+    for (i = s->loc_hash[h]; i != -1; i = s->locs[i].hash_next) {
+      if (s->locs[i].func == func && s->locs[i].line_num == line_num)
+        return i;
+    }
+  }
+  if (js_profiler_grow(
+          rt, (void**)&s->locs, &s->loc_size, s->loc_count, sizeof(*l)))
+    return -1;
+  ret = js_profiler_resize_hash(
+      rt, &s->loc_hash, &s->loc_hash_size, s->loc_count);
+  if (ret < 0)
+    return -1;
+  if (ret > 0) {
+    for (i = 0; i < s->loc_count; i++) {
+      l = &s->locs[i];
+      h = js_profiler_hash_loc(l->func, l->line_num, s->loc_hash_size);
+      l->hash_next = s->loc_hash[h];
+      s->loc_hash[h] = i;
+    }
+  }
+  i = s->loc_count++;
+  l = &s->locs[i];
+  l->func = func;
+  l->line_num = line_num;
+  l->col_num = col_num;
+  h = js_profiler_hash_loc(func, line_num, s->loc_hash_size);
+  l->hash_next = s->loc_hash[h];
+  s->loc_hash[h] = i;
+  return i;
+}
+
+/* return the location index of the frame or -1 if memory error */
+static int js_profiler_get_frame_loc(
+    JSRuntime* rt,
+    JSProfiler* s,
+    JSStackFrame* sf) {
+  JSObject* p = JS_VALUE_GET_OBJ(sf->cur_func);
+  JSFunctionBytecode* b = NULL;
+  JSGCObjectHeader* obj;
+  JSProfilerPCCacheEntry* e;
+  uint32_t pc = 0;
+  int func, loc, line_num = 0, col_num = 0;
+
+  if (js_class_has_bytecode(p->class_id)) {
+    b = p->u.func.function_bytecode;
+    obj = &b->header;
+    if (b->byte_code_buf && sf->cur_pc > b->byte_code_buf &&
+        sf->cur_pc <= b->byte_code_buf + b->byte_code_len)
+      pc = sf->cur_pc - b->byte_code_buf - 1;
+  } else {
+    obj = &p->header;
+  }
+
+  e = &s->pc_cache
+           [(js_profiler_hash_ptr(obj, JS_PROFILER_PC_CACHE_SIZE) ^ pc) &
+            (JS_PROFILER_PC_CACHE_SIZE - 1)];
+  if (e->obj == obj && e->pc == pc)
+    return e->loc;
+
+  func = js_profiler_find_func(rt, s, obj, b != NULL);
+  if (func < 0)
+    return -1;
+  if (b && b->has_debug) {
+    line_num = find_line_num(b->realm, b, pc, &col_num);
+    if (line_num < 0)
+      line_num = 0;
+  }
+  loc = js_profiler_find_loc(rt, s, func, line_num, col_num);
+  if (loc < 0)
+    return -1;
+  /* the cached object cannot be freed while it is in the func table */
+  e->obj = obj;
+  e->pc = pc;
+  e->loc = loc;
+  return loc;
+}
+
+static int js_profiler_get_child(
+    JSRuntime* rt,
+    JSProfiler* s,
+    uint32_t parent,
+    uint32_t loc) {
+  JSProfilerNode* n;
+  uint32_t i;
+
+  for (i = s->nodes[parent].first_child; i != -1; i = s->nodes[i].next_sibling) {
+    if (s->nodes[i].loc == loc)
+      return i;
+  }
+  if (js_profiler_grow(
+          rt, (void**)&s->nodes, &s->node_size, s->node_count, sizeof(*n)))
+    return -1;
+  i = s->node_count++;
+  n = &s->nodes[i];
+  n->parent = parent;
+  n->loc = loc;
+  n->first_child = -1;
+  n->hit_count = 0;
+  n->next_sibling = s->nodes[parent].first_child;
+  s->nodes[parent].first_child = i;
+  return i;
+}
+
+static void js_profiler_sample(JSRuntime* rt, JSProfiler* s, int64_t now) {
+  uint32_t stack[JS_PROFILER_MAX_DEPTH];
+  JSStackFrame* sf;
+  int depth, loc, node;
+
+  /* the outermost frames are dropped if the stack is too deep */
+  depth = 0;
+  for (sf = rt->current_stack_frame; sf != NULL && depth < (int)countof(stack);
+       sf = sf->prev_frame) {
+    if (JS_VALUE_GET_TAG(sf->cur_func) != JS_TAG_OBJECT)
+      continue;
+    loc = js_profiler_get_frame_loc(rt, s, sf);
+    if (loc < 0)
+      return;
+    stack[depth++] = loc;
+  }
+
+  node = 0;
+  while (depth > 0) {
+    node = js_profiler_get_child(rt, s, node, stack[--depth]);
+    if (node < 0)
+      return;
+  }
+  if (js_profiler_grow(
+          rt,
+          (void**)&s->samples,
+          &s->sample_size,
+          s->sample_count,
+          sizeof(s->samples[0])))
+    return;
+  s->nodes[node].hit_count++;
+  s->samples[s->sample_count].node = node;
+  s->samples[s->sample_count].delta_us = (uint32_t)(now - s->last_time);
+  s->sample_count++;
+  s->last_time = now;
+}
+
+BOOL js_profiler_is_running(JSRuntime* rt) {
+  return rt->profiler && rt->profiler->running;
+}
+
+void js_profiler_poll(JSRuntime* rt) {
+  JSProfiler* s = rt->profiler;
+  int64_t now;
+
+  if (!s->running)
+    return;
+  now = js_profiler_now_us();
+  if (now < s->next_time)
+    return;
+  js_profiler_sample(rt, s, now);
+  s->next_time = now + s->interval_us;
+}
+
+void js_profiler_free(JSRuntime* rt) {
+  JSProfiler* s = rt->profiler;
+  uint32_t i;
+
+  if (!s)
+    return;
+  rt->profiler = NULL;
+  for (i = 0; i < s->func_count; i++) {
+    JSProfilerFunc* f = &s->funcs[i];
+    JS_FreeValueRT(
+        rt,
+        JS_MKPTR(
+            f->is_bytecode ? JS_TAG_FUNCTION_BYTECODE : JS_TAG_OBJECT,
+            f->obj));
+  }
+  js_free_rt(rt, s->funcs);
+  js_free_rt(rt, s->func_hash);
+  js_free_rt(rt, s->locs);
+  js_free_rt(rt, s->loc_hash);
+  js_free_rt(rt, s->nodes);
+  js_free_rt(rt, s->samples);
+  js_free_rt(rt, s);
+}
+
+int js_profiler_start(JSRuntime* rt, uint32_t interval_us) {
+  JSProfiler* s;
+
+  js_profiler_free(rt);
+  s = js_mallocz_rt(rt, sizeof(*s));
+  if (!s)
+    return -1;
+  if (js_profiler_grow(
+          rt, (void**)&s->nodes, &s->node_size, 0, sizeof(s->nodes[0]))) {
+    js_free_rt(rt, s);
+    return -1;
+  }
+  s->node_count = 1;
+  s->nodes[0].parent = -1;
+  s->nodes[0].loc = -1;
+  s->nodes[0].first_child = -1;
+  s->nodes[0].next_sibling = -1;
+  s->nodes[0].hit_count = 0;
+  s->interval_us = max_int(interval_us, 1);
+  s->start_time = js_profiler_now_us();
+  s->last_time = s->start_time;
+  s->next_time = s->start_time + s->interval_us;
+  s->running = TRUE;
+  rt->profiler = s;
+  return 0;
+}
+
+void js_profiler_stop(JSRuntime* rt) {
+  JSProfiler* s = rt->profiler;
+  if (s && s->running) {
+    s->running = FALSE;
+    s->end_time = js_profiler_now_us();
+  }
+}
+
+uint32_t js_profiler_get_sample_count(JSRuntime* rt) {
+  return rt->profiler ? rt->profiler->sample_count : 0;
+}
+
+static const char* js_profiler_func_name(JSContext* ctx, JSProfilerFunc* f) {
+  if (f->is_bytecode) {
+    JSFunctionBytecode* b = (JSFunctionBytecode*)f->obj;
+    if (b->func_name == JS_ATOM_NULL)
+      return NULL;
+    return JS_AtomToCString(ctx, b->func_name);
+  } else {
+    return get_func_name(ctx, JS_MKPTR(JS_TAG_OBJECT, f->obj));
+  }
+}
+
+static const char* js_profiler_func_filename(
+    JSContext* ctx,
+    JSProfilerFunc* f) {
+  JSFunctionBytecode* b;
+  if (!f->is_bytecode)
+    return NULL;
+  b = (JSFunctionBytecode*)f->obj;
+  if (!b->has_debug || b->debug.filename == JS_ATOM_NULL)
+    return NULL;
+  return JS_AtomToCString(ctx, b->debug.filename);
+}
+
+void js_profiler_put_json_str(DynBuf* dbuf, const char* str) {
+  const uint8_t* p;
+  dbuf_putc(dbuf, '\"');
+  for (p = (const uint8_t*)str; *p != '\0'; p++) {
+    if (*p == '\"' || *p == '\\') {
+      dbuf_putc(dbuf, '\\');
+      dbuf_putc(dbuf, *p);
+    } else if (*p < 0x20) {
+      dbuf_printf(dbuf, "\\u%04x", *p);
+    } else {
+      dbuf_putc(dbuf, *p);
+    }
+  }
+  dbuf_putc(dbuf, '\"');
+}
+
+JSValue js_profiler_to_trace_event(JSContext* ctx) {
+  JSProfiler* s = ctx->rt->profiler;
+  DynBuf dbuf;
+  JSValue ret;
+  uint32_t i;
+  int64_t end_time;
+
+  if (!s)
+    return JS_NULL;
+  end_time = s->running ? js_profiler_now_us() : s->end_time;
+  js_dbuf_init(ctx, &dbuf);
+  dbuf_printf(
+      &dbuf,
+      "{\"traceEvents\":["
+      "{\"name\":\"Profile\",\"ph\":\"P\",\"cat\":"
+      "\"disabled-by-default-v8.cpu_profiler\",\"id\":\"0x1\",\"pid\":1,"
+      "\"tid\":1,\"ts\":%" PRId64 ",\"args\":{\"data\":{\"startTime\":%" PRId64
+      "}}},",
+      s->start_time,
+      s->start_time);
+  dbuf_printf(
+      &dbuf,
+      "{\"name\":\"ProfileChunk\",\"ph\":\"P\",\"cat\":"
+      "\"disabled-by-default-v8.cpu_profiler\",\"id\":\"0x1\",\"pid\":1,"
+      "\"tid\":1,\"ts\":%" PRId64
+      ",\"args\":{\"data\":{\"cpuProfile\":{\"nodes\":[",
+      end_time);
+  for (i = 0; i < s->node_count; i++) {
+    JSProfilerNode* n = &s->nodes[i];
+    const char *name, *filename;
+    int line_num = 0, col_num = 0;
+    if (i != 0)
+      dbuf_putc(&dbuf, ',');
+    dbuf_printf(&dbuf, "{\"id\":%u,\"callFrame\":{\"functionName\":", i + 1);
+    if (i == 0) {
+      name = NULL;
+      filename = NULL;
+      js_profiler_put_json_str(&dbuf, "(root)");
+    } else {
+      JSProfilerLoc* l = &s->locs[n->loc];
+      name = js_profiler_func_name(ctx, &s->funcs[l->func]);
+      filename = js_profiler_func_filename(ctx, &s->funcs[l->func]);
+      line_num = l->line_num;
+      col_num = l->col_num;
+      js_profiler_put_json_str(
+          &dbuf, name && name[0] != '\0' ? name : "(anonymous)");
+    }
+    dbuf_printf(&dbuf, ",\"scriptId\":\"0\",\"url\":");
+    js_profiler_put_json_str(&dbuf, filename ? filename : "");
+    /* the trace-event positions are zero based */
+    dbuf_printf(
+        &dbuf,
+        ",\"lineNumber\":%d,\"columnNumber\":%d}",
+        line_num - 1,
+        col_num - 1);
+    if (i != 0)
+      dbuf_printf(&dbuf, ",\"parent\":%u", n->parent + 1);
+    dbuf_putc(&dbuf, '}');
+    JS_FreeCString(ctx, name);
+    JS_FreeCString(ctx, filename);
+  }
+  dbuf_printf(&dbuf, "],\"samples\":[");
+  for (i = 0; i < s->sample_count; i++) {
+    dbuf_printf(&dbuf, i ? ",%u" : "%u", s->samples[i].node + 1);
+  }
+  dbuf_printf(&dbuf, "]},\"timeDeltas\":[");
+  for (i = 0; i < s->sample_count; i++) {
+    dbuf_printf(&dbuf, i ? ",%u" : "%u", s->samples[i].delta_us);
+  }
+  dbuf_printf(&dbuf, "]}}}]}");
+  if (dbuf_error(&dbuf)) {
+    dbuf_free(&dbuf);
+    return JS_ThrowOutOfMemory(ctx);
+  }
+  ret = JS_NewStringLen(ctx, (const char*)dbuf.buf, dbuf.size);
+  dbuf_free(&dbuf);
+  return ret;
+}
+
+/* protobuf encoding of the pprof profile.proto messages */
+
+static void pb_put_varint(DynBuf* dbuf, uint64_t v) {
+  while (v >= 0x80) {
+    dbuf_putc(dbuf, (uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  dbuf_putc(dbuf, (uint8_t)v);
+}
+
+static void pb_put_int(DynBuf* dbuf, int field, uint64_t v) {
+  pb_put_varint(dbuf, (uint64_t)field << 3);
+  pb_put_varint(dbuf, v);
+}
+
+static void pb_put_bytes(
+    DynBuf* dbuf,
+    int field,
+    const uint8_t* buf,
+    size_t len) {
+  pb_put_varint(dbuf, ((uint64_t)field << 3) | 2);
+  pb_put_varint(dbuf, len);
+  dbuf_put(dbuf, buf, len);
+}
+
+/* append 'msg' as the embedded message 'field' and reset it */
+static void pb_put_msg(DynBuf* dbuf, int field, DynBuf* msg) {
+  pb_put_bytes(dbuf, field, msg->buf, msg->size);
+  msg->size = 0;
+}
+
+static void pb_put_value_type(
+    DynBuf* dbuf,
+    DynBuf* msg,
+    int field,
+    int type,
+    int unit) {
+  pb_put_int(msg, 1, type);
+  pb_put_int(msg, 2, unit);
+  pb_put_msg(dbuf, field, msg);
+}
+
+enum {
+  PPROF_STR_EMPTY,
+  PPROF_STR_SAMPLES,
+  PPROF_STR_COUNT,
+  PPROF_STR_CPU,
+  PPROF_STR_NANOSECONDS,
+  PPROF_STR_ANONYMOUS,
+  PPROF_STR_FIRST_FUNC, /* name and filename of each function */
+};
+
+JSValue js_profiler_to_pprof(JSContext* ctx) {
+  static const char* const fixed_strings[] = {
+      "", "samples", "count", "cpu", "nanoseconds", "(anonymous)"};
+  JSProfiler* s = ctx->rt->profiler;
+  DynBuf dbuf, msg, msg2;
+  JSValue ret;
+  uint32_t i, j;
+  int64_t end_time, period_ns;
+
+  if (!s)
+    return JS_NULL;
+  end_time = s->running ? js_profiler_now_us() : s->end_time;
+  period_ns = (int64_t)s->interval_us * 1000;
+  js_dbuf_init(ctx, &dbuf);
+  js_dbuf_init(ctx, &msg);
+  js_dbuf_init(ctx, &msg2);
+
+  pb_put_value_type(&dbuf, &msg, 1, PPROF_STR_SAMPLES, PPROF_STR_COUNT);
+  pb_put_value_type(&dbuf, &msg, 1, PPROF_STR_CPU, PPROF_STR_NANOSECONDS);
+
+  /* one sample per call tree node with hits, leaf first */
+  for (i = 1; i < s->node_count; i++) {
+    JSProfilerNode* n = &s->nodes[i];
+    if (n->hit_count == 0)
+      continue;
+    for (j = i; j != 0; j = s->nodes[j].parent)
+      pb_put_varint(&msg2, s->nodes[j].loc + 1);
+    pb_put_msg(&msg, 1, &msg2);
+    pb_put_varint(&msg2, n->hit_count);
+    pb_put_varint(&msg2, n->hit_count * period_ns);
+    pb_put_msg(&msg, 2, &msg2);
+    pb_put_msg(&dbuf, 2, &msg);
+  }
+
+  for (i = 0; i < s->loc_count; i++) {
+    JSProfilerLoc* l = &s->locs[i];
+    pb_put_int(&msg, 1, i + 1);
+    pb_put_int(&msg2, 1, l->func + 1);
+    pb_put_int(&msg2, 2, l->line_num);
+    pb_put_msg(&msg, 4, &msg2);
+    pb_put_msg(&dbuf, 4, &msg);
+  }
+
+  for (i = 0; i < s->func_count; i++) {
+    uint32_t name = PPROF_STR_FIRST_FUNC + 2 * i;
+    pb_put_int(&msg, 1, i + 1);
+    pb_put_int(&msg, 2, name);
+    pb_put_int(&msg, 3, name);
+    pb_put_int(&msg, 4, name + 1);
+    pb_put_msg(&dbuf, 5, &msg);
+  }
+
+  for (i = 0; i < countof(fixed_strings); i++) {
+    pb_put_bytes(
+        &dbuf,
+        6,
+        (const uint8_t*)fixed_strings[i],
+        strlen(fixed_strings[i]));
+  }
+  for (i = 0; i < s->func_count; i++) {
+    const char* name = js_profiler_func_name(ctx, &s->funcs[i]);
+    const char* filename = js_profiler_func_filename(ctx, &s->funcs[i]);
+    if (!name || name[0] == '\0') {
+      JS_FreeCString(ctx, name);
+      name = NULL;
+    }
+    if (!name)
+      name = fixed_strings[PPROF_STR_ANONYMOUS];
+    pb_put_bytes(&dbuf, 6, (const uint8_t*)name, strlen(name));
+    pb_put_bytes(
+        &dbuf,
+        6,
+        (const uint8_t*)(filename ? filename : ""),
+        filename ? strlen(filename) : 0);
+    if (name != fixed_strings[PPROF_STR_ANONYMOUS])
+      JS_FreeCString(ctx, name);
+    JS_FreeCString(ctx, filename);
+  }
+
+  pb_put_int(&dbuf, 9, s->start_time * 1000);
+  pb_put_int(&dbuf, 10, (end_time - s->start_time) * 1000);
+  pb_put_value_type(&dbuf, &msg, 11, PPROF_STR_CPU, PPROF_STR_NANOSECONDS);
+  pb_put_int(&dbuf, 12, period_ns);
+
+  if (dbuf_error(&dbuf) || dbuf_error(&msg) || dbuf_error(&msg2)) {
+    ret = JS_ThrowOutOfMemory(ctx);
+  } else {
+    ret = JS_NewArrayBufferCopy(ctx, dbuf.buf, dbuf.size);
+  }
+  dbuf_free(&msg2);
+  dbuf_free(&msg);
+  dbuf_free(&dbuf);
+  return ret;
+}
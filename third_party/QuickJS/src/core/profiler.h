@@ -0,0 +1,71 @@
+/*
+ * QuickJS Javascript Engine
+ *
+ * Copyright (c) 2017-2025 Fabrice Bellard
+ * Copyright (c) 2017-2025 Charlie Gordon
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "QuickJS/quickjs.h"
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* interrupt counter used while profiling so that the clock is checked
+   often enough for the sampling interval */
+#define JS_PROFILER_INTERRUPT_COUNTER_INIT 1000
+
+typedef struct JSProfiler JSProfiler;
+
+int js_profiler_start(JSRuntime* rt, uint32_t interval_us);
+void js_profiler_stop(JSRuntime* rt);
+void js_profiler_free(JSRuntime* rt);
+BOOL js_profiler_is_running(JSRuntime* rt);
+/* called from the interrupt polling path */
+void js_profiler_poll(JSRuntime* rt);
+uint32_t js_profiler_get_sample_count(JSRuntime* rt);
+/* Chrome trace-event JSON (Profile/ProfileChunk events) */
+JSValue js_profiler_to_trace_event(JSContext* ctx);
+/* uncompressed pprof profile.proto */
+JSValue js_profiler_to_pprof(JSContext* ctx);
+
+/* helpers shared with the heap profiler */
+int js_profiler_grow(
+    JSRuntime* rt,
+    void** parray,
+    uint32_t* psize,
+    uint32_t count,
+    size_t elem_size);
+/* return 1 if the hash table was resized and must be refilled */
+int js_profiler_resize_hash(
+    JSRuntime* rt,
+    uint32_t** phash,
+    uint32_t* phash_size,
+    uint32_t count);
+uint32_t js_profiler_hash_ptr(const void* ptr, uint32_t hash_size);
+void js_profiler_put_json_str(DynBuf* dbuf, const char* str);
+
+#ifdef __cplusplus
+}
+#endif
@@ -40,16 +40,19 @@
 #include "builtins/js-operator.h"
 #include "builtins/js-proxy.h"
 #include "builtins/js-reflect.h"
+#include "builtins/js-regexp.h"
 #include "builtins/js-string.h"
 #include "builtins/js-symbol.h"
 #include "convertion.h"
 #include "exception.h"
 #include "function.h"
 #include "gc.h"
+#include "heap_profiler.h"
 #include "malloc.h"
 #include "module.h"
 #include "object.h"
 #include "parser.h"
+#include "profiler.h"
 #include "shape.h"
 #include "string-utils.h"
 
@@ -1382,6 +1385,11 @@ BOOL is_backtrace_needed(JSContext* ctx, JSValueConst obj) {
 no_inline __exception int __js_poll_interrupts(JSContext* ctx) {
   JSRuntime* rt = ctx->rt;
   ctx->interrupt_counter = JS_INTERRUPT_COUNTER_INIT;
+  /* a stopped profile kept for export does not need the short period */
+  if (unlikely(rt->profiler) && js_profiler_is_running(rt)) {
+    ctx->interrupt_counter = JS_PROFILER_INTERRUPT_COUNTER_INIT;
+    js_profiler_poll(rt);
+  }
   if (rt->interrupt_handler) {
     if (rt->interrupt_handler(rt, rt->interrupt_opaque)) {
       JS_ThrowInterrupted(ctx);
@@ -3208,9 +3216,16 @@ void JS_FreeRuntime(JSRuntime* rt) {
   }
   init_list_head(&rt->job_list);
 
+  ic_stub_cache_free(rt);
+  js_regexp_cache_free(rt);
+  js_profiler_free(rt);
+  js_heap_profiler_free(rt);
+
   /* don't remove the weak objects to avoid create new jobs with
       FinalizationRegistry */
   JS_RunGCInternal(rt, FALSE);
+  /* the remaining objects are leaks */
+  gc_merge_generations(rt);
 
 #ifdef DUMP_LEAKS
   printf("DUMP_LEAKS******************\n");
@@ -3338,6 +3353,8 @@ void JS_FreeRuntime(JSRuntime* rt) {
   js_free_rt(rt, rt->atom_array);
   js_free_rt(rt, rt->atom_hash);
   js_free_rt(rt, rt->shape_hash);
+  /* reports the slots of the leaked objects */
+  js_slab_free_all(rt);
 #ifdef DUMP_LEAKS
   if (!list_empty(&rt->string_list)) {
     if (rt->rt_info) {
@@ -3477,7 +3494,7 @@ void JS_FreeContext(JSContext* ctx) {
     JSGCObjectHeader* p;
     printf("JSObjects: {\n");
     JS_DumpObjectHeader(ctx->rt);
-    list_for_each(el, &rt->gc_obj_list) {
+    gc_for_each_obj(el, rt) {
       p = list_entry(el, JSGCObjectHeader, link);
       JS_DumpGCObject(rt, p);
     }
@@ -3494,6 +3511,8 @@ void JS_FreeContext(JSContext* ctx) {
 #if QUICKJS_DEBUG
   js_debugger_free_context(ctx);
 #endif
+  /* the cached shapes may reference the objects of this context */
+  ic_stub_cache_flush(rt);
   js_free_modules(ctx, JS_FREE_MODULE_ALL);
 
   JS_FreeValue(ctx, ctx->global_obj);
@@ -3586,9 +3605,11 @@ JSRuntime* JS_NewRuntime2(const JSMallocFunctions* mf, void* opaque) {
   rt->malloc_state = ms;
   rt->malloc_gc_threshold = MALLOC_GC_THRESHOLD;
   rt->gc_off = FALSE;
+  rt->regexp_cache_size = JS_REGEXP_CACHE_SIZE_DEFAULT;
 
   init_list_head(&rt->context_list);
   init_list_head(&rt->gc_obj_list);
+  init_list_head(&rt->gc_old_obj_list);
   init_list_head(&rt->gc_zero_ref_count_list);
   rt->gc_phase = JS_GC_PHASE_NONE;
   init_list_head(&rt->weakref_list);
@@ -314,6 +314,18 @@ static inline __exception int js_poll_interrupts(JSContext* ctx) {
   }
 }
 
+/* same as js_poll_interrupts() but the PC of the interpreted frame is
+   saved first so that the profiler samples the right line */
+static inline __exception int
+js_poll_interrupts_pc(JSContext* ctx, JSStackFrame* sf, uint8_t* pc) {
+  if (unlikely(--ctx->interrupt_counter <= 0)) {
+    sf->cur_pc = pc;
+    return __js_poll_interrupts(ctx);
+  } else {
+    return 0;
+  }
+}
+
 int check_function(JSContext* ctx, JSValueConst obj);
 JSValue JS_EvalObject(
     JSContext* ctx,
@@ -118,7 +118,7 @@ js_new_shape2(JSContext* ctx, JSObject* proto, int hash_size, int prop_size) {
     resize_shape_hash(rt, rt->shape_hash_bits + 1);
   }
 
-  sh_alloc = js_malloc(ctx, get_shape_size(hash_size, prop_size));
+  sh_alloc = js_slab_alloc(ctx, get_shape_size(hash_size, prop_size));
   if (!sh_alloc)
     return NULL;
   sh = get_shape_from_alloc(sh_alloc, hash_size);
@@ -161,7 +161,7 @@ JSShape* js_clone_shape(JSContext* ctx, JSShape* sh1) {
 
   hash_size = sh1->prop_hash_mask + 1;
   size = get_shape_size(hash_size, sh1->prop_size);
-  sh_alloc = js_malloc(ctx, size);
+  sh_alloc = js_slab_alloc(ctx, size);
   if (!sh_alloc)
     return NULL;
   sh_alloc1 = get_alloc_from_shape(sh1);
@@ -202,7 +202,10 @@ void js_free_shape0(JSRuntime* rt, JSShape* sh) {
     pr++;
   }
   remove_gc_object(&sh->header);
-  js_free_rt(rt, get_alloc_from_shape(sh));
+  js_slab_free_rt(
+      rt,
+      get_alloc_from_shape(sh),
+      get_shape_size(sh->prop_hash_mask + 1, sh->prop_size));
 }
 
 void js_free_shape(JSRuntime* rt, JSShape* sh) {
@@ -243,7 +246,7 @@ resize_properties(JSContext* ctx, JSShape** psh, JSObject* p, uint32_t count) {
   /* resize the property shapes. Using js_realloc() is not possible in
      case the GC runs during the allocation */
   old_sh = sh;
-  sh_alloc = js_malloc(ctx, get_shape_size(new_hash_size, new_size));
+  sh_alloc = js_slab_alloc(ctx, get_shape_size(new_hash_size, new_size));
   if (!sh_alloc)
     return -1;
   sh = get_shape_from_alloc(sh_alloc, new_hash_size);
@@ -275,7 +278,10 @@ resize_properties(JSContext* ctx, JSShape** psh, JSObject* p, uint32_t count) {
         prop_hash_end(old_sh) - new_hash_size,
         sizeof(prop_hash_end(sh)[0]) * new_hash_size);
   }
-  js_free(ctx, get_alloc_from_shape(old_sh));
+  js_slab_free_rt(
+      ctx->rt,
+      get_alloc_from_shape(old_sh),
+      get_shape_size(old_sh->prop_hash_mask + 1, old_sh->prop_size));
   *psh = sh;
   sh->prop_size = new_size;
   return 0;
@@ -304,7 +310,7 @@ int compact_properties(JSContext* ctx, JSObject* p) {
 
   /* resize the hash table and the properties */
   old_sh = sh;
-  sh_alloc = js_malloc(ctx, get_shape_size(new_hash_size, new_size));
+  sh_alloc = js_slab_alloc(ctx, get_shape_size(new_hash_size, new_size));
   if (!sh_alloc)
     return -1;
   sh = get_shape_from_alloc(sh_alloc, new_hash_size);
@@ -341,7 +347,10 @@ int compact_properties(JSContext* ctx, JSObject* p) {
   sh->prop_count = j;
 
   p->shape = sh;
-  js_free(ctx, get_alloc_from_shape(old_sh));
+  js_slab_free_rt(
+      ctx->rt,
+      get_alloc_from_shape(old_sh),
+      get_shape_size(old_sh->prop_hash_mask + 1, old_sh->prop_size));
 
   /* reduce the size of the object properties */
   new_prop = js_realloc(ctx, p->prop, sizeof(new_prop[0]) * new_size);
@@ -491,7 +500,7 @@ __maybe_unused void JS_DumpShapes(JSRuntime* rt) {
     }
   }
   /* dump non-hashed shapes */
-  list_for_each(el, &rt->gc_obj_list) {
+  gc_for_each_obj(el, rt) {
     gp = list_entry(el, JSGCObjectHeader, link);
     if (gp->gc_obj_type == JS_GC_OBJ_TYPE_JS_OBJECT) {
       p = (JSObject*)gp;
@@ -507,7 +516,7 @@ JSValue JS_NewObjectFromShape(JSContext* ctx, JSShape* sh, JSClassID class_id) {
   JSObject* p;
 
   js_trigger_gc(ctx->rt, sizeof(JSObject));
-  p = js_malloc(ctx, sizeof(JSObject));
+  p = js_slab_alloc(ctx, sizeof(JSObject));
   if (unlikely(!p))
     goto fail;
   p->class_id = class_id;
@@ -520,6 +529,8 @@ JSValue JS_NewObjectFromShape(JSContext* ctx, JSShape* sh, JSClassID class_id) {
   p->tmp_mark = 0;
   p->is_HTMLDDA = 0;
   p->weakref_count = 0;
+  p->alloc_site = js_heap_profiler_alloc_site(
+      ctx->rt, sizeof(JSObject) + sizeof(JSProperty) * sh->prop_size);
   p->u.opaque = NULL;
   p->shape = sh;
   p->prop = js_malloc(ctx, sizeof(JSProperty) * sh->prop_size);
@@ -59,6 +59,7 @@ JSString* js_alloc_string_rt(JSRuntime* rt, int max_len, int is_wide_char) {
 #ifdef DUMP_LEAKS
   list_add_tail(&str->link, &rt->string_list);
 #endif
+  js_heap_profiler_tag_string(rt, str);
   return str;
 }
 
@@ -524,6 +525,7 @@ JSAtom __JS_NewAtom(JSRuntime* rt, JSString* str, int atom_type) {
 #ifdef DUMP_LEAKS
       list_add_tail(&p->link, &rt->string_list);
 #endif
+      js_heap_profiler_tag_string(rt, p);
       memcpy(
           p->u.str8,
           str->u.str8,
@@ -644,6 +646,7 @@ void JS_FreeAtomStruct(JSRuntime* rt, JSAtomStruct* p) {
 #ifdef DUMP_LEAKS
   list_del(&p->link);
 #endif
+  js_heap_profiler_free_string(rt, p);
   if (p->atom_type == JS_ATOM_TYPE_SYMBOL && p->hash != JS_ATOM_HASH_PRIVATE &&
       p->hash != 0) {
     /* live weak references are still present on this object: keep
@@ -1707,6 +1710,7 @@ int string_buffer_init2(
   /* the StringBuffer may reallocate the JSString, only link it at the end */
   list_del(&s->str->link);
 #endif
+  js_heap_profiler_cancel_string(ctx->rt, s->str);
   return 0;
 }
 
@@ -2001,6 +2005,7 @@ JSValue string_buffer_end(StringBuffer* s) {
 #endif
   str->is_wide_char = s->is_wide_char;
   str->len = s->len;
+  js_heap_profiler_tag_string(s->ctx->rt, str);
   s->str = NULL;
   return JS_MKPTR(JS_TAG_STRING, str);
 }
@@ -30,6 +30,7 @@
 #include "QuickJS/libregexp.h"
 #include "QuickJS/libunicode.h"
 #include "QuickJS/quickjs.h"
+#include "heap_profiler.h"
 #include "types.h"
 
 #define ATOM_GET_STR_BUF_SIZE 64
@@ -133,6 +134,7 @@ static inline void js_free_string(JSRuntime* rt, JSString* str) {
 #ifdef DUMP_LEAKS
       list_del(&str->link);
 #endif
+      js_heap_profiler_free_string(rt, str);
       js_free_rt(rt, str);
     }
   }
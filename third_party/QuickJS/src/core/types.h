@@ -173,6 +173,21 @@ typedef enum {
   JS_RUNTIME_STATE_SHUTDOWN,
 } JSRuntimeState;
 
+/* size classes of the per-runtime slab allocator, see js_slab_alloc_rt() */
+#define JS_SLAB_GRANULE 16
+#define JS_SLAB_CLASS_COUNT 16
+#define JS_SLAB_MAX_SIZE (JS_SLAB_GRANULE * JS_SLAB_CLASS_COUNT)
+
+typedef struct JSSlabClass {
+  void* free_list; /* linked through the first word of each free slot */
+  uint8_t* bump_ptr; /* never used tail of the last allocated page */
+  uint8_t* bump_end;
+  struct JSSlabPage* pages;
+  uint32_t page_count;
+  size_t page_size; /* total size of 'pages' */
+  int64_t used_count; /* slots currently handed out */
+} JSSlabClass;
+
 typedef struct JSDebuggerFunctionInfo {
   // same length as byte_code_buf.
   uint8_t* breakpoints;
@@ -183,6 +198,7 @@ typedef struct JSDebuggerFunctionInfo {
 struct JSRuntime {
   JSMallocFunctions mf;
   JSMallocState malloc_state;
+  JSSlabClass slab_classes[JS_SLAB_CLASS_COUNT];
   const char* rt_info;
 
   int atom_hash_size; /* power of two */
@@ -198,14 +214,21 @@ struct JSRuntime {
 
   struct list_head context_list; /* list of JSContext.link */
   /* list of JSGCObjectHeader.link. List of allocated GC objects (used
-     by the garbage collector) */
+     by the garbage collector) which did not survive a collection yet */
   struct list_head gc_obj_list;
+  /* list of JSGCObjectHeader.link. GC objects which survived a
+     collection, only scanned by the full collections */
+  struct list_head gc_old_obj_list;
   /* list of JSGCObjectHeader.link. Used during JS_FreeValueRT() */
   struct list_head gc_zero_ref_count_list;
   struct list_head tmp_obj_list; /* used during GC */
   JSGCPhaseEnum gc_phase : 8;
   BOOL gc_off : 8;
+  BOOL gc_generational : 8; /* see JS_SetGCGenerational() */
   size_t malloc_gc_threshold;
+  /* memory usage above which a full collection is done in
+     generational mode */
+  size_t malloc_gc_full_threshold;
   struct list_head weakref_list; /* list of JSWeakRefHeader.link */
 #ifdef DUMP_LEAKS
   struct list_head string_list; /* list of JSString.link */
@@ -253,6 +276,15 @@ struct JSRuntime {
   int shape_hash_size;
   int shape_hash_count; /* number of hashed shapes */
   JSShape** shape_hash;
+  /* megamorphic inline cache, allocated on first use */
+  struct InlineCacheStubEntry* ic_stub_cache;
+  /* compiled RegExp bytecode, allocated on first use */
+  struct JSRegExpCache* regexp_cache;
+  int regexp_cache_size; /* see JS_SetRegExpCacheSize() */
+  /* sampling profiler, NULL if not started */
+  struct JSProfiler* profiler;
+  /* allocation site heap profiler, NULL if not started */
+  struct JSHeapProfiler* heap_profiler;
   void* user_opaque;
   JSRuntimeState state; /** @todo diff */
 #if QUICKJS_DEBUG
@@ -438,12 +470,37 @@ typedef struct InlineCacheRingItem {
   ICWatchpoint* watchpoint_ref;
 } InlineCacheRingItem;
 
+typedef enum InlineCacheStateEnum {
+  IC_STATE_UNINITIALIZED,
+  IC_STATE_MONOMORPHIC,
+  IC_STATE_POLYMORPHIC,
+  /* the ring overflowed: own data properties are looked up in the
+     runtime wide stub cache instead of evicting ring items */
+  IC_STATE_MEGAMORPHIC,
+} InlineCacheStateEnum;
+
 typedef struct InlineCacheRingSlot {
   JSAtom atom;
   InlineCacheRingItem buffer[IC_CACHE_ITEM_CAPACITY];
   uint8_t index;
+  uint8_t state; /* see InlineCacheStateEnum */
+  uint32_t transitions;
+  uint64_t hits;
+  uint64_t misses;
 } InlineCacheRingSlot;
 
+#define IC_STUB_CACHE_BITS 10
+#define IC_STUB_CACHE_SIZE (1 << IC_STUB_CACHE_BITS)
+
+/* entry of the runtime wide (shape, atom) -> offset cache shared by
+   the megamorphic sites. The shape is referenced so that it cannot be
+   modified in place nor reused while it is cached. */
+typedef struct InlineCacheStubEntry {
+  JSShape* shape;
+  JSAtom atom;
+  uint32_t prop_offset;
+} InlineCacheStubEntry;
+
 typedef struct InlineCacheHashSlot {
   JSAtom atom;
   uint32_t index;
@@ -478,7 +535,11 @@ typedef struct JSFunctionBytecode {
   uint8_t read_only_bytecode : 1;
   uint8_t
       is_direct_or_indirect_eval : 1; /* used by JS_GetScriptOrModuleName() */
-  /* XXX: 10 bits available */
+  /* true if the body (byte code, debug info, cpool) is not decoded yet,
+     see js_materialize_function_bytecode() */
+  uint8_t is_lazy : 1;
+  uint8_t byte_code_allocated : 1; /* byte_code_buf is a separate block */
+  /* XXX: 8 bits available */
   uint8_t* byte_code_buf; /* (self pointer) */
   int byte_code_len;
   JSAtom func_name;
@@ -495,6 +556,10 @@ typedef struct JSFunctionBytecode {
   int cpool_count;
   int closure_var_count;
   InlineCache* ic;
+  /* binary image the function was read from (JS_READ_OBJ_LAZY or borrowed
+     read-only byte code), NULL otherwise */
+  struct JSBytecodeSource* source;
+  uint32_t source_offset; /* position of the lazy body in 'source' */
   struct {
     /* debug info, move to separate structure to save memory? */
     JSAtom filename;
@@ -879,6 +944,9 @@ struct JSObject {
       structure is freed only if header.ref_count = 0 and
       weakref_count = 0 */
   uint32_t weakref_count; 
+  /* heap profiler allocation site, 0 if unknown. Fills the padding
+     before 'shape' on 64-bit targets. */
+  uint32_t alloc_site;
   JSShape* shape; /* prototype and property names + flag */
   JSProperty* prop; /* array of properties */
   union {
@@ -41,6 +41,29 @@ int taro_bc_get_binary_compatible(const uint8_t* buf, size_t buf_len) {
   return taro_bc_get_binary_version(buf, buf_len) == BC_VERSION ? 0 : -1;
 }
 
+std::string taro_js_write_context_snapshot(
+    JSContext* ctx,
+    JSContext* base_ctx) {
+  size_t size = 0;
+  uint8_t* buf = JS_WriteContextSnapshot(ctx, &size, base_ctx);
+  if (!buf)
+    return std::string();
+
+  std::string image(reinterpret_cast<const char*>(buf), size);
+  js_free(ctx, buf);
+  return image;
+}
+
+int taro_js_restore_context_snapshot(JSContext* ctx, const std::string& image) {
+  if (image.empty()) {
+    JS_ThrowTypeError(ctx, "empty context snapshot");
+    return -1;
+  }
+
+  const uint8_t* buf = reinterpret_cast<const uint8_t*>(image.data());
+  return JS_RestoreContextSnapshot(ctx, buf, image.size());
+}
+
 
 #ifdef DUMP_BYTECODE
 static void taro_dump_function_header(JSContext* ctx, JSFunctionBytecode* b, std::ostringstream& ss) {
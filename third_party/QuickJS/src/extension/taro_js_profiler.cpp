@@ -0,0 +1,78 @@
+#include "QuickJS/extension/taro_js_profiler.h"
+
+#include "../core/heap_profiler.h"
+#include "../core/profiler.h"
+
+int taro_js_profiler_start(JSRuntime* rt, uint32_t interval_us) {
+  return js_profiler_start(rt, interval_us);
+}
+
+void taro_js_profiler_stop(JSRuntime* rt) {
+  js_profiler_stop(rt);
+}
+
+void taro_js_profiler_clear(JSRuntime* rt) {
+  js_profiler_free(rt);
+}
+
+uint32_t taro_js_profiler_sample_count(JSRuntime* rt) {
+  return js_profiler_get_sample_count(rt);
+}
+
+JSValue taro_js_profiler_to_trace_event(JSContext* ctx) {
+  return js_profiler_to_trace_event(ctx);
+}
+
+JSValue taro_js_profiler_to_pprof(JSContext* ctx) {
+  return js_profiler_to_pprof(ctx);
+}
+
+int taro_js_heap_profiler_start(JSRuntime* rt) {
+  return js_heap_profiler_start(rt);
+}
+
+void taro_js_heap_profiler_stop(JSRuntime* rt) {
+  js_heap_profiler_stop(rt);
+}
+
+void taro_js_heap_profiler_clear(JSRuntime* rt) {
+  js_heap_profiler_free(rt);
+}
+
+struct HeapSiteCallback {
+  TaroJSHeapSiteFunc* func;
+  void* opaque;
+};
+
+static void heap_site_callback(
+    JSRuntime* rt,
+    const JSHeapSiteStats* st,
+    void* opaque) {
+  HeapSiteCallback* cb = (HeapSiteCallback*)opaque;
+  TaroJSHeapSite site;
+  site.func_name = st->func_name;
+  site.filename = st->filename;
+  site.line_num = st->line_num;
+  site.col_num = st->col_num;
+  site.alloc_count = st->alloc_count;
+  site.alloc_size = st->alloc_size;
+  site.live_count = st->live_count;
+  site.self_size = st->self_size;
+  site.retained_size = st->retained_size;
+  cb->func(rt, &site, cb->opaque);
+}
+
+int taro_js_heap_profiler_for_each_site(
+    JSRuntime* rt,
+    TaroJSHeapSiteFunc* func,
+    void* opaque) {
+  HeapSiteCallback cb = {func, opaque};
+  if (js_heap_profiler_compute(rt))
+    return -1;
+  js_heap_profiler_for_each_site(rt, heap_site_callback, &cb);
+  return 0;
+}
+
+JSValue taro_js_take_heap_snapshot(JSContext* ctx) {
+  return js_heap_profiler_take_snapshot(ctx);
+}
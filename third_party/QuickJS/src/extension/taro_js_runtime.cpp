@@ -3,6 +3,7 @@
 #include "../core/runtime.h"
 #include "../core/builtins/js-function.h"
 #include "../core/common.h"
+#include "../core/gc.h"
 
 void taro_js_set_property_function_list(
     JSContext* ctx,
@@ -29,3 +30,68 @@ int taro_js_ref_count(JSValueConst val) {
   }
   return -1;
 }
+
+void taro_js_for_each_inline_cache_site(
+    JSRuntime* rt,
+    TaroJSInlineCacheSiteFunc* func,
+    void* opaque) {
+  struct list_head* el;
+  TaroJSInlineCacheSite site;
+  gc_for_each_obj(el, rt) {
+    JSGCObjectHeader* gp = list_entry(el, JSGCObjectHeader, link);
+    if (gp->gc_obj_type != JS_GC_OBJ_TYPE_FUNCTION_BYTECODE)
+      continue;
+    JSFunctionBytecode* b = (JSFunctionBytecode*)gp;
+    InlineCache* ic = b->ic;
+    if (!ic || !ic->cache)
+      continue;
+    for (uint32_t i = 0; i < ic->count; i++) {
+      InlineCacheRingSlot* cr = ic->cache + i;
+      site.func_name = b->func_name;
+      site.filename = b->has_debug ? b->debug.filename : JS_ATOM_NULL;
+      site.atom = cr->atom;
+      site.state = cr->state;
+      site.transitions = cr->transitions;
+      site.hits = cr->hits;
+      site.misses = cr->misses;
+      func(rt, &site, opaque);
+    }
+  }
+}
+
+static void taro_js_add_inline_cache_site(
+    JSRuntime* rt,
+    const TaroJSInlineCacheSite* site,
+    void* opaque) {
+  TaroJSInlineCacheStats* stats = (TaroJSInlineCacheStats*)opaque;
+  stats->site_count++;
+  stats->state_count[site->state]++;
+  stats->transitions += site->transitions;
+  stats->hits += site->hits;
+  stats->misses += site->misses;
+}
+
+void taro_js_get_inline_cache_stats(
+    JSRuntime* rt,
+    TaroJSInlineCacheStats* stats) {
+  memset(stats, 0, sizeof(*stats));
+  taro_js_for_each_inline_cache_site(
+      rt, taro_js_add_inline_cache_site, stats);
+}
+
+void taro_js_reset_inline_cache_stats(JSRuntime* rt) {
+  struct list_head* el;
+  gc_for_each_obj(el, rt) {
+    JSGCObjectHeader* gp = list_entry(el, JSGCObjectHeader, link);
+    if (gp->gc_obj_type != JS_GC_OBJ_TYPE_FUNCTION_BYTECODE)
+      continue;
+    InlineCache* ic = ((JSFunctionBytecode*)gp)->ic;
+    if (!ic || !ic->cache)
+      continue;
+    for (uint32_t i = 0; i < ic->count; i++) {
+      ic->cache[i].transitions = 0;
+      ic->cache[i].hits = 0;
+      ic->cache[i].misses = 0;
+    }
+  }
+}
@@ -470,7 +470,7 @@ static __maybe_unused void lre_dump_bytecode(const uint8_t *buf,
            re_flags, buf[RE_HEADER_CAPTURE_COUNT], buf[RE_HEADER_STACK_SIZE]);
     if (re_flags & LRE_FLAG_NAMED_GROUPS) {
         const char *p;
-        p = (char *)buf + RE_HEADER_LEN + bc_len;
+        p = lre_get_groupnames(buf);
         printf("named groups: ");
         for(i = 1; i < buf[RE_HEADER_CAPTURE_COUNT]; i++) {
             if (i != 1)
@@ -2433,6 +2433,229 @@ static int compute_stack_size(const uint8_t *bc_buf, int bc_buf_len)
     return stack_size_max;
 }
 
+/* Prescan data, appended after the bytecode (and before the group
+   names) when LRE_FLAG_PRESCAN is set. It is extracted from the top
+   level sequence of a non sticky regexp and lets lre_exec() skip the
+   positions where no match can start. */
+#define RE_PRESCAN_FLAGS        0
+#define RE_PRESCAN_PREFIX_LEN   1
+#define RE_PRESCAN_REQUIRED_LEN 2
+#define RE_PRESCAN_BITMAP       3 /* 256 bits: first chars < 256 */
+#define RE_PRESCAN_PREFIX       (RE_PRESCAN_BITMAP + 32)
+#define RE_PRESCAN_REQUIRED     (RE_PRESCAN_PREFIX + 2 * RE_PRESCAN_LITERAL_MAX)
+#define RE_PRESCAN_LEN          (RE_PRESCAN_REQUIRED + 2 * RE_PRESCAN_LITERAL_MAX)
+
+#define RE_PRESCAN_LITERAL_MAX  16
+
+#define RE_PRESCAN_ANCHORED     (1 << 0) /* starts with '^' (no 'm' flag) */
+#define RE_PRESCAN_FIRST_CHAR   (1 << 1) /* the bitmap is valid */
+#define RE_PRESCAN_FIRST_HIGH   (1 << 2) /* chars >= 256 may start a match */
+
+/* length of the 'split_goto_first, any, goto' loop of non sticky regexps */
+#define RE_PRELUDE_LEN          11
+
+/* Add to 'bitmap' the chars < 256 matched by the character opcode at
+   'pc'. Return TRUE if chars >= 256 may also match. */
+static BOOL re_prescan_first_char(uint8_t *bitmap, const uint8_t *pc,
+                                  BOOL is_unicode)
+{
+    int opcode, n, i, j;
+    uint32_t c, low, high;
+    BOOL ignore_case, is_range32;
+
+    opcode = pc[0];
+    switch(opcode) {
+    case REOP_char:
+    case REOP_char32:
+        c = (opcode == REOP_char) ? get_u16(pc + 1) : get_u32(pc + 1);
+        if (c >= 256)
+            return TRUE;
+        bitmap[c >> 3] |= 1 << (c & 7);
+        return FALSE;
+    case REOP_char_i:
+    case REOP_char32_i:
+        c = (opcode == REOP_char_i) ? get_u16(pc + 1) : get_u32(pc + 1);
+        for(i = 0; i < 256; i++) {
+            if (lre_canonicalize(i, is_unicode) == c)
+                bitmap[i >> 3] |= 1 << (i & 7);
+        }
+        return TRUE;
+    default:
+        is_range32 = (opcode == REOP_range32 || opcode == REOP_range32_i);
+        ignore_case = (opcode == REOP_range_i || opcode == REOP_range32_i);
+        n = get_u16(pc + 1);
+        pc += 3;
+        high = 0;
+        for(i = 0; i < 256; i++) {
+            c = ignore_case ? lre_canonicalize(i, is_unicode) : i;
+            /* the ranges are sorted */
+            for(j = 0; j < n; j++) {
+                if (is_range32) {
+                    low = get_u32(pc + j * 8);
+                    high = get_u32(pc + j * 8 + 4);
+                } else {
+                    low = get_u16(pc + j * 4);
+                    high = get_u16(pc + j * 4 + 2);
+                }
+                if (c < low)
+                    break;
+                if (c <= high) {
+                    bitmap[i >> 3] |= 1 << (i & 7);
+                    break;
+                }
+            }
+        }
+        if (is_range32)
+            high = get_u32(pc + (n - 1) * 8 + 4);
+        else
+            high = get_u16(pc + (n - 1) * 4 + 2);
+        return ignore_case || high >= 256;
+    }
+}
+
+static void re_prescan_add_literal(uint8_t *buf, const uint16_t *lit,
+                                   int len, BOOL is_prefix)
+{
+    if (len == 0)
+        return;
+    if (is_prefix) {
+        buf[RE_PRESCAN_PREFIX_LEN] = len;
+        memcpy(buf + RE_PRESCAN_PREFIX, lit, len * sizeof(lit[0]));
+    } else if (len > buf[RE_PRESCAN_REQUIRED_LEN]) {
+        buf[RE_PRESCAN_REQUIRED_LEN] = len;
+        memcpy(buf + RE_PRESCAN_REQUIRED, lit, len * sizeof(lit[0]));
+    }
+}
+
+/* Scan the top level sequence of the regexp for a leading '^', the set
+   of possible first chars, a literal prefix and the longest literal
+   which must be present in any match. The analysis stops at the first
+   opcode with a control flow (alternative, loop, lookaround, ...).
+   Return < 0 if memory error. */
+static int re_compute_prescan(REParseState *s)
+{
+    uint8_t buf[RE_PRESCAN_LEN];
+    uint16_t lit[RE_PRESCAN_LITERAL_MAX];
+    const uint8_t *pc, *pc1;
+    int opcode, len, lit_len, flags, i;
+    BOOL first, lit_is_prefix;
+    uint32_t c;
+
+    memset(buf, 0, sizeof(buf));
+    flags = 0;
+    first = TRUE; /* no char consumed yet */
+    lit_len = 0;
+    lit_is_prefix = TRUE;
+    pc = s->byte_code.buf + RE_HEADER_LEN + RE_PRELUDE_LEN;
+    for(;;) {
+        opcode = pc[0];
+        len = reopcode_info[opcode].size;
+        pc1 = pc;
+        switch(opcode) {
+        case REOP_save_start:
+        case REOP_save_end:
+        case REOP_save_reset:
+        case REOP_line_start_m:
+        case REOP_line_end:
+        case REOP_line_end_m:
+        case REOP_word_boundary:
+        case REOP_word_boundary_i:
+        case REOP_not_word_boundary:
+        case REOP_not_word_boundary_i:
+            break;
+        case REOP_line_start:
+            if (first)
+                flags |= RE_PRESCAN_ANCHORED;
+            break;
+        case REOP_char:
+            c = get_u16(pc + 1);
+            if (is_surrogate(c))
+                goto first_char;
+            if (first) {
+                if (re_prescan_first_char(buf + RE_PRESCAN_BITMAP, pc,
+                                          s->is_unicode))
+                    flags |= RE_PRESCAN_FIRST_HIGH;
+                flags |= RE_PRESCAN_FIRST_CHAR;
+                first = FALSE;
+            }
+            if (lit_len < RE_PRESCAN_LITERAL_MAX)
+                lit[lit_len++] = c;
+            break;
+        case REOP_range:
+        case REOP_range_i:
+            len += get_u16(pc + 1) * 4;
+            goto first_char;
+        case REOP_range32:
+        case REOP_range32_i:
+            len += get_u16(pc + 1) * 8;
+            goto first_char;
+        case REOP_simple_greedy_quant:
+            /* the quantified atom gives the first char if it is a
+               single char class and the minimum count is not zero */
+            pc1 = pc + len;
+            len += get_u32(pc + 1);
+            if (get_u32(pc + 5) == 0)
+                goto no_literal;
+            switch(pc1[0]) {
+            case REOP_char:
+            case REOP_char_i:
+            case REOP_char32:
+            case REOP_char32_i:
+            case REOP_range:
+            case REOP_range_i:
+            case REOP_range32:
+            case REOP_range32_i:
+                goto first_char;
+            default:
+                goto no_literal;
+            }
+        case REOP_char_i:
+        case REOP_char32:
+        case REOP_char32_i:
+        first_char:
+            if (first) {
+                if (re_prescan_first_char(buf + RE_PRESCAN_BITMAP, pc1,
+                                          s->is_unicode))
+                    flags |= RE_PRESCAN_FIRST_HIGH;
+                flags |= RE_PRESCAN_FIRST_CHAR;
+            }
+            goto no_literal;
+        case REOP_dot:
+        case REOP_any:
+        no_literal:
+            first = FALSE;
+            re_prescan_add_literal(buf, lit, lit_len, lit_is_prefix);
+            lit_len = 0;
+            lit_is_prefix = FALSE;
+            break;
+        default:
+            goto done;
+        }
+        pc += len;
+    }
+ done:
+    re_prescan_add_literal(buf, lit, lit_len, lit_is_prefix);
+
+    if (flags & RE_PRESCAN_FIRST_HIGH) {
+        /* useless if any char can start a match */
+        for(i = 0; i < 32; i++) {
+            if (buf[RE_PRESCAN_BITMAP + i] != 0xff)
+                break;
+        }
+        if (i == 32)
+            flags &= ~(RE_PRESCAN_FIRST_CHAR | RE_PRESCAN_FIRST_HIGH);
+    }
+    if (!(flags & (RE_PRESCAN_ANCHORED | RE_PRESCAN_FIRST_CHAR)) &&
+        buf[RE_PRESCAN_PREFIX_LEN] == 0 && buf[RE_PRESCAN_REQUIRED_LEN] == 0)
+        return 0;
+    buf[RE_PRESCAN_FLAGS] = flags;
+    if (dbuf_put(&s->byte_code, buf, sizeof(buf)))
+        return -1;
+    put_u16(s->byte_code.buf + RE_HEADER_FLAGS,
+            lre_get_flags(s->byte_code.buf) | LRE_FLAG_PRESCAN);
+    return 0;
+}
+
 /* 'buf' must be a zero terminated UTF-8 string of length buf_len.
    Return NULL if error and allocate an error message in *perror_msg,
    otherwise the compiled bytecode and its length in plen.
@@ -2514,6 +2737,11 @@ uint8_t *lre_compile(int *plen, char *error_msg, int error_msg_size,
     put_u32(s->byte_code.buf + RE_HEADER_BYTECODE_LEN,
             s->byte_code.size - RE_HEADER_LEN);
 
+    if (!is_sticky && re_compute_prescan(s) < 0) {
+        re_parse_out_of_memory(s);
+        goto error;
+    }
+
     /* add the named groups if needed */
     if (s->group_names.size > (s->capture_count - 1)) {
         dbuf_put(&s->byte_code, s->group_names.buf, s->group_names.size);
@@ -3142,6 +3370,159 @@ static intptr_t lre_exec_backtrack(REExecContext *s, uint8_t **capture,
     }
 }
 
+typedef struct {
+    int len;
+    BOOL is_wide; /* contains chars >= 256 */
+    uint8_t buf8[RE_PRESCAN_LITERAL_MAX];
+    uint16_t buf16[RE_PRESCAN_LITERAL_MAX];
+} RELiteral;
+
+static void re_get_literal(RELiteral *lit, const uint8_t *buf, int len)
+{
+    int i;
+
+    lit->len = len;
+    lit->is_wide = FALSE;
+    memcpy(lit->buf16, buf, len * sizeof(lit->buf16[0]));
+    for(i = 0; i < len; i++) {
+        if (lit->buf16[i] >= 256)
+            lit->is_wide = TRUE;
+        lit->buf8[i] = lit->buf16[i];
+    }
+}
+
+/* Return the position of the first occurrence of 'lit' at or after
+   'cptr' or NULL if none. */
+static const uint8_t *re_find_literal(REExecContext *s, const uint8_t *cptr,
+                                      const RELiteral *lit)
+{
+    size_t n;
+
+    n = s->cbuf_end - cptr;
+    if (s->cbuf_type != 0)
+        n >>= 1;
+    if (n < lit->len)
+        return NULL;
+    n -= lit->len - 1; /* number of possible positions */
+    if (s->cbuf_type == 0) {
+        const uint8_t *p, *p_end;
+
+        if (lit->is_wide)
+            return NULL;
+        p = cptr;
+        p_end = cptr + n;
+        /* memchr() is vectorized by the C library */
+        while (p < p_end) {
+            p = memchr(p, lit->buf8[0], p_end - p);
+            if (!p)
+                return NULL;
+            if (!memcmp(p + 1, lit->buf8 + 1, lit->len - 1))
+                return p;
+            p++;
+        }
+    } else {
+        const uint16_t *p, *p_end;
+        uint16_t c0;
+
+        p = (const uint16_t *)cptr;
+        p_end = p + n;
+        c0 = lit->buf16[0];
+        for(; p < p_end; p++) {
+            if (*p == c0 &&
+                !memcmp(p + 1, lit->buf16 + 1,
+                        (lit->len - 1) * sizeof(lit->buf16[0])))
+                return (const uint8_t *)p;
+        }
+    }
+    return NULL;
+}
+
+/* Return the first position at or after 'cptr' whose char may start a
+   match or NULL if none. */
+static const uint8_t *re_find_first_char(REExecContext *s, const uint8_t *cptr,
+                                         const uint8_t *bitmap, BOOL high)
+{
+    uint32_t c;
+
+    if (s->cbuf_type == 0) {
+        const uint8_t *p;
+        for(p = cptr; p < s->cbuf_end; p++) {
+            c = *p;
+            if (bitmap[c >> 3] & (1 << (c & 7)))
+                return p;
+        }
+    } else {
+        const uint16_t *p, *p_end;
+        p_end = (const uint16_t *)s->cbuf_end;
+        /* a surrogate pair is >= 256 so its low surrogate is never
+           returned when the high surrogate is skipped */
+        for(p = (const uint16_t *)cptr; p < p_end; p++) {
+            c = *p;
+            if (c < 256) {
+                if (bitmap[c >> 3] & (1 << (c & 7)))
+                    return (const uint8_t *)p;
+            } else if (high) {
+                return (const uint8_t *)p;
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Same as executing the 'split_goto_first, any, goto' loop of the
+   regexp, but the positions which cannot start a match are skipped
+   using the prescan data. */
+static intptr_t lre_exec_prescan(REExecContext *s, uint8_t **capture,
+                                 StackInt *stack_buf, const uint8_t *bc_buf,
+                                 const uint8_t *cptr)
+{
+    const uint8_t *prescan, *pc;
+    RELiteral prefix, required;
+    int flags, i;
+    intptr_t ret;
+    uint32_t c;
+
+    prescan = bc_buf + RE_HEADER_LEN +
+        get_u32(bc_buf + RE_HEADER_BYTECODE_LEN);
+    flags = prescan[RE_PRESCAN_FLAGS];
+    pc = bc_buf + RE_HEADER_LEN + RE_PRELUDE_LEN;
+    if (flags & RE_PRESCAN_ANCHORED) {
+        if (cptr != s->cbuf)
+            return 0;
+        return lre_exec_backtrack(s, capture, stack_buf, 0, pc, cptr, FALSE);
+    }
+    if (prescan[RE_PRESCAN_REQUIRED_LEN] != 0) {
+        re_get_literal(&required, prescan + RE_PRESCAN_REQUIRED,
+                       prescan[RE_PRESCAN_REQUIRED_LEN]);
+        if (!re_find_literal(s, cptr, &required))
+            return 0;
+    }
+    re_get_literal(&prefix, prescan + RE_PRESCAN_PREFIX,
+                   prescan[RE_PRESCAN_PREFIX_LEN]);
+    for(;;) {
+        if (prefix.len != 0) {
+            cptr = re_find_literal(s, cptr, &prefix);
+            if (!cptr)
+                return 0;
+        } else if (flags & RE_PRESCAN_FIRST_CHAR) {
+            cptr = re_find_first_char(s, cptr, prescan + RE_PRESCAN_BITMAP,
+                                      (flags & RE_PRESCAN_FIRST_HIGH) != 0);
+            if (!cptr)
+                return 0;
+        }
+        ret = lre_exec_backtrack(s, capture, stack_buf, 0, pc, cptr, FALSE);
+        if (ret != 0)
+            return ret;
+        if (cptr >= s->cbuf_end)
+            return 0;
+        GET_CHAR(c, cptr, s->cbuf_end, s->cbuf_type);
+        for(i = 0; i < s->capture_count * 2; i++)
+            capture[i] = NULL;
+        if (lre_poll_timeout(s))
+            return LRE_RET_TIMEOUT;
+    }
+}
+
 /* Return 1 if match, 0 if not match or < 0 if error (see LRE_RET_x). cindex is the
    starting position of the match and must be such as 0 <= cindex <=
    clen. */
@@ -3176,8 +3557,13 @@ int lre_exec(uint8_t **capture,
         capture[i] = NULL;
     alloca_size = s->stack_size_max * sizeof(stack_buf[0]);
     stack_buf = alloca(alloca_size);
-    ret = lre_exec_backtrack(s, capture, stack_buf, 0, bc_buf + RE_HEADER_LEN,
-                             cbuf + (cindex << cbuf_type), FALSE);
+    if (re_flags & LRE_FLAG_PRESCAN) {
+        ret = lre_exec_prescan(s, capture, stack_buf, bc_buf,
+                               cbuf + (cindex << cbuf_type));
+    } else {
+        ret = lre_exec_backtrack(s, capture, stack_buf, 0, bc_buf + RE_HEADER_LEN,
+                                 cbuf + (cindex << cbuf_type), FALSE);
+    }
     lre_realloc(s->opaque, s->state_stack, 0);
     return ret;
 }
@@ -3200,6 +3586,8 @@ const char *lre_get_groupnames(const uint8_t *bc_buf)
     if ((lre_get_flags(bc_buf) & LRE_FLAG_NAMED_GROUPS) == 0)
         return NULL;
     re_bytecode_len = get_u32(bc_buf + RE_HEADER_BYTECODE_LEN);
+    if (lre_get_flags(bc_buf) & LRE_FLAG_PRESCAN)
+        re_bytecode_len += RE_PRESCAN_LEN;
     return (const char *)(bc_buf + RE_HEADER_LEN + re_bytecode_len);
 }
 
@@ -105,13 +105,18 @@ typedef struct {
   JSValue func;
 } JSOSTimer;
 
-typedef struct {
-  struct list_head link;
+typedef struct JSWorkerMessage {
+#ifdef USE_WORKER
+  _Atomic(struct JSWorkerMessage*) next;
+#endif
   uint8_t* data;
   size_t data_len;
   /* list of SharedArrayBuffers, necessary to free the message */
   uint8_t** sab_tab;
   size_t sab_tab_len;
+  /* contents of the transferred ArrayBuffers */
+  uint8_t** transfer_tab;
+  int transfer_len;
 } JSWorkerMessage;
 
 typedef struct JSWaker {
@@ -126,9 +131,16 @@ typedef struct JSWaker {
 typedef struct {
   int ref_count;
 #ifdef USE_WORKER
-  pthread_mutex_t mutex;
+  /* lock-free multi-producer single-consumer queue: the senders append
+     at 'head' and the receiving thread removes at 'tail'. 'stub' is a
+     dummy message so that the queue is never empty. */
+  _Atomic(JSWorkerMessage*) head;
+  JSWorkerMessage* tail;
+  JSWorkerMessage stub;
+  /* number of queued messages: the waker is only signaled when the
+     queue becomes non empty */
+  atomic_int pending;
 #endif
-  struct list_head msg_queue; /* list of JSWorkerMessage.link */
   JSWaker waker;
 } JSWorkerMessagePipe;
 
@@ -872,6 +884,26 @@ js_std_gc(JSContext* ctx, JSValueConst this_val, int argc, JSValueConst* argv) {
   return JS_UNDEFINED;
 }
 
+static JSValue js_std_gcStep(
+    JSContext* ctx,
+    JSValueConst this_val,
+    int argc,
+    JSValueConst* argv) {
+  int64_t budget_us;
+  if (JS_ToInt64Ext(ctx, &budget_us, argv[0]))
+    return JS_EXCEPTION;
+  return JS_NewBool(ctx, JS_RunGCStep(JS_GetRuntime(ctx), budget_us));
+}
+
+static JSValue js_std_setGCGenerational(
+    JSContext* ctx,
+    JSValueConst this_val,
+    int argc,
+    JSValueConst* argv) {
+  JS_SetGCGenerational(JS_GetRuntime(ctx), JS_ToBool(ctx, argv[0]));
+  return JS_UNDEFINED;
+}
+
 static int interrupt_handler(JSRuntime* rt, void* opaque) {
   return (os_pending_signals >> SIGINT) & 1;
 }
@@ -1713,6 +1745,8 @@ static const JSCFunctionListEntry js_std_error_props[] = {
 static const JSCFunctionListEntry js_std_funcs[] = {
     JS_CFUNC_DEF("exit", 1, js_std_exit),
     JS_CFUNC_DEF("gc", 0, js_std_gc),
+    JS_CFUNC_DEF("gcStep", 1, js_std_gcStep),
+    JS_CFUNC_DEF("setGCGenerational", 1, js_std_setGCGenerational),
     JS_CFUNC_DEF("evalScript", 1, js_evalScript),
     JS_CFUNC_DEF("loadScript", 1, js_loadScript),
     JS_CFUNC_DEF("getenv", 1, js_std_getenv),
@@ -2435,6 +2469,79 @@ static void js_waker_close(JSWaker* w) {
 
 #endif // _WIN32
 
+static void js_message_queue_init(JSWorkerMessagePipe* ps) {
+  atomic_init(&ps->stub.next, NULL);
+  atomic_init(&ps->head, &ps->stub);
+  ps->tail = &ps->stub;
+  atomic_init(&ps->pending, 0);
+}
+
+/* can be called from any thread */
+static void js_message_queue_push(
+    JSWorkerMessagePipe* ps,
+    JSWorkerMessage* msg) {
+  JSWorkerMessage* prev;
+
+  atomic_store_explicit(&msg->next, NULL, memory_order_relaxed);
+  prev = atomic_exchange_explicit(&ps->head, msg, memory_order_acq_rel);
+  /* the message is not visible to the receiver before this store */
+  atomic_store_explicit(&prev->next, msg, memory_order_release);
+}
+
+/* only called by the receiving thread. Return NULL if the queue is
+   empty or if a sender has not finished js_message_queue_push() */
+static JSWorkerMessage* js_message_queue_pop(JSWorkerMessagePipe* ps) {
+  JSWorkerMessage *tail = ps->tail, *next;
+
+  next = atomic_load_explicit(&tail->next, memory_order_acquire);
+  if (tail == &ps->stub) {
+    if (!next)
+      return NULL;
+    ps->tail = next;
+    tail = next;
+    next = atomic_load_explicit(&next->next, memory_order_acquire);
+  }
+  if (next) {
+    ps->tail = next;
+    return tail;
+  }
+  if (tail != atomic_load_explicit(&ps->head, memory_order_acquire))
+    return NULL;
+  /* 'tail' is the last message: put the stub behind it */
+  js_message_queue_push(ps, &ps->stub);
+  next = atomic_load_explicit(&tail->next, memory_order_acquire);
+  if (next) {
+    ps->tail = next;
+    return tail;
+  }
+  return NULL;
+}
+
+static void js_post_message(JSWorkerMessagePipe* ps, JSWorkerMessage* msg) {
+  js_message_queue_push(ps, msg);
+  /* indicate that data is present */
+  if (atomic_fetch_add(&ps->pending, 1) == 0)
+    js_waker_signal(&ps->waker);
+}
+
+static JSWorkerMessage* js_receive_message(JSWorkerMessagePipe* ps) {
+  JSWorkerMessage* msg;
+
+  msg = js_message_queue_pop(ps);
+  if (!msg)
+    return NULL;
+  if (atomic_load(&ps->pending) == 1) {
+    /* clear the waker before the count reaches zero so that the
+       signal of a concurrent sender is not lost */
+    js_waker_clear(&ps->waker);
+    if (atomic_fetch_sub(&ps->pending, 1) != 1)
+      js_waker_signal(&ps->waker);
+  } else {
+    atomic_fetch_sub(&ps->pending, 1);
+  }
+  return msg;
+}
+
 static void js_free_message(JSWorkerMessage* msg);
 
 /* return 1 if a message was handled, 0 if no message */
@@ -2443,56 +2550,45 @@ static int handle_posted_message(
     JSContext* ctx,
     JSWorkerMessageHandler* port) {
   JSWorkerMessagePipe* ps = port->recv_pipe;
-  int ret;
-  struct list_head* el;
   JSWorkerMessage* msg;
   JSValue obj, data_obj, func, retval;
 
-  pthread_mutex_lock(&ps->mutex);
-  if (!list_empty(&ps->msg_queue)) {
-    el = ps->msg_queue.next;
-    msg = list_entry(el, JSWorkerMessage, link);
-
-    /* remove the message from the queue */
-    list_del(&msg->link);
-
-    if (list_empty(&ps->msg_queue))
-      js_waker_clear(&ps->waker);
-
-    pthread_mutex_unlock(&ps->mutex);
+  msg = js_receive_message(ps);
+  if (!msg)
+    return 0;
 
-    data_obj = JS_ReadObject(
-        ctx, msg->data, msg->data_len, JS_READ_OBJ_SAB | JS_READ_OBJ_REFERENCE);
+  data_obj = JS_ReadObjectTransfer(
+      ctx,
+      msg->data,
+      msg->data_len,
+      JS_READ_OBJ_SAB | JS_READ_OBJ_REFERENCE,
+      msg->transfer_tab,
+      msg->transfer_len);
 
-    js_free_message(msg);
+  js_free_message(msg);
 
-    if (JS_IsException(data_obj))
-      goto fail;
-    obj = JS_NewObject(ctx);
-    if (JS_IsException(obj)) {
-      JS_FreeValue(ctx, data_obj);
-      goto fail;
-    }
-    JS_DefinePropertyValueStr(ctx, obj, "data", data_obj, JS_PROP_C_W_E);
+  if (JS_IsException(data_obj))
+    goto fail;
+  obj = JS_NewObject(ctx);
+  if (JS_IsException(obj)) {
+    JS_FreeValue(ctx, data_obj);
+    goto fail;
+  }
+  JS_DefinePropertyValueStr(ctx, obj, "data", data_obj, JS_PROP_C_W_E);
 
-    /* 'func' might be destroyed when calling itself (if it frees the
-       handler), so must take extra care */
-    func = JS_DupValue(ctx, port->on_message_func);
-    retval = JS_Call(ctx, func, JS_UNDEFINED, 1, (JSValueConst*)&obj);
-    JS_FreeValue(ctx, obj);
-    JS_FreeValue(ctx, func);
-    if (JS_IsException(retval)) {
-    fail:
-      js_std_dump_error(ctx);
-    } else {
-      JS_FreeValue(ctx, retval);
-    }
-    ret = 1;
+  /* 'func' might be destroyed when calling itself (if it frees the
+     handler), so must take extra care */
+  func = JS_DupValue(ctx, port->on_message_func);
+  retval = JS_Call(ctx, func, JS_UNDEFINED, 1, (JSValueConst*)&obj);
+  JS_FreeValue(ctx, obj);
+  JS_FreeValue(ctx, func);
+  if (JS_IsException(retval)) {
+  fail:
+    js_std_dump_error(ctx);
   } else {
-    pthread_mutex_unlock(&ps->mutex);
-    ret = 0;
+    JS_FreeValue(ctx, retval);
   }
-  return ret;
+  return 1;
 }
 #else
 static int handle_posted_message(
@@ -3615,8 +3711,7 @@ static JSWorkerMessagePipe* js_new_message_pipe(void) {
     return NULL;
   }
   ps->ref_count = 1;
-  init_list_head(&ps->msg_queue);
-  pthread_mutex_init(&ps->mutex, NULL);
+  js_message_queue_init(ps);
   return ps;
 }
 
@@ -3632,12 +3727,15 @@ static void js_free_message(JSWorkerMessage* msg) {
     js_sab_free(NULL, msg->sab_tab[i]);
   }
   free(msg->sab_tab);
+  if (msg->transfer_tab) {
+    JS_FreeTransferTab(msg->transfer_tab, msg->transfer_len);
+    free(msg->transfer_tab);
+  }
   free(msg->data);
   free(msg);
 }
 
 static void js_free_message_pipe(JSWorkerMessagePipe* ps) {
-  struct list_head *el, *el1;
   JSWorkerMessage* msg;
   int ref_count;
 
@@ -3647,11 +3745,9 @@ static void js_free_message_pipe(JSWorkerMessagePipe* ps) {
   ref_count = atomic_add_int(&ps->ref_count, -1);
   assert(ref_count >= 0);
   if (ref_count == 0) {
-    list_for_each_safe(el, el1, &ps->msg_queue) {
-      msg = list_entry(el, JSWorkerMessage, link);
+    /* no sender is left */
+    while ((msg = js_message_queue_pop(ps)) != NULL)
       js_free_message(msg);
-    }
-    pthread_mutex_destroy(&ps->mutex);
     js_waker_close(&ps->waker);
     free(ps);
   }
@@ -3851,28 +3947,81 @@ fail:
   return JS_EXCEPTION;
 }
 
+/* 'transfer' argument of postMessage(): array of ArrayBuffers */
+static JSValue* js_get_transfer_list(
+    JSContext* ctx,
+    uint32_t* plen,
+    JSValueConst obj) {
+  JSValue val, *tab;
+  uint32_t len, i;
+  int ret;
+
+  val = JS_GetPropertyStr(ctx, obj, "length");
+  if (JS_IsException(val))
+    return NULL;
+  ret = JS_ToUint32(ctx, &len, val);
+  JS_FreeValue(ctx, val);
+  if (ret)
+    return NULL;
+  /* arbitrary limit to avoid overflow */
+  if (len > 65535) {
+    JS_ThrowRangeError(ctx, "too many transferred objects");
+    return NULL;
+  }
+  tab = js_mallocz(ctx, sizeof(tab[0]) * max_int(len, 1));
+  if (!tab)
+    return NULL;
+  for (i = 0; i < len; i++) {
+    tab[i] = JS_GetPropertyUint32(ctx, obj, i);
+    if (JS_IsException(tab[i])) {
+      while (i-- > 0)
+        JS_FreeValue(ctx, tab[i]);
+      js_free(ctx, tab);
+      return NULL;
+    }
+  }
+  *plen = len;
+  return tab;
+}
+
 static JSValue js_worker_postMessage(
     JSContext* ctx,
     JSValueConst this_val,
     int argc,
     JSValueConst* argv) {
   JSWorkerData* worker = JS_GetOpaque2(ctx, this_val, js_worker_class_id);
-  JSWorkerMessagePipe* ps;
   size_t data_len, sab_tab_len, i;
   uint8_t* data;
   JSWorkerMessage* msg;
-  uint8_t** sab_tab;
+  uint8_t **sab_tab, **transfer_tab;
+  JSValue* transfer_list = NULL;
+  uint32_t transfer_len = 0;
 
   if (!worker)
     return JS_EXCEPTION;
 
-  data = JS_WriteObject2(
+  if (argc >= 2 && !JS_IsUndefined(argv[1])) {
+    transfer_list = js_get_transfer_list(ctx, &transfer_len, argv[1]);
+    if (!transfer_list)
+      return JS_EXCEPTION;
+  }
+
+  /* the transferred ArrayBuffers are detached if successful */
+  data = JS_WriteObjectTransfer(
       ctx,
       &data_len,
       argv[0],
       JS_WRITE_OBJ_SAB | JS_WRITE_OBJ_REFERENCE,
       &sab_tab,
-      &sab_tab_len);
+      &sab_tab_len,
+      transfer_list,
+      transfer_len,
+      &transfer_tab);
+  if (transfer_list) {
+    for (i = 0; i < transfer_len; i++)
+      JS_FreeValue(ctx, transfer_list[i]);
+    js_free(ctx, transfer_list);
+  }
   if (!data)
     return JS_EXCEPTION;
 
@@ -3881,6 +4030,7 @@ static JSValue js_worker_postMessage(
     goto fail;
   msg->data = NULL;
   msg->sab_tab = NULL;
+  msg->transfer_tab = NULL;
 
   /* must reallocate because the allocator may be different */
   msg->data = malloc(data_len);
@@ -3897,30 +4047,42 @@ static JSValue js_worker_postMessage(
   }
   msg->sab_tab_len = sab_tab_len;
 
+  /* the ArrayBuffer contents are moved, not copied */
+  if (transfer_len > 0) {
+    msg->transfer_tab = malloc(sizeof(msg->transfer_tab[0]) * transfer_len);
+    if (!msg->transfer_tab)
+      goto fail;
+    memcpy(
+        msg->transfer_tab,
+        transfer_tab,
+        sizeof(msg->transfer_tab[0]) * transfer_len);
+  }
+  msg->transfer_len = transfer_len;
+
   js_free(ctx, data);
   js_free(ctx, sab_tab);
+  js_free(ctx, transfer_tab);
 
   /* increment the SAB reference counts */
   for (i = 0; i < msg->sab_tab_len; i++) {
     js_sab_dup(NULL, msg->sab_tab[i]);
   }
 
-  ps = worker->send_pipe;
-  pthread_mutex_lock(&ps->mutex);
-  /* indicate that data is present */
-  if (list_empty(&ps->msg_queue))
-    js_waker_signal(&ps->waker);
-  list_add_tail(&msg->link, &ps->msg_queue);
-  pthread_mutex_unlock(&ps->mutex);
+  js_post_message(worker->send_pipe, msg);
   return JS_UNDEFINED;
 fail:
   if (msg) {
     free(msg->data);
     free(msg->sab_tab);
+    free(msg->transfer_tab);
     free(msg);
   }
   js_free(ctx, data);
   js_free(ctx, sab_tab);
+  if (transfer_tab) {
+    JS_FreeTransferTab(transfer_tab, transfer_len);
+    js_free(ctx, transfer_tab);
+  }
   return JS_EXCEPTION;
 }
 
@@ -3974,7 +4136,7 @@ static JSValue js_worker_get_onmessage(JSContext* ctx, JSValueConst this_val) {
 }
 
 static const JSCFunctionListEntry js_worker_proto_funcs[] = {
-    JS_CFUNC_DEF("postMessage", 1, js_worker_postMessage),
+    JS_CFUNC_DEF("postMessage", 2, js_worker_postMessage),
     JS_CGETSET_DEF(
         "onmessage",
         js_worker_get_onmessage,
@@ -4423,7 +4585,10 @@ void js_std_eval_binary(
     size_t buf_len,
     int load_only) {
   JSValue obj, val;
-  obj = JS_ReadObject(ctx, buf, buf_len, JS_READ_OBJ_BYTECODE);
+  /* the bytecode generated by qjsc is a static array, so the lazily
+     loaded function bodies can be decoded from it without a copy */
+  obj = JS_ReadObject2(
+      ctx, buf, buf_len, JS_READ_OBJ_BYTECODE | JS_READ_OBJ_LAZY, NULL, NULL);
   if (JS_IsException(obj))
     goto exception;
   if (load_only) {